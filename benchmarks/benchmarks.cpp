@@ -0,0 +1,23 @@
+#include <string_view>
+
+#include "lexer_benchmark.cpp"
+#include "ir_benchmark.cpp"
+#include "codegen_benchmark.cpp"
+#include "module_generator.cpp"
+#include "scaling_benchmark.cpp"
+#include "kernel_benchmark.cpp"
+
+int main(int argc, char **argv) {
+    // --update-baseline replaces the stored generated code baseline with this run's results
+    const bool update_baseline = argc > 1 && std::string_view { argv[1] } == "--update-baseline";
+
+    std::cout << "Running benchmarks...\n";
+
+    run_lexer_benchmarks();
+    run_ir_benchmarks();
+    run_codegen_benchmarks();
+    run_scaling_benchmarks();
+    run_kernel_benchmarks(update_baseline);
+
+    std::cout << "Benchmarks complete.\n";
+}
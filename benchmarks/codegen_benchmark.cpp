@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/backend/interface.hpp"
+
+// The instructions of each block of @function in order, keyed by label
+std::vector<std::pair<std::string, std::vector<std::string>>> function_blocks(const std::string &assembly,
+                                                                              std::string_view function) {
+    std::vector<std::pair<std::string, std::vector<std::string>>> blocks;
+    std::istringstream lines { assembly.substr(assembly.find(std::string(function).append(":\n"))) };
+    std::string line;
+
+    std::getline(lines, line);
+
+    while (std::getline(lines, line) && !line.starts_with("global")) {
+        if (line.starts_with('.'))
+            blocks.emplace_back(line.substr(1, line.size() - 2), std::vector<std::string> {});
+        else if (line.starts_with('\t') && !blocks.empty())
+            blocks.back().second.push_back(line.substr(1, line.find(' ') - 1));
+    }
+
+    return blocks;
+}
+
+// Instructions executed, and how many of them save or restore registers, when
+// running through @path of @function without taking any other branch
+std::pair<size_t, size_t> path_cost(const std::string &assembly, std::string_view function,
+                                    std::initializer_list<std::string_view> path) {
+    size_t instructions = 0, saves = 0;
+
+    for (const auto &[label, block] : function_blocks(assembly, function)) {
+        if (std::find(path.begin(), path.end(), label) == path.end())
+            continue;
+
+        instructions += block.size();
+        saves += std::count_if(block.begin(), block.end(), [](const std::string &inst) {
+            return inst == "push" || inst == "pop";
+        });
+    }
+
+    return { instructions, saves };
+}
+
+// Regression benchmark for the code generated for fib, a small recursive routine whose
+// base case runs on about half of all calls
+void run_codegen_benchmarks() {
+    constexpr int iterations = 1000;
+    constexpr const char *file_path = "../examples/fibonacci.ir";
+
+    double best_compile = std::numeric_limits<double>::max();
+    std::string assembly;
+
+    for (int i = 0; i < iterations; i++) {
+        std::stringstream output;
+
+        auto start = std::chrono::steady_clock::now();
+        backend::compile(file_path, output);
+        auto end = std::chrono::steady_clock::now();
+
+        best_compile = std::min(best_compile, std::chrono::duration<double>(end - start).count());
+        assembly = std::move(output).str();
+    }
+
+    const auto [base_instructions, base_saves] = path_cost(assembly, "fib", { "__stacksave", "entry", "base_case" });
+    const auto [recursive_instructions, recursive_saves] = path_cost(assembly, "fib", { "__stacksave", "entry", "recursive_case" });
+
+    std::cout << "Code generation of fibonacci.ir:\n"
+              << std::fixed << std::setprecision(1)
+              << "  compile           " << std::setw(10) << best_compile * 1e6 << " us\n"
+              << "  fib base case     " << std::setw(10) << base_instructions << " instructions, "
+              << base_saves << " saves/restores\n"
+              << "  fib recursive     " << std::setw(10) << recursive_instructions << " instructions, "
+              << recursive_saves << " saves/restores\n";
+}
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+#include "../src/backend/ir_analyzer/ir_analyzer.hpp"
+
+// Counts every heap allocation made by the benchmarks, so that the memory taken by
+// the IR can be measured without relying on the allocator's own statistics.
+namespace alloc_stats {
+    std::atomic<size_t> allocations { 0 };
+    std::atomic<size_t> live_bytes { 0 };
+}
+
+void *operator new(size_t size) {
+    // Store the size in front of the allocation so operator delete can account for it
+    auto *block = static_cast<size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+
+    if (!block)
+        throw std::bad_alloc {};
+
+    *block = size;
+
+    alloc_stats::allocations.fetch_add(1, std::memory_order_relaxed);
+    alloc_stats::live_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    return reinterpret_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void *ptr) noexcept {
+    if (!ptr)
+        return;
+
+    auto *block = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - sizeof(std::max_align_t));
+    alloc_stats::live_bytes.fetch_sub(*block, std::memory_order_relaxed);
+
+    std::free(block);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+size_t count_instructions(const ir::root &root) {
+    size_t count = 0;
+
+    for (const auto &function : root.functions)
+        for (const auto &block : function.blocks)
+            count += block.instructions.size();
+
+    return count;
+}
+
+// A pass touching every instruction and operand, standing in for analysis passes
+size_t walk_instructions(const ir::root &root) {
+    size_t checksum = 0;
+
+    for (const auto &function : root.functions) {
+        for (const auto &block : function.blocks) {
+            for (const auto &instruction : block.instructions) {
+                checksum += ir::block::node_visit(instruction, [](const auto &inst) -> size_t {
+                    return std::is_same_v<std::decay_t<decltype(inst)>, ir::block::call>;
+                });
+
+                for (const auto &operand : instruction.operands)
+                    checksum += operand.is_variable() ? operand.get_id() : 1;
+            }
+        }
+    }
+
+    return checksum;
+}
+
+void run_ir_benchmarks() {
+    constexpr size_t input_size = 16 * 1024 * 1024;
+    constexpr int iterations = 5;
+
+    const auto input = replicate_examples(input_size);
+    const auto tokens = ir::lexer::lex(input);
+
+    double best_parse = std::numeric_limits<double>::max();
+    double best_walk = std::numeric_limits<double>::max();
+    size_t allocations = 0, bytes = 0, instructions = 0, checksum = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        const size_t allocations_before = alloc_stats::allocations;
+        const size_t bytes_before = alloc_stats::live_bytes;
+
+        auto parse_start = std::chrono::steady_clock::now();
+        auto root = ir::parser::parse(tokens);
+        backend::md::analyze(root);
+        auto parse_end = std::chrono::steady_clock::now();
+
+        allocations = alloc_stats::allocations - allocations_before;
+        bytes = alloc_stats::live_bytes - bytes_before;
+        instructions = count_instructions(root);
+
+        auto walk_start = std::chrono::steady_clock::now();
+        checksum = walk_instructions(root);
+        auto walk_end = std::chrono::steady_clock::now();
+
+        best_parse = std::min(best_parse, std::chrono::duration<double>(parse_end - parse_start).count());
+        best_walk = std::min(best_walk, std::chrono::duration<double>(walk_end - walk_start).count());
+    }
+
+    std::cout << "IR representation over " << instructions << " instructions:\n"
+              << std::fixed << std::setprecision(1)
+              << "  parse + analyze   " << std::setw(10) << (double) instructions / best_parse / 1e6 << " M instructions/s\n"
+              << "  walk              " << std::setw(10) << (double) instructions / best_walk / 1e6 << " M instructions/s"
+              << "  (checksum " << checksum << ")\n"
+              << std::setprecision(2)
+              << "  allocations       " << std::setw(10) << (double) allocations / (double) instructions << " per instruction\n"
+              << "  resident IR       " << std::setw(10) << (double) bytes / (double) instructions << " bytes per instruction\n";
+}
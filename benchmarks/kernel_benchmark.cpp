@@ -0,0 +1,296 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/interface.hpp"
+#include "../src/exec/jit.hpp"
+
+namespace kernels {
+    constexpr const char *baseline_path = "../benchmarks/kernel_baseline.txt";
+
+    // Worse than the baseline by more than these fractions is reported as a regression,
+    // instructions retired barely vary between runs while ticks do by several percent
+    constexpr double instructions_threshold = 0.01;
+    constexpr double ticks_threshold = 0.15;
+
+    struct kernel {
+        const char *name;
+        const char *path;
+        int expected;
+        int runs;
+    };
+
+    constexpr kernel corpus[] = {
+        { "fib",          "../examples/kernels/fib.ir",          46368,    50 },
+        { "array_sum",    "../examples/kernels/array_sum.ir",    1571328,  2000 },
+        { "select_clamp", "../examples/kernels/select_clamp.ir", 58372391, 2000 },
+        { "call_chain",   "../examples/kernels/call_chain.ir",   1000000,  2000 },
+    };
+
+    /**
+     *  Hardware counters of the calling thread in user space, opened as one group so
+     *  that all of them count over exactly the same instructions. Where perf events
+     *  are not permitted, e.g. in containers or with a high perf_event_paranoid, none
+     *  are open and only the timestamp counter is reported.
+     */
+    class counters {
+        static constexpr std::array<uint64_t, 3> events {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        std::array<int, events.size()> descriptors;
+
+    public:
+        struct values {
+            uint64_t cycles, instructions, branch_misses;
+        };
+
+        counters() {
+            descriptors.fill(-1);
+
+            for (size_t i = 0; i < events.size(); i++) {
+                perf_event_attr attributes {};
+                attributes.type = PERF_TYPE_HARDWARE;
+                attributes.size = sizeof(attributes);
+                attributes.config = events[i];
+                attributes.disabled = i == 0;
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+                attributes.read_format = PERF_FORMAT_GROUP;
+
+                descriptors[i] = (int) syscall(SYS_perf_event_open, &attributes, 0, -1, descriptors[0], 0);
+
+                if (descriptors[i] < 0) {
+                    close_all();
+                    return;
+                }
+            }
+        }
+
+        ~counters() {
+            close_all();
+        }
+
+        counters(const counters&) = delete;
+        counters &operator=(const counters&) = delete;
+
+        [[nodiscard]] bool available() const {
+            return descriptors[0] >= 0;
+        }
+
+        void start() {
+            ioctl(descriptors[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(descriptors[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        values stop() {
+            ioctl(descriptors[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+            // The number of events followed by their values, in the order they were opened
+            std::array<uint64_t, 1 + events.size()> group {};
+
+            if (read(descriptors[0], group.data(), sizeof(group)) != (ssize_t) sizeof(group))
+                return {};
+
+            return { group[1], group[2], group[3] };
+        }
+
+    private:
+        void close_all() {
+            for (auto &descriptor : descriptors) {
+                if (descriptor >= 0)
+                    close(descriptor);
+
+                descriptor = -1;
+            }
+        }
+    };
+
+    // Per run, the counters are averaged over all runs while the ticks are the fastest one
+    struct result {
+        uint64_t ticks;
+        std::optional<counters::values> counted;
+    };
+
+    struct baseline_entry {
+        uint64_t ticks;
+        std::optional<uint64_t> instructions;
+    };
+
+    // Lines of "name ticks instructions", instructions being "-" when they weren't counted
+    std::map<std::string, baseline_entry> read_baseline() {
+        std::map<std::string, baseline_entry> baseline;
+        std::ifstream input { baseline_path };
+        std::string line;
+
+        while (std::getline(input, line)) {
+            if (line.empty() || line.starts_with('#'))
+                continue;
+
+            std::istringstream fields { line };
+            std::string name, instructions;
+            baseline_entry entry {};
+
+            if (!(fields >> name >> entry.ticks >> instructions))
+                continue;
+
+            if (instructions != "-")
+                entry.instructions = std::stoull(instructions);
+
+            baseline[name] = entry;
+        }
+
+        return baseline;
+    }
+
+    void write_baseline(const std::map<std::string, result> &results) {
+        std::ofstream output { baseline_path };
+        // Ticks only compare on the machine they were measured on, instructions on any running the same code
+        output << "# kernel, fastest run in timestamp counter ticks, instructions retired per run\n"
+               << "# regenerate with: benchmarks --update-baseline\n";
+
+        for (const auto &[name, measured] : results) {
+            output << name << ' ' << measured.ticks << ' ';
+
+            if (measured.counted)
+                output << measured.counted->instructions;
+            else
+                output << '-';
+
+            output << '\n';
+        }
+    }
+
+    /**
+     *  Compiles the kernel into the jit and calls its main @kernel.runs times after a
+     *  warm up call, which also checks the result so that a fast but wrong code
+     *  generator never passes for an improvement.
+     */
+    result measure(const kernel &kernel, counters &hardware) {
+        auto root = backend::gen_ast(kernel.path);
+        const exec::jit_module module { backend::assemble(root, { .optimization = backend::opt_level::O2 }) };
+        auto *main = module.function<int()>("main");
+
+        if (!main)
+            throw std::runtime_error(std::string(kernel.path).append(" has no main function"));
+
+        if (const auto returned = main(); returned != kernel.expected) {
+            throw std::runtime_error(std::string(kernel.name).append(" returned ").append(std::to_string(returned))
+                                     .append(" instead of ").append(std::to_string(kernel.expected)));
+        }
+
+        result measured { std::numeric_limits<uint64_t>::max(), std::nullopt };
+
+        for (int i = 0; i < kernel.runs; i++) {
+            // The fences keep the call from being reordered around the reads of the counter
+            _mm_lfence();
+            const auto start = __rdtsc();
+            _mm_lfence();
+
+            main();
+
+            _mm_lfence();
+            const auto end = __rdtsc();
+
+            measured.ticks = std::min<uint64_t>(measured.ticks, end - start);
+        }
+
+        if (hardware.available()) {
+            hardware.start();
+
+            for (int i = 0; i < kernel.runs; i++)
+                main();
+
+            auto totals = hardware.stop();
+            measured.counted = counters::values {
+                totals.cycles / kernel.runs, totals.instructions / kernel.runs, totals.branch_misses / kernel.runs
+            };
+        }
+
+        return measured;
+    }
+
+    /**
+     *  The change from the baseline, compared on instructions retired when both have
+     *  them since those don't vary with the machine or its load, on ticks otherwise.
+     */
+    void print_comparison(const result &measured, const std::optional<baseline_entry> &baseline) {
+        if (!baseline) {
+            std::cout << std::setw(12) << "new" << '\n';
+            return;
+        }
+
+        const bool by_instructions = measured.counted && baseline->instructions;
+        const auto current = by_instructions ? measured.counted->instructions : measured.ticks;
+        const auto previous = by_instructions ? *baseline->instructions : baseline->ticks;
+
+        const auto change = ((double) current - (double) previous) / (double) previous;
+
+        std::cout << std::setw(10) << std::showpos << change * 100 << std::noshowpos << "% "
+                  << (by_instructions ? "instructions" : "ticks");
+
+        if (change > (by_instructions ? instructions_threshold : ticks_threshold))
+            std::cout << "  REGRESSION";
+
+        std::cout << '\n';
+    }
+}
+
+// Speed of the code generated for a corpus of small compute kernels, each run in the jit
+// and compared against the stored baseline. With @update_baseline, the baseline is
+// replaced by this run's results instead.
+void run_kernel_benchmarks(bool update_baseline) {
+    kernels::counters hardware;
+
+    if (!hardware.available())
+        std::cout << "Hardware counters are unavailable, only reporting timestamp counter ticks\n";
+
+    const auto baseline = kernels::read_baseline();
+    std::map<std::string, kernels::result> results;
+
+    std::cout << "Generated code, per run of main:\n"
+              << "  " << std::left << std::setw(14) << "kernel" << std::right
+              << std::setw(12) << "ticks" << std::setw(12) << "cycles" << std::setw(14) << "instructions"
+              << std::setw(14) << "branch misses" << std::setw(24) << "vs baseline" << '\n';
+
+    for (const auto &kernel : kernels::corpus) {
+        const auto measured = kernels::measure(kernel, hardware);
+        results[kernel.name] = measured;
+
+        std::cout << "  " << std::left << std::setw(14) << kernel.name << std::right
+                  << std::setw(12) << measured.ticks;
+
+        if (measured.counted) {
+            std::cout << std::setw(12) << measured.counted->cycles << std::setw(14) << measured.counted->instructions
+                      << std::setw(14) << measured.counted->branch_misses;
+        } else {
+            std::cout << std::setw(12) << "-" << std::setw(14) << "-" << std::setw(14) << "-";
+        }
+
+        const auto found = baseline.find(kernel.name);
+
+        std::cout << std::fixed << std::setprecision(1);
+        kernels::print_comparison(measured, found == baseline.end()
+            ? std::nullopt
+            : std::optional<kernels::baseline_entry> { found->second });
+    }
+
+    if (update_baseline) {
+        kernels::write_baseline(results);
+        std::cout << "Baseline written to " << kernels::baseline_path << '\n';
+    }
+}
@@ -0,0 +1,124 @@
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "../src/ir/input/lexer.hpp"
+
+std::string replicate_examples(size_t target_size) {
+    constexpr const char* example_files[] = {
+        "../examples/arith_select_test.ir",
+        "../examples/cast_test.ir",
+        "../examples/fibonacci.ir",
+        "../examples/hello_world.ir",
+        "../examples/phi_test.ir",
+        "../examples/pointer_test.ir",
+        "../examples/select_test.ir",
+        "../examples/optimizer/dead_code_elim.ir",
+    };
+
+    std::string corpus;
+
+    for (const auto *file_path : example_files) {
+        std::ifstream file { file_path };
+
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file " << file_path << '\n';
+            exit(1);
+        }
+
+        corpus.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        corpus.push_back('\n');
+    }
+
+    std::string input;
+    input.reserve(target_size + corpus.size());
+
+    while (input.size() < target_size)
+        input.append(corpus);
+
+    return input;
+}
+
+double benchmark_lex(std::string_view input, ir::lexer::simd::isa isa, size_t &token_count) {
+    constexpr int iterations = 5;
+
+    double best_seconds = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < iterations; i++) {
+        ir::lexer::identifier_table identifiers;
+
+        auto start = std::chrono::steady_clock::now();
+        auto tokens = ir::lexer::lex(input, identifiers, isa);
+        auto end = std::chrono::steady_clock::now();
+
+        token_count = tokens.size();
+        best_seconds = std::min(best_seconds, std::chrono::duration<double>(end - start).count());
+    }
+
+    return (double) input.size() / (1024.0 * 1024.0) / best_seconds;
+}
+
+double benchmark_classify(std::string_view input, ir::lexer::simd::isa isa, uint64_t &word_bytes) {
+    constexpr int iterations = 5;
+
+    const auto classify = ir::lexer::simd::classifier(isa);
+    const size_t blocks = input.size() / ir::lexer::simd::block_size;
+
+    double best_seconds = std::numeric_limits<double>::max();
+
+    for (int i = 0; i < iterations; i++) {
+        word_bytes = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (size_t block = 0; block < blocks; block++) {
+            const auto masks = classify(input.data() + block * ir::lexer::simd::block_size);
+            word_bytes += std::popcount(masks.word);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        best_seconds = std::min(best_seconds, std::chrono::duration<double>(end - start).count());
+    }
+
+    return (double) (blocks * ir::lexer::simd::block_size) / (1024.0 * 1024.0) / best_seconds;
+}
+
+void run_lexer_benchmarks() {
+    constexpr size_t input_size = 64 * 1024 * 1024;
+
+    const auto input = replicate_examples(input_size);
+
+    std::cout << "Lexer throughput over " << input.size() / (1024 * 1024) << " MB of replicated examples:\n";
+
+    for (auto isa : { ir::lexer::simd::isa::scalar, ir::lexer::simd::isa::sse2, ir::lexer::simd::isa::avx2 }) {
+        if (!ir::lexer::simd::isa_supported(isa))
+            continue;
+
+        size_t token_count = 0;
+        const auto throughput = benchmark_lex(input, isa, token_count);
+
+        std::cout << "  " << std::left << std::setw(8) << ir::lexer::simd::isa_name(isa)
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(10) << throughput << " MB/s"
+                  << "  (" << token_count << " tokens)\n";
+    }
+
+    std::cout << "Character classification alone:\n";
+
+    for (auto isa : { ir::lexer::simd::isa::scalar, ir::lexer::simd::isa::sse2, ir::lexer::simd::isa::avx2 }) {
+        if (!ir::lexer::simd::isa_supported(isa))
+            continue;
+
+        uint64_t word_bytes = 0;
+        const auto throughput = benchmark_classify(input, isa, word_bytes);
+
+        std::cout << "  " << std::left << std::setw(8) << ir::lexer::simd::isa_name(isa)
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(10) << throughput << " MB/s"
+                  << "  (" << word_bytes << " identifier bytes)\n";
+    }
+}
@@ -0,0 +1,155 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// The shape of a generated module, every function has the same number of blocks
+// and instructions
+struct module_shape {
+    size_t functions = 100;
+    size_t blocks = 8;
+
+    // Instructions in each block, including its compare and terminator
+    size_t instructions = 16;
+
+    // Chance of a block starting with a phi of its two predecessors' values
+    double phi_density = 0.25;
+
+    // Chance of an instruction calling one of the functions defined before it
+    double call_density = 0.05;
+
+    uint32_t seed = 1;
+};
+
+struct generated_module {
+    std::string text;
+    size_t instructions = 0;
+};
+
+/**
+ *  Generates an IR module of the given @shape in the text format, so that it goes
+ *  through the lexer and parser like a real input. Every block but the last branches
+ *  to the next two, so each block from the third on joins two predecessors and all
+ *  of a function's values stay live across a long chain of blocks.
+ */
+generated_module generate_module(const module_shape &shape) {
+    std::mt19937 random { shape.seed };
+    std::uniform_real_distribution<double> chance { 0.0, 1.0 };
+
+    const auto pick = [&](size_t count) {
+        return std::uniform_int_distribution<size_t> { 0, count - 1 }(random);
+    };
+
+    constexpr const char *operations[] = { "add", "sub", "mul" };
+    const size_t operations_per_block = shape.instructions > 2 ? shape.instructions - 2 : 1;
+
+    generated_module module;
+    auto &text = module.text;
+
+    // Roughly what a line takes, to avoid regrowing the module as it is written
+    text.reserve(shape.functions * shape.blocks * shape.instructions * 32);
+
+    for (size_t function = 0; function < shape.functions; function++) {
+        text.append("define fn i32 f").append(std::to_string(function)).append("(i32 %a, i32 %b)\n");
+
+        // Entry block values dominate every other block, anything else is only used
+        // in the block defining it or by a successor's phi
+        std::vector<std::string> entry_values { "%a", "%b" };
+        std::vector<std::string> last_values;
+        size_t next_value = 1;
+
+        const auto label = [](size_t block) {
+            return block == 0 ? std::string("entry") : std::string("b").append(std::to_string(block));
+        };
+
+        const auto new_value = [&]() {
+            return std::string("%").append(std::to_string(next_value++));
+        };
+
+        for (size_t block = 0; block < shape.blocks; block++) {
+            std::vector<std::string> local_values;
+
+            const auto variable = [&]() {
+                if (!local_values.empty() && chance(random) < 0.5)
+                    return local_values[pick(local_values.size())];
+
+                return entry_values[pick(entry_values.size())];
+            };
+
+            // Literals only ever come second, like in the output of a front end folding constants
+            const auto operand = [&]() {
+                if (chance(random) < 0.25)
+                    return std::to_string(pick(100));
+
+                return variable();
+            };
+
+            if (block != 0)
+                text.append(".").append(label(block)).append(":\n");
+
+            if (block >= 2 && chance(random) < shape.phi_density) {
+                auto value = new_value();
+
+                text.append("    ").append(value).append(" = phi ")
+                    .append(label(block - 2)).append(" ").append(label(block - 1))
+                    .append(" i32 ").append(last_values[block - 2])
+                    .append(", i32 ").append(last_values[block - 1]).append("\n");
+
+                local_values.emplace_back(std::move(value));
+                module.instructions++;
+            }
+
+            for (size_t i = 0; i < operations_per_block; i++) {
+                auto value = new_value();
+
+                text.append("    ").append(value).append(" = ");
+
+                if (function != 0 && chance(random) < shape.call_density) {
+                    // Only earlier functions are called, so that calls never recurse
+                    const auto callee = function - 1 - pick(std::min<size_t>(function, 16));
+                    const auto first = operand();
+
+                    text.append("call i32 f").append(std::to_string(callee))
+                        .append(" i32 ").append(first).append(", i32 ").append(operand()).append("\n");
+                } else {
+                    const auto first = variable();
+
+                    text.append(operations[pick(std::size(operations))])
+                        .append(" i32 ").append(first).append(", i32 ").append(operand()).append("\n");
+                }
+
+                (block == 0 ? entry_values : local_values).emplace_back(std::move(value));
+                module.instructions++;
+            }
+
+            const auto &last = block == 0 ? entry_values.back() : local_values.back();
+            last_values.push_back(last);
+
+            if (block + 1 == shape.blocks) {
+                text.append("    ret i32 ").append(last).append("\n");
+                module.instructions++;
+                continue;
+            }
+
+            if (block + 2 == shape.blocks) {
+                text.append("    jmp ").append(label(block + 1)).append("\n");
+                module.instructions++;
+                continue;
+            }
+
+            auto condition = new_value();
+
+            text.append("    ").append(condition).append(" = icmp ult i32 ").append(last)
+                .append(", i32 ").append(std::to_string(pick(100))).append("\n")
+                .append("    branch ").append(label(block + 1)).append(" ").append(label(block + 2))
+                .append(" i1 ").append(condition).append("\n");
+
+            module.instructions += 2;
+        }
+
+        text.append("end\n\n");
+    }
+
+    return module;
+}
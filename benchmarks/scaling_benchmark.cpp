@@ -0,0 +1,152 @@
+#include <malloc.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/instrumentation.hpp"
+#include "../src/backend/interface.hpp"
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+
+namespace scaling {
+    using backend::instrument::phase;
+
+    constexpr phase measured_phases[] = {
+        phase::lex, phase::parse, phase::optimize, phase::metadata,
+        phase::variable_lifetimes, phase::codegen, phase::print,
+    };
+
+    // Resets the peak resident set size of the process to its current size, so each
+    // size's peak is its own rather than the largest of everything run before it.
+    // Memory freed by earlier runs is returned first, or it would still count as resident.
+    bool reset_peak_rss() {
+        malloc_trim(0);
+
+        std::ofstream clear_refs { "/proc/self/clear_refs" };
+        clear_refs << "5";
+        clear_refs.flush();
+
+        return (bool) clear_refs;
+    }
+
+    // Peak resident set size in KB since the last reset, VmHWM in /proc/self/status
+    size_t peak_rss() {
+        std::ifstream status { "/proc/self/status" };
+        std::string line;
+
+        while (std::getline(status, line)) {
+            if (line.starts_with("VmHWM:"))
+                return std::stoul(line.substr(6));
+        }
+
+        return 0;
+    }
+
+    struct result {
+        size_t instructions;
+        std::array<double, backend::instrument::phase_count> nanoseconds;
+        size_t peak_kb;
+    };
+
+    // Runs the whole pipeline on a generated module, keeping the fastest time of each phase
+    result measure(const module_shape &shape, int iterations) {
+        const auto module = generate_module(shape);
+
+        result measured { module.instructions, {}, 0 };
+        measured.nanoseconds.fill(std::numeric_limits<double>::max());
+
+        reset_peak_rss();
+
+        for (int i = 0; i < iterations; i++) {
+            backend::instrument::profile profile;
+
+            {
+                backend::instrument::profile_scope scope { profile };
+                std::stringstream output;
+
+                ir::lexer::identifier_table identifiers;
+                auto tokens = ir::lexer::lex(module.text, identifiers);
+                auto root = ir::parser::parse(tokens);
+
+                backend::compile(root, output);
+            }
+
+            for (const auto which : measured_phases) {
+                auto &best = measured.nanoseconds[(size_t) which];
+                best = std::min(best, (double) profile.totals(which).nanoseconds);
+            }
+        }
+
+        measured.peak_kb = peak_rss();
+        return measured;
+    }
+
+    // Wide enough for the phase's name and a space before it
+    int column_width(phase which) {
+        return (int) std::max<size_t>(10, std::string_view { backend::instrument::phase_name(which) }.size() + 1);
+    }
+
+    void print_header() {
+        std::cout << "  " << std::left << std::setw(22) << "shape" << std::right << std::setw(10) << "insts";
+
+        for (const auto which : measured_phases)
+            std::cout << std::setw(column_width(which)) << backend::instrument::phase_name(which);
+
+        std::cout << std::setw(12) << "total" << std::setw(12) << "peak RSS" << '\n';
+    }
+
+    // Nanoseconds per instruction of each phase, which stay flat as long as the phase is linear
+    void print_result(const module_shape &shape, const result &measured) {
+        std::stringstream name;
+        name << shape.functions << " x " << shape.blocks << " x " << shape.instructions;
+
+        std::cout << "  " << std::left << std::setw(22) << name.str() << std::right << std::setw(10) << measured.instructions
+                  << std::fixed << std::setprecision(1);
+
+        double total = 0;
+
+        for (const auto which : measured_phases) {
+            const auto nanoseconds = measured.nanoseconds[(size_t) which];
+            total += nanoseconds;
+
+            std::cout << std::setw(column_width(which)) << nanoseconds / (double) measured.instructions;
+        }
+
+        std::cout << std::setw(12) << total / (double) measured.instructions
+                  << std::setw(9) << measured.peak_kb / 1024 << " MB\n";
+    }
+}
+
+// Compile time per instruction of every phase over growing generated modules, once growing
+// the number of functions and once the size of each function. A phase whose time per
+// instruction grows with the size is super-linear in it.
+void run_scaling_benchmarks() {
+    constexpr int iterations = 3;
+
+    if (!scaling::reset_peak_rss())
+        std::cout << "Peak RSS cannot be reset, it is the peak of the whole run so far\n";
+
+    std::cout << "Compile scaling, nanoseconds per instruction (functions x blocks x instructions):\n";
+    scaling::print_header();
+
+    for (const size_t functions : { 10, 100, 1000, 10000 }) {
+        const module_shape shape { .functions = functions };
+        scaling::print_result(shape, scaling::measure(shape, iterations));
+    }
+
+    for (const size_t blocks : { 4, 16, 64, 256, 1024 }) {
+        const module_shape shape { .functions = 16, .blocks = blocks };
+        scaling::print_result(shape, scaling::measure(shape, iterations));
+    }
+
+    for (const size_t instructions : { 8, 32, 128, 512 }) {
+        const module_shape shape { .functions = 16, .blocks = 4, .instructions = instructions };
+        scaling::print_result(shape, scaling::measure(shape, iterations));
+    }
+}
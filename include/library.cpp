@@ -3,12 +3,18 @@
 cb::function_builder cb::code_unit::create_function(
     std::string name,
     ir::value_size return_type,
-    std::vector<ir::variable> parameters
+    const std::vector<std::pair<ir::value_size, std::string_view>> &parameters
 ) {
+    ir::symbol_table symbols;
+
+    std::vector<ir::variable> params;
+    for (const auto &[size, param_name] : parameters)
+        params.emplace_back(size, symbols.intern(param_name));
+
     std::vector<ir::block::block> default_blocks;
-    default_blocks.emplace_back("__entry");
+    default_blocks.emplace_back(symbols.intern("__entry"));
 
-    root.functions.emplace_back(name, std::move(parameters), std::move(default_blocks), return_type);
+    root.functions.emplace_back(name, std::move(symbols), std::move(params), std::move(default_blocks), return_type);
 
     return {
         .unit = this,
@@ -17,7 +23,15 @@ cb::function_builder cb::code_unit::create_function(
     };
 }
 
-void cb::function_builder::create_block(const std::string &name) {
-    current_function->blocks.emplace_back(name);
+ir::symbol cb::function_builder::symbol(std::string_view name) {
+    return current_function->symbols.intern(name);
+}
+
+ir::variable cb::function_builder::variable(ir::value_size size, std::string_view name) {
+    return ir::variable { size, symbol(name) };
+}
+
+void cb::function_builder::create_block(std::string_view name) {
+    current_function->blocks.emplace_back(symbol(name));
     current_block = &current_function->blocks.back();
 }
\ No newline at end of file
@@ -8,7 +8,8 @@ namespace cb {
 
         code_unit() = default;
 
-        function_builder create_function(std::string name, ir::value_size return_type, std::vector<ir::variable> parameters);
+        function_builder create_function(std::string name, ir::value_size return_type,
+                                         const std::vector<std::pair<ir::value_size, std::string_view>> &parameters);
     };
 
     struct function_builder {
@@ -16,7 +17,14 @@ namespace cb {
         ir::global::function *current_function;
         ir::block::block *current_block;
 
-        void create_block(const std::string &name);
+        /**
+         *  Interns @name in the current function, for naming variables and labels
+         *  passed to create_instruction.
+         */
+        ir::symbol symbol(std::string_view name);
+        ir::variable variable(ir::value_size size, std::string_view name);
+
+        void create_block(std::string_view name);
 
         void checkout_last_block();
 
@@ -24,7 +32,7 @@ namespace cb {
 
         template<typename T, typename... Args>
         void create_instruction(Args &&... args) {
-            current_block->instructions.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
+            current_block->instructions.emplace_back(ir::block::instruction { std::in_place_type<T>, std::forward<Args>(args)... });
         }
     };
 }
\ No newline at end of file
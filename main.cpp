@@ -1,15 +1,94 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
 
 #include "src/ir/input/lexer.hpp"
 #include "src/ir/input/parser.hpp"
 #include "src/backend/interface.hpp"
+#include "src/backend/instrumentation.hpp"
 #include "tests/tests.cpp"
 
-int main() {
+int main(int argc, char **argv) {
+    backend::compile_options options {};
+    bool jit = false;
+    std::string_view profile_format;
+    std::string_view trace_path;
+    bool pass_stats = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument { argv[i] };
+
+        if (argument.starts_with("--regalloc=")) {
+            const auto mode = backend::parse_regalloc_mode(argument.substr(std::string_view { "--regalloc=" }.size()));
+
+            if (!mode) {
+                std::cerr << "Unknown register allocator: " << argument << '\n';
+                return 1;
+            }
+
+            options.regalloc = *mode;
+        } else if (argument == "--jit") {
+            jit = true;
+        } else if (argument.starts_with("--profile=")) {
+            profile_format = argument.substr(std::string_view { "--profile=" }.size());
+
+            if (profile_format != "table" && profile_format != "json") {
+                std::cerr << "Unknown profile format: " << argument << '\n';
+                return 1;
+            }
+        } else if (argument.starts_with("--trace=")) {
+            trace_path = argument.substr(std::string_view { "--trace=" }.size());
+        } else if (argument.starts_with("-O")) {
+            const auto level = backend::parse_opt_level(argument.substr(2));
+
+            if (!level) {
+                std::cerr << "Unknown optimization level: " << argument << '\n';
+                return 1;
+            }
+
+            options.optimization = *level;
+        } else if (argument.starts_with("--passes=")) {
+            auto list = argument.substr(std::string_view { "--passes=" }.size());
+
+            // Comma separated, replacing the optimization level's pipeline
+            while (!list.empty()) {
+                const auto name = list.substr(0, list.find(','));
+                list.remove_prefix(std::min(list.size(), name.size() + 1));
+
+                if (!backend::opt::find_pass(name)) {
+                    std::cerr << "Unknown pass: " << name << '\n';
+                    return 1;
+                }
+
+                options.passes.emplace_back(name);
+            }
+        } else if (argument == "--pass-stats") {
+            pass_stats = true;
+        }
+    }
+
     run_tests();
 
+    // Only the compile below is profiled, not the tests
+    backend::instrument::profile profile;
+    std::optional<backend::instrument::profile_scope> profiling;
+
+    if (!profile_format.empty())
+        profiling.emplace(profile);
+
+    backend::instrument::trace trace;
+    std::optional<backend::instrument::trace_scope> tracing;
+
+    if (!trace_path.empty())
+        tracing.emplace(trace);
+
+    backend::opt::pass_statistics statistics;
+
+    if (pass_stats)
+        options.pass_statistics = &statistics;
+
     const char *file_path = "../examples/pointer_test.ir";
 
     std::ifstream file { file_path };
@@ -23,13 +102,40 @@ int main() {
 
     std::stringstream ss;
 
-    backend::compile(ast, ss);
+    backend::compile(ast, ss, options);
     output << ss.str();
     std::cout << ss.str();
 
+    if (profile_format == "table")
+        profile.write_table(std::cerr);
+    else if (profile_format == "json")
+        profile.write_json(std::cerr);
+
+    if (pass_stats)
+        statistics.write_table(std::cerr);
+
+    if (!trace_path.empty()) {
+        std::ofstream trace_file { std::string { trace_path } };
+        trace.write_json(trace_file);
+    }
+
     output.close();
+
+    if (jit) {
+        const exec::jit_module module { backend::assemble(ast, options) };
+
+        std::cout << "\nCompilation complete.\n";
+        std::cout << "Program Output:\n";
+
+        return module.function<int()>("main")();
+    }
+
+    std::ofstream object { "../output.o", std::ios::binary };
+    backend::compile_object(ast, object, options);
+    object.close();
+
     std::cout << "\nCompilation complete.\n";
     std::cout << "Program Output:\n";
 
-    return exec::execute("../output.asm");
+    return exec::execute("../output.o");
 }
\ No newline at end of file
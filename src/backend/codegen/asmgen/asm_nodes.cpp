@@ -1,153 +1,9 @@
 #include "asm_nodes.hpp"
-#include "../context/function_context.hpp"
-
-namespace backend::as::op {
-    struct reg : backend::as::op::operand_t {
-        backend::context::register_t index;
-
-        explicit reg(ir::value_size size, backend::context::register_t index)
-                : operand_t(operand_types::reg, size), index(index) {}
-        ~reg() override = default;
-
-        [[nodiscard]] std::string get_value() const override {
-            if (address) {
-                return context::get_stack_prefix(size)
-                    .append("[")
-                    .append(backend::context::register_as_string(index, ir::value_size::ptr))
-                    .append("]");
-            } else {
-                return backend::context::register_as_string(index, size);
-            }
-        }
-
-        [[nodiscard]] bool equals(const operand_t& other) override {
-            if (other.type != operand_types::reg)
-                return false;
-
-            return dynamic_cast<const reg&>(other).index == index;
-        }
-    };
-
-    struct imm : backend::as::op::operand_t {
-        uint64_t val;
-
-        explicit imm(ir::value_size size, uint64_t val)
-                : operand_t(operand_types::literal, size), val(val) {}
-        ~imm() override = default;
-
-        [[nodiscard]] std::string get_value() const override {
-            return std::to_string(val);
-        }
-        [[nodiscard]] bool equals(const operand_t& other) override {
-            if (other.type != operand_types::literal)
-                return false;
-
-            return dynamic_cast<const imm&>(other).val == val;
-        }
-    };
-
-    struct stack_memory : operand_t {
-        int64_t rbp_off;
-
-        explicit stack_memory(ir::value_size size, int64_t rbp_off)
-                : operand_t(operand_types::stack_mem, size), rbp_off(rbp_off) {}
-
-        [[nodiscard]] std::string get_value() const override {
-            std::stringstream ss;
-
-            if (!this->address)
-                ss << context::get_stack_prefix(size);
-
-            ss << "[rbp";
-
-            if (rbp_off != 0) {
-                ss << ((rbp_off < 0) ? " - " : " + ");
-                ss << std::abs(rbp_off);
-            }
-
-            ss << "]";
-
-            return ss.str();
-        }
-        [[nodiscard]] bool equals(const operand_t& other) override {
-            if (other.type != operand_types::stack_mem)
-                return false;
-
-            return dynamic_cast<const stack_memory&>(other).rbp_off == rbp_off;
-        }
-    };
-
-    struct complex_ptr : operand_t {
-        int64_t base;
-
-        std::optional<backend::context::register_t> reg;
-        std::optional<int8_t> reg_scale;
-        std::optional<backend::context::register_t> unscaled_reg;
-
-        explicit complex_ptr(ir::value_size size, const backend::context::memory_addr &addr)
-                : operand_t(operand_types::complex_ptr, size), base(addr.offset) {
-            if (addr.scaled.has_value()) {
-                reg = addr.scaled->reg;
-                reg_scale = addr.scaled->scale;
-            }
-
-            if (addr.unscaled.has_value())
-                unscaled_reg = addr.unscaled;
-        }
-
-        [[nodiscard]] std::string get_value() const override {
-            std::stringstream ss;
-
-            if (!this->address)
-                ss << context::get_stack_prefix(size);
+#include "operands.hpp"
 
-            ss << "[";
+#include <iterator>
 
-            if (reg_scale) {
-                if (*reg_scale != 1)
-                    ss << (int) *reg_scale << " * ";
-
-                ss << backend::context::register_as_string(*reg, ir::value_size::ptr);
-
-                ss << " + ";
-            }
-
-            if (unscaled_reg.has_value()) {
-                ss << backend::context::register_as_string(*unscaled_reg, ir::value_size::ptr);
-            }
-
-            if (base != 0) {
-                ss << ((base < 0) ? " - " : " + ");
-                ss << std::abs(base);
-            }
-
-            ss << "]";
-
-            return ss.str();
-        }
-        [[nodiscard]] bool equals(const operand_t& other) override {
-            if (other.type != operand_types::complex_ptr)
-                return false;
-
-            auto &other_ptr = dynamic_cast<const complex_ptr&>(other);
-            return other_ptr.base == base && other_ptr.reg == reg && other_ptr.reg_scale == reg_scale;
-        }
-    };
-
-    struct global_pointer : operand_t {
-        std::string name;
-
-        explicit global_pointer(std::string name)
-                : operand_t(operand_types::global_ptr, ir::value_size::ptr), name(std::move(name)) {}
-
-        [[nodiscard]] std::string get_value() const override {
-            return name;
-        }
-        [[nodiscard]] bool equals(const operand_t& other) override {
-            return other.type == operand_types::global_ptr;
-        }
-    };
-}
+#include "../context/function_context.hpp"
 
 namespace backend::as::inst {
     constexpr static std::string cond_inst(const char* prefix, ir::block::icmp_type type) {
@@ -218,30 +74,35 @@ namespace backend::as::inst {
     }
 
     void stack_save::print(backend::context::function_context &context) const {
-        if (context.current_stack_size != 0) {
+        if (context.needs_frame()) {
             print_inst(context.ostream, "push");
             context.ostream << "rbp\n";
 
             print_inst(context.ostream, "mov");
             context.ostream << "rbp, rsp\n";
+        }
 
+        if (context.current_stack_size != 0) {
             print_inst(context.ostream, "sub");
             context.ostream << "rsp, " << context.current_stack_size << '\n';
         }
 
-        for (size_t i = 1; i < backend::context::register_count; i++) {
-            if (!context.storage.registers[i]->tampered || context.register_is_param[i]) continue;
+        for (auto reg : backend::context::callee_saved) {
+            if (!context.must_preserve(reg)) continue;
 
             print_inst(context.ostream, "push");
-            context.ostream << backend::context::register_as_string((backend::context::register_t) i, ir::value_size::i64);
+            context.ostream << backend::context::register_as_string(reg, ir::value_size::i64) << '\n';
+        }
 
-            if (i != backend::context::register_count - 1)
-                context.ostream << '\n';
+        if (const auto padding = context.alignment_padding()) {
+            print_inst(context.ostream, "sub");
+            context.ostream << "rsp, " << padding << '\n';
         }
     }
 
     void mov::print(backend::context::function_context &context) const {
-        if (src->get_value() == "0") {
+        // Only registers are zeroed with xor, memory can't be both operands
+        if (src->get_value() == "0" && dest->direct_register()) {
             print_inst(context.ostream, "xor", dest, dest);
             return;
         }
@@ -285,20 +146,34 @@ namespace backend::as::inst {
         print_inst(context.ostream, cmd, oper1, oper2);
     }
 
+    void push::print(backend::context::function_context &context) const {
+        print_inst(context.ostream, "push", op);
+    }
+
     void call::print(backend::context::function_context &context) const {
         print_inst(context.ostream, "call");
         context.ostream << function_name;
     }
 
     void ret::print(backend::context::function_context &context) const {
-        for (size_t i = backend::context::register_count - 1; i >= 1; i--) {
-            if (!context.storage.registers[i]->tampered || context.register_is_param[i]) continue;
+        if (!restore) {
+            print_inst(context.ostream, "ret");
+            return;
+        }
+
+        if (const auto padding = context.alignment_padding()) {
+            print_inst(context.ostream, "add");
+            context.ostream << "rsp, " << padding << '\n';
+        }
+
+        for (auto reg = std::rbegin(backend::context::callee_saved); reg != std::rend(backend::context::callee_saved); reg++) {
+            if (!context.must_preserve(*reg)) continue;
 
             print_inst(context.ostream, "pop");
-            context.ostream << backend::context::register_as_string((backend::context::register_t) i, ir::value_size::i64) << '\n';
+            context.ostream << backend::context::register_as_string(*reg, ir::value_size::i64) << '\n';
         }
 
-        if (context.current_stack_size != 0) {
+        if (context.needs_frame()) {
             print_inst(context.ostream, "leave");
             context.ostream << '\n';
         }
@@ -308,15 +183,19 @@ namespace backend::as::inst {
 }
 
 std::unique_ptr<backend::as::op::operand_t> backend::as::create_operand(const context::virtual_memory *vptr, ir::value_size size) {
-    if (const auto *reg = dynamic_cast<const context::register_storage*>(vptr)) {
-        return std::make_unique<op::reg>(size, reg->reg);
-    } else if (const auto *memory_ptr = dynamic_cast<const context::memory_addr *>(vptr)) {
-        return std::make_unique<op::complex_ptr>(size, *memory_ptr);
-    } else if (const auto *global = dynamic_cast<const context::global_pointer*>(vptr)) {
-        return std::make_unique<op::global_pointer>(global->name);
+    switch (vptr->kind) {
+        case context::vmem_kind::register_storage:
+            return std::make_unique<op::reg>(size, static_cast<const context::register_storage*>(vptr)->reg);
+        case context::vmem_kind::memory_addr:
+            return std::make_unique<op::complex_ptr>(size, *static_cast<const context::memory_addr*>(vptr));
+        case context::vmem_kind::global_pointer:
+            return std::make_unique<op::global_pointer>(static_cast<const context::global_pointer*>(vptr)->name);
+        case context::vmem_kind::int_literal:
+            return std::make_unique<op::imm>(size, static_cast<const context::vptr_int_literal*>(vptr)->value);
+
+        default:
+            throw std::runtime_error("Invalid operand type");
     }
-
-    throw std::runtime_error("Invalid operand type");
 }
 
 std::unique_ptr<backend::as::op::operand_t> backend::as::create_operand(ir::int_literal lit, ir::value_size size) {
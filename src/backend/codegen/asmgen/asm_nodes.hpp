@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <utility>
 #include <iomanip>
@@ -27,6 +28,20 @@ namespace backend::as {
 
             [[nodiscard]] virtual std::string get_value() const = 0;
             [[nodiscard]] virtual bool equals(const operand_t& other) = 0;
+
+            /**
+             *  The register the operand names directly, not through a memory access.
+             */
+            [[nodiscard]] virtual std::optional<backend::context::register_t> direct_register() const {
+                return std::nullopt;
+            }
+
+            /**
+             *  Whether the operand addresses the stack frame, i.e. is relative to rbp.
+             */
+            [[nodiscard]] virtual bool in_frame() const {
+                return false;
+            }
         };
     }
 
@@ -38,16 +53,41 @@ namespace backend::as {
             ir::value_size size;
         };
 
+        enum class asm_kind : uint8_t {
+            stack_save, mov, lea, cmov, movsx, set, jmp, cmp, cond_jmp, arithmetic, push, call, ret
+        };
+
+        /**
+         *  Like operands, nodes carry their @kind so that passes rewriting the emitted
+         *  assembly (e.g. phi lowering) can find specific nodes without RTTI.
+         */
         struct asm_node {
+            const asm_kind kind;
             bool is_valid = true;
 
+            explicit asm_node(asm_kind kind) : kind(kind) {}
             virtual ~asm_node() = default;
             virtual void print(backend::context::function_context &context) const = 0;
             [[nodiscard]] bool printable() const { return is_valid; }
+
+            /**
+             *  Calls @fn with each operand of the node, and whether the node writes to it.
+             */
+            virtual void for_each_operand(const std::function<void(const op::operand_t &, bool)> &) const {}
         };
 
+        /**
+         *  Downcasts @node to @T, returning nullptr if it is a different kind of node.
+         */
+        template <typename T>
+        T *asm_cast(asm_node *node) {
+            return node->kind == T::tag ? static_cast<T*>(node) : nullptr;
+        }
+
         struct stack_save : asm_node {
-            stack_save() = default;
+            static constexpr asm_kind tag = asm_kind::stack_save;
+
+            stack_save() : asm_node(tag) {}
 
             ~stack_save() override = default;
 
@@ -55,10 +95,12 @@ namespace backend::as {
         };
 
         struct mov : asm_node {
+            static constexpr asm_kind tag = asm_kind::mov;
+
             operand src, dest;
 
             mov(operand dest, operand src)
-                    : src(std::move(src)), dest(std::move(dest)) {
+                    : asm_node(tag), src(std::move(src)), dest(std::move(dest)) {
                 if (this->src->equals(*this->dest))
                     is_valid = false;
             }
@@ -66,51 +108,79 @@ namespace backend::as {
             ~mov() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*dest, true);
+                fn(*src, false);
+            }
         };
 
         struct lea : asm_node {
+            static constexpr asm_kind tag = asm_kind::lea;
+
             operand dest;
             operand ptr;
 
             lea(operand dest, operand ptr)
-                    : dest(std::move(dest)), ptr(std::move(ptr)) {
+                    : asm_node(tag), dest(std::move(dest)), ptr(std::move(ptr)) {
                 this->ptr->address = true;
             }
 
             ~lea() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*dest, true);
+                fn(*ptr, false);
+            }
         };
 
         struct cmov : asm_node {
+            static constexpr asm_kind tag = asm_kind::cmov;
+
             ir::block::icmp_type type;
             operand src, dest;
 
             cmov(ir::block::icmp_type type, operand op1, operand op2)
-                    : type(type), src(std::move(op1)), dest(std::move(op2)) {}
+                    : asm_node(tag), type(type), src(std::move(op1)), dest(std::move(op2)) {}
 
             ~cmov() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*src, true);
+                fn(*dest, false);
+            }
         };
 
         struct movsx : asm_node {
+            static constexpr asm_kind tag = asm_kind::movsx;
+
             operand src, dest;
 
             movsx(operand src, operand dest)
-                    : src(std::move(src)), dest(std::move(dest)) {}
+                    : asm_node(tag), src(std::move(src)), dest(std::move(dest)) {}
 
             ~movsx() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*src, true);
+                fn(*dest, false);
+            }
         };
 
         struct set : asm_node {
+            static constexpr asm_kind tag = asm_kind::set;
+
             ir::block::icmp_type type;
             operand op;
 
             set(ir::block::icmp_type type, operand op)
-                    : type(type), op(std::move(op)) {
+                    : asm_node(tag), type(type), op(std::move(op)) {
                 debug::assert(this->op->type == operand_types::reg, "set operand must be a register");
                 debug::assert(this->op->size == ir::value_size::i1, "set operand must be a i1");
             }
@@ -118,13 +188,19 @@ namespace backend::as {
             ~set() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*op, true);
+            }
         };
 
         struct jmp : asm_node {
+            static constexpr asm_kind tag = asm_kind::jmp;
+
             std::string label_name;
 
             explicit jmp(std::string label_name)
-                    : label_name(std::move(label_name)) {}
+                    : asm_node(tag), label_name(std::move(label_name)) {}
 
             ~jmp() override = default;
 
@@ -132,22 +208,31 @@ namespace backend::as {
         };
 
         struct cmp : asm_node {
+            static constexpr asm_kind tag = asm_kind::cmp;
+
             operand oper1, oper2;
 
             cmp(operand oper1, operand oper2)
-                    : oper1(std::move(oper1)), oper2(std::move(oper2)) {}
+                    : asm_node(tag), oper1(std::move(oper1)), oper2(std::move(oper2)) {}
 
             ~cmp() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*oper1, false);
+                fn(*oper2, false);
+            }
         };
 
         struct cond_jmp : asm_node {
+            static constexpr asm_kind tag = asm_kind::cond_jmp;
+
             ir::block::icmp_type type;
             std::string branch_name;
 
             cond_jmp(ir::block::icmp_type type, std::string branch_name)
-                    : type(type), branch_name(std::move(branch_name)) {}
+                    : asm_node(tag), type(type), branch_name(std::move(branch_name)) {}
 
             ~cond_jmp() override = default;
 
@@ -155,22 +240,48 @@ namespace backend::as {
         };
 
         struct arithmetic : asm_node {
+            static constexpr asm_kind tag = asm_kind::arithmetic;
+
             ir::block::arithmetic_type type;
             operand oper1, oper2;
 
             arithmetic(ir::block::arithmetic_type type, operand oper1, operand oper2)
-                    : type(type), oper1(std::move(oper1)), oper2(std::move(oper2)) {}
+                    : asm_node(tag), type(type), oper1(std::move(oper1)), oper2(std::move(oper2)) {}
 
             ~arithmetic() override = default;
 
             void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*oper1, true);
+                fn(*oper2, false);
+            }
+        };
+
+        struct push : asm_node {
+            static constexpr asm_kind tag = asm_kind::push;
+
+            operand op;
+
+            explicit push(operand op)
+                    : asm_node(tag), op(std::move(op)) {}
+
+            ~push() override = default;
+
+            void print(backend::context::function_context &context) const override;
+
+            void for_each_operand(const std::function<void(const op::operand_t &, bool)> &fn) const override {
+                fn(*op, false);
+            }
         };
 
         struct call : asm_node {
+            static constexpr asm_kind tag = asm_kind::call;
+
             std::string function_name;
 
             explicit call(std::string function_name)
-                    : function_name(std::move(function_name)) {}
+                    : asm_node(tag), function_name(std::move(function_name)) {}
 
             ~call() override = default;
 
@@ -178,7 +289,12 @@ namespace backend::as {
         };
 
         struct ret : asm_node {
-            ret() = default;
+            static constexpr asm_kind tag = asm_kind::ret;
+
+            // Cleared when the return is reached without passing a stack_save, see shrink_wrap
+            bool restore = true;
+
+            ret() : asm_node(tag) {}
             ~ret() override = default;
 
             void print(backend::context::function_context &context) const override;
@@ -0,0 +1,186 @@
+#include "elf_writer.hpp"
+
+#include <elf.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    enum section_index : uint16_t {
+        null_section, text, rodata, rela_text, symtab, strtab, shstrtab, note_gnu_stack, section_count
+    };
+
+    constexpr size_t function_alignment = 16;
+
+    // A string table, names are referred to by their offset into it
+    struct string_table {
+        std::string data { '\0' };
+
+        uint32_t add(std::string_view name) {
+            const auto offset = (uint32_t) data.size();
+
+            data.append(name);
+            data.push_back('\0');
+
+            return offset;
+        }
+    };
+
+    template <typename T>
+    void append(std::string &buffer, const T &value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void align(std::string &buffer, size_t alignment, char fill = '\0') {
+        buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, fill);
+    }
+}
+
+void backend::as::write_elf_object(const encoded_module &module, std::ostream &ostream) {
+    string_table names;
+    std::vector<Elf64_Sym> symbols;
+    std::unordered_map<std::string_view, uint32_t> symbol_index;
+
+    std::string text_data, rodata_data;
+    std::vector<size_t> function_offsets;
+
+    for (const auto &function : module.functions) {
+        align(text_data, function_alignment, (char) 0xCC);
+        function_offsets.push_back(text_data.size());
+        text_data.append(reinterpret_cast<const char *>(function.code.data()), function.code.size());
+    }
+
+    const auto add_symbol = [&](std::string_view name, unsigned char bind, unsigned char type,
+                                uint16_t section, size_t value, size_t size) {
+        symbol_index.emplace(name, (uint32_t) symbols.size());
+        symbols.push_back(Elf64_Sym {
+            .st_name = names.add(name),
+            .st_info = (unsigned char) ELF64_ST_INFO(bind, type),
+            .st_other = STV_DEFAULT,
+            .st_shndx = section,
+            .st_value = value,
+            .st_size = size,
+        });
+    };
+
+    symbols.push_back(Elf64_Sym {});
+    symbols.push_back(Elf64_Sym { .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION), .st_shndx = text });
+    symbols.push_back(Elf64_Sym { .st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION), .st_shndx = rodata });
+
+    // Local symbols have to precede the global ones
+    for (const auto &data : module.data) {
+        add_symbol(data.name, STB_LOCAL, STT_OBJECT, rodata, rodata_data.size(), data.bytes.size());
+        rodata_data.append(reinterpret_cast<const char *>(data.bytes.data()), data.bytes.size());
+    }
+
+    const auto first_global = (uint32_t) symbols.size();
+
+    for (size_t i = 0; i < module.functions.size(); i++)
+        add_symbol(module.functions[i].name, STB_GLOBAL, STT_FUNC, text, function_offsets[i], module.functions[i].code.size());
+
+    for (const auto &name : module.external_functions)
+        add_symbol(name, STB_GLOBAL, STT_NOTYPE, SHN_UNDEF, 0, 0);
+
+    std::string rela_data;
+
+    for (size_t i = 0; i < module.functions.size(); i++) {
+        for (const auto &relocation : module.functions[i].relocations) {
+            const auto symbol = symbol_index.find(relocation.symbol);
+
+            if (symbol == symbol_index.end())
+                throw std::runtime_error("reference to undefined symbol " + relocation.symbol);
+
+            const auto type = relocation.kind == relocation_kind::call_32 ? R_X86_64_PLT32 : R_X86_64_PC32;
+
+            append(rela_data, Elf64_Rela {
+                .r_offset = function_offsets[i] + relocation.offset,
+                .r_info = ELF64_R_INFO(symbol->second, type),
+                .r_addend = relocation.addend,
+            });
+        }
+    }
+
+    std::string symtab_data;
+    for (const auto &symbol : symbols)
+        append(symtab_data, symbol);
+
+    string_table section_names;
+    std::vector<Elf64_Shdr> headers(section_count);
+
+    const auto set_section = [&](section_index index, std::string_view name, uint32_t type, uint64_t flags, uint64_t alignment) {
+        headers[index].sh_name = section_names.add(name);
+        headers[index].sh_type = type;
+        headers[index].sh_flags = flags;
+        headers[index].sh_addralign = alignment;
+    };
+
+    set_section(text, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, function_alignment);
+    set_section(rodata, ".rodata", SHT_PROGBITS, SHF_ALLOC, 1);
+    set_section(rela_text, ".rela.text", SHT_RELA, SHF_INFO_LINK, 8);
+    set_section(symtab, ".symtab", SHT_SYMTAB, 0, 8);
+    set_section(strtab, ".strtab", SHT_STRTAB, 0, 1);
+    set_section(shstrtab, ".shstrtab", SHT_STRTAB, 0, 1);
+
+    // Marks the stack as non executable, like the note every assembler emits
+    set_section(note_gnu_stack, ".note.GNU-stack", SHT_PROGBITS, 0, 1);
+
+    headers[rela_text].sh_link = symtab;
+    headers[rela_text].sh_info = text;
+    headers[rela_text].sh_entsize = sizeof(Elf64_Rela);
+
+    headers[symtab].sh_link = strtab;
+    headers[symtab].sh_info = first_global;
+    headers[symtab].sh_entsize = sizeof(Elf64_Sym);
+
+    const std::pair<section_index, const std::string *> contents[] = {
+        { text, &text_data },
+        { rodata, &rodata_data },
+        { rela_text, &rela_data },
+        { symtab, &symtab_data },
+        { strtab, &names.data },
+        { shstrtab, &section_names.data },
+    };
+
+    std::string output(sizeof(Elf64_Ehdr), '\0');
+
+    for (const auto &[index, data] : contents) {
+        align(output, headers[index].sh_addralign);
+
+        headers[index].sh_offset = output.size();
+        headers[index].sh_size = data->size();
+        output.append(*data);
+    }
+
+    headers[note_gnu_stack].sh_offset = output.size();
+
+    align(output, 8);
+    const auto section_headers = output.size();
+
+    for (const auto &header : headers)
+        append(output, header);
+
+    Elf64_Ehdr elf_header {
+        .e_type = ET_REL,
+        .e_machine = EM_X86_64,
+        .e_version = EV_CURRENT,
+        .e_shoff = section_headers,
+        .e_ehsize = sizeof(Elf64_Ehdr),
+        .e_shentsize = sizeof(Elf64_Shdr),
+        .e_shnum = section_count,
+        .e_shstrndx = shstrtab,
+    };
+
+    std::memcpy(elf_header.e_ident, ELFMAG, SELFMAG);
+    elf_header.e_ident[EI_CLASS] = ELFCLASS64;
+    elf_header.e_ident[EI_DATA] = ELFDATA2LSB;
+    elf_header.e_ident[EI_VERSION] = EV_CURRENT;
+    elf_header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+
+    std::memcpy(output.data(), &elf_header, sizeof(Elf64_Ehdr));
+
+    ostream.write(output.data(), (std::streamsize) output.size());
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <ostream>
+
+#include "encoder.hpp"
+
+namespace backend::as {
+    /**
+     *  Writes @module as an ELF64 relocatable object, the equivalent of assembling the
+     *  printed module with nasm -f elf64.
+     *
+     *  Functions are laid out in .text and exported as global symbols, global strings
+     *  go to .rodata as local ones, and extern functions become undefined symbols.
+     *  Calls and string references are emitted as PLT32 and PC32 relocations, so the
+     *  object links into position independent executables as well.
+     */
+    void write_elf_object(const encoded_module &module, std::ostream &ostream);
+}
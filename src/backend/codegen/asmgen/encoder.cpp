@@ -0,0 +1,657 @@
+#include "encoder.hpp"
+#include "operands.hpp"
+
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../context/function_context.hpp"
+
+using namespace backend;
+
+namespace {
+    // Hardware register numbers, which are ordered differently from context::register_t
+    uint8_t hardware_register(context::register_t reg) {
+        constexpr uint8_t numbers[] = {
+            0, 3, 1, 2, 6, 7,
+            8, 9, 10, 11, 12,
+            13, 14, 15,
+            4, 5
+        };
+
+        return numbers[reg];
+    }
+
+    uint8_t condition_code(ir::block::icmp_type type) {
+        switch (type) {
+            using enum ir::block::icmp_type;
+
+            case eq: return 0x4;
+            case neq: return 0x5;
+            case slt: return 0xC;
+            case sgt: return 0xF;
+            case sle: return 0xE;
+            case sge: return 0xD;
+            case ult: return 0x2;
+            case ugt: return 0x7;
+            case ule: return 0x6;
+            case uge: return 0x3;
+
+            default:
+                throw std::runtime_error("no such icmp type");
+        }
+    }
+
+    bool fits_i8(int64_t value) {
+        return value >= INT8_MIN && value <= INT8_MAX;
+    }
+
+    bool fits_i32(int64_t value) {
+        return value >= INT32_MIN && value <= INT32_MAX;
+    }
+
+    // An operand in the terms of the encoding: a register, an immediate, a memory reference or a symbol
+    enum class operand_kind : uint8_t {
+        reg, imm, mem, symbol
+    };
+
+    struct operand_info {
+        operand_kind kind;
+        size_t bytes;
+
+        uint8_t reg = 0;
+        int64_t imm = 0;
+
+        std::optional<uint8_t> base, index;
+        uint8_t scale = 1;
+        int32_t disp = 0;
+
+        std::string name;
+    };
+
+    int64_t sign_extend(uint64_t value, size_t bytes) {
+        if (bytes >= 8)
+            return (int64_t) value;
+
+        const auto shift = 64 - bytes * 8;
+        return (int64_t) (value << shift) >> shift;
+    }
+
+    operand_info describe(const as::op::operand_t &operand) {
+        const auto bytes = operand.size == ir::value_size::none || operand.size == ir::value_size::param_dependent
+            ? 8 : (size_t) ir::size_in_bytes(operand.size);
+
+        switch (operand.type) {
+            case as::operand_types::reg: {
+                const auto &reg = static_cast<const as::op::reg &>(operand);
+
+                if (reg.address)
+                    return { .kind = operand_kind::mem, .bytes = bytes, .base = hardware_register(reg.index) };
+
+                return { .kind = operand_kind::reg, .bytes = bytes, .reg = hardware_register(reg.index) };
+            }
+            case as::operand_types::literal: {
+                const auto &imm = static_cast<const as::op::imm &>(operand);
+
+                return { .kind = operand_kind::imm, .bytes = bytes, .imm = sign_extend(imm.val, bytes) };
+            }
+            case as::operand_types::stack_mem: {
+                const auto &stack = static_cast<const as::op::stack_memory &>(operand);
+
+                return { .kind = operand_kind::mem, .bytes = bytes, .base = hardware_register(context::rbp),
+                         .disp = (int32_t) stack.rbp_off };
+            }
+            case as::operand_types::complex_ptr: {
+                const auto &ptr = static_cast<const as::op::complex_ptr &>(operand);
+
+                operand_info info { .kind = operand_kind::mem, .bytes = bytes, .disp = (int32_t) ptr.base };
+
+                if (ptr.unscaled_reg)
+                    info.base = hardware_register(*ptr.unscaled_reg);
+
+                if (ptr.reg_scale) {
+                    info.index = hardware_register(*ptr.reg);
+                    info.scale = (uint8_t) *ptr.reg_scale;
+
+                    // Like the assembler, 3, 5 and 9 become the index plus itself scaled by one less
+                    if (!info.base && (info.scale == 3 || info.scale == 5 || info.scale == 9)) {
+                        info.base = info.index;
+                        info.scale--;
+                    }
+                }
+
+                return info;
+            }
+            case as::operand_types::global_ptr:
+                return { .kind = operand_kind::symbol, .bytes = 8,
+                         .name = static_cast<const as::op::global_pointer &>(operand).name };
+        }
+
+        throw std::runtime_error("invalid operand type");
+    }
+
+    struct code_buffer {
+        std::vector<uint8_t> bytes;
+        std::vector<as::relocation> relocations;
+
+        void u8(uint8_t value) {
+            bytes.push_back(value);
+        }
+
+        void u16(uint16_t value) {
+            u8((uint8_t) value);
+            u8((uint8_t) (value >> 8));
+        }
+
+        void u32(uint32_t value) {
+            u16((uint16_t) value);
+            u16((uint16_t) (value >> 16));
+        }
+
+        void u64(uint64_t value) {
+            u32((uint32_t) value);
+            u32((uint32_t) (value >> 32));
+        }
+
+        void immediate(int64_t value, size_t bytes) {
+            switch (bytes) {
+                case 1: u8((uint8_t) value); break;
+                case 2: u16((uint16_t) value); break;
+                case 4: u32((uint32_t) value); break;
+                default: u64((uint64_t) value); break;
+            }
+        }
+
+        /**
+         *  Emits an instruction taking a ModRM byte, with @rm as its register or memory operand
+         *  and @reg either a register or an opcode extension. Takes care of the operand size
+         *  prefix and REX, which byte registers past bl need to be addressed at all.
+         */
+        void modrm_instruction(std::initializer_list<uint8_t> opcode, uint8_t reg, bool reg_is_register,
+                               const operand_info &rm, size_t bytes) {
+            if (rm.kind != operand_kind::reg && rm.kind != operand_kind::mem)
+                throw std::runtime_error("operand cannot be encoded as a register or memory reference");
+
+            if (bytes == 2)
+                u8(0x66);
+
+            uint8_t rex = 0x40;
+
+            if (bytes == 8) rex |= 0x08;
+            if (reg & 8) rex |= 0x04;
+            if (rm.kind == operand_kind::mem && rm.index && (*rm.index & 8)) rex |= 0x02;
+            if (rm.kind == operand_kind::reg ? (rm.reg & 8) : (rm.base && (*rm.base & 8))) rex |= 0x01;
+
+            const auto byte_register = [&](bool is_register, uint8_t number) {
+                return bytes == 1 && is_register && number >= 4 && number < 8;
+            };
+
+            if (rex != 0x40 || byte_register(reg_is_register, reg) || byte_register(rm.kind == operand_kind::reg, rm.reg))
+                u8(rex);
+
+            for (auto byte : opcode)
+                u8(byte);
+
+            const auto reg_field = (uint8_t) ((reg & 7) << 3);
+
+            if (rm.kind == operand_kind::reg) {
+                u8(0xC0 | reg_field | (rm.reg & 7));
+                return;
+            }
+
+            memory(reg_field, rm);
+        }
+
+        void memory(uint8_t reg_field, const operand_info &rm) {
+            const auto scale_bits = [&]() -> uint8_t {
+                switch (rm.scale) {
+                    case 1: return 0;
+                    case 2: return 1;
+                    case 4: return 2;
+                    case 8: return 3;
+                    default: throw std::runtime_error("invalid index scale");
+                }
+            };
+
+            // Without a base there is only the disp32 form
+            if (!rm.base) {
+                if (!rm.index)
+                    throw std::runtime_error("memory operand without a register");
+
+                u8(0x04 | reg_field);
+                u8((uint8_t) (scale_bits() << 6 | (*rm.index & 7) << 3 | 0x5));
+                u32((uint32_t) rm.disp);
+                return;
+            }
+
+            const auto base = (uint8_t) (*rm.base & 7);
+
+            // rbp and r13 as base always take a displacement, rsp and r12 always take a SIB byte
+            const uint8_t mod = rm.disp == 0 && base != 0x5 ? 0x00 : fits_i8(rm.disp) ? 0x40 : 0x80;
+
+            if (rm.index || base == 0x4) {
+                u8(mod | reg_field | 0x04);
+                u8((uint8_t) (scale_bits() << 6 | (rm.index ? (*rm.index & 7) : 0x4) << 3 | base));
+            } else {
+                u8(mod | reg_field | base);
+            }
+
+            if (mod == 0x40)
+                u8((uint8_t) rm.disp);
+            else if (mod == 0x80)
+                u32((uint32_t) rm.disp);
+        }
+
+        // Instructions encoding a register in the low bits of the opcode, e.g. push or mov imm
+        void register_in_opcode(uint8_t opcode, uint8_t reg, size_t bytes, bool force_rex = false) {
+            if (bytes == 2)
+                u8(0x66);
+
+            uint8_t rex = 0x40;
+
+            if (bytes == 8) rex |= 0x08;
+            if (reg & 8) rex |= 0x01;
+
+            if (rex != 0x40 || force_rex || (bytes == 1 && reg >= 4 && reg < 8))
+                u8(rex);
+
+            u8((uint8_t) (opcode | (reg & 7)));
+        }
+
+        void relocation(const std::string &symbol, as::relocation_kind kind, int64_t addend) {
+            relocations.push_back({ bytes.size(), symbol, kind, addend });
+        }
+    };
+
+    // The add/sub/cmp group: @base is the opcode of the "r/m8, r8" form, @extension selects it for immediates
+    void encode_alu(code_buffer &out, uint8_t base, uint8_t extension, const operand_info &dest, const operand_info &src) {
+        const auto bytes = dest.kind == operand_kind::reg || src.kind != operand_kind::reg ? dest.bytes : src.bytes;
+        const auto wide = bytes != 1;
+
+        if (src.kind == operand_kind::imm) {
+            if (!wide) {
+                out.modrm_instruction({ 0x80 }, extension, false, dest, bytes);
+                out.u8((uint8_t) src.imm);
+            } else if (fits_i8(src.imm)) {
+                out.modrm_instruction({ 0x83 }, extension, false, dest, bytes);
+                out.u8((uint8_t) src.imm);
+            } else {
+                out.modrm_instruction({ 0x81 }, extension, false, dest, bytes);
+                out.immediate(src.imm, bytes == 2 ? 2 : 4);
+            }
+
+            return;
+        }
+
+        if (src.kind == operand_kind::reg) {
+            out.modrm_instruction({ (uint8_t) (base + wide) }, src.reg, true, dest, bytes);
+            return;
+        }
+
+        if (dest.kind != operand_kind::reg)
+            throw std::runtime_error("instruction with two memory operands cannot be encoded");
+
+        out.modrm_instruction({ (uint8_t) (base + 2 + wide) }, dest.reg, true, src, bytes);
+    }
+
+    void encode_mov(code_buffer &out, const operand_info &dest, const operand_info &src) {
+        // Mirrors the printer, which zeroes registers with xor
+        if (src.kind == operand_kind::imm && src.imm == 0 && dest.kind == operand_kind::reg) {
+            out.modrm_instruction({ dest.bytes == 1 ? (uint8_t) 0x30 : (uint8_t) 0x31 }, dest.reg, true, dest, dest.bytes);
+            return;
+        }
+
+        if (src.kind == operand_kind::symbol) {
+            if (dest.kind != operand_kind::reg)
+                throw std::runtime_error("symbol address can only be moved into a register");
+
+            // lea reg, [rip + symbol], which unlike an absolute address works wherever the code is loaded
+            out.u8((uint8_t) (0x48 | (dest.reg & 8) >> 1));
+            out.u8(0x8D);
+            out.u8((uint8_t) ((dest.reg & 7) << 3 | 0x05));
+            out.relocation(src.name, as::relocation_kind::pc_relative_32, -4);
+            out.u32(0);
+            return;
+        }
+
+        if (src.kind == operand_kind::imm) {
+            if (dest.kind == operand_kind::mem) {
+                if (dest.bytes == 8 && !fits_i32(src.imm))
+                    throw std::runtime_error("64 bit immediate cannot be stored to memory directly");
+
+                out.modrm_instruction({ dest.bytes == 1 ? (uint8_t) 0xC6 : (uint8_t) 0xC7 }, 0, false, dest, dest.bytes);
+                out.immediate(src.imm, std::min<size_t>(dest.bytes, 4));
+                return;
+            }
+
+            if (dest.bytes == 8 && fits_i32(src.imm)) {
+                out.modrm_instruction({ 0xC7 }, 0, false, dest, 8);
+                out.u32((uint32_t) src.imm);
+            } else if (dest.bytes == 8 && (uint64_t) src.imm <= UINT32_MAX) {
+                // The 32 bit form zero extends into the full register
+                out.register_in_opcode(0xB8, dest.reg, 4);
+                out.u32((uint32_t) src.imm);
+            } else {
+                out.register_in_opcode(dest.bytes == 1 ? 0xB0 : 0xB8, dest.reg, dest.bytes);
+                out.immediate(src.imm, dest.bytes);
+            }
+
+            return;
+        }
+
+        const auto bytes = src.kind == operand_kind::reg ? src.bytes : dest.bytes;
+        const auto wide = bytes != 1;
+
+        if (src.kind == operand_kind::reg) {
+            out.modrm_instruction({ (uint8_t) (0x88 + wide) }, src.reg, true, dest, bytes);
+            return;
+        }
+
+        if (dest.kind != operand_kind::reg)
+            throw std::runtime_error("mov between two memory operands cannot be encoded");
+
+        out.modrm_instruction({ (uint8_t) (0x8A + wide) }, dest.reg, true, src, bytes);
+    }
+
+    void encode_arithmetic(code_buffer &out, ir::block::arithmetic_type type, const operand_info &dest, const operand_info &src) {
+        switch (type) {
+            case ir::block::arithmetic_type::add:
+                encode_alu(out, 0x00, 0, dest, src);
+                return;
+            case ir::block::arithmetic_type::sub:
+                encode_alu(out, 0x28, 5, dest, src);
+                return;
+            case ir::block::arithmetic_type::mul:
+                if (dest.kind != operand_kind::reg || dest.bytes == 1)
+                    throw std::runtime_error("imul needs a 16, 32 or 64 bit register destination");
+
+                if (src.kind == operand_kind::imm) {
+                    const auto short_form = fits_i8(src.imm);
+
+                    out.modrm_instruction({ short_form ? (uint8_t) 0x6B : (uint8_t) 0x69 }, dest.reg, true, dest, dest.bytes);
+                    out.immediate(src.imm, short_form ? 1 : dest.bytes == 2 ? 2 : 4);
+                    return;
+                }
+
+                out.modrm_instruction({ 0x0F, 0xAF }, dest.reg, true, src, dest.bytes);
+                return;
+            default:
+                throw std::runtime_error("arithmetic instruction has no two operand encoding");
+        }
+    }
+
+    void encode_rsp_adjust(code_buffer &out, uint8_t extension, int64_t amount) {
+        const operand_info rsp { .kind = operand_kind::reg, .bytes = 8, .reg = hardware_register(context::rsp) };
+        encode_alu(out, extension == 5 ? 0x28 : 0x00, extension, rsp, { .kind = operand_kind::imm, .bytes = 8, .imm = amount });
+    }
+
+    void encode_stack_save(code_buffer &out, const context::function_context &context) {
+        if (context.needs_frame()) {
+            out.u8(0x55);
+            out.modrm_instruction({ 0x89 }, hardware_register(context::rsp), true,
+                                  { .kind = operand_kind::reg, .bytes = 8, .reg = hardware_register(context::rbp) }, 8);
+        }
+
+        if (context.current_stack_size != 0)
+            encode_rsp_adjust(out, 5, (int64_t) context.current_stack_size);
+
+        for (auto reg : context::callee_saved) {
+            if (context.must_preserve(reg))
+                out.register_in_opcode(0x50, hardware_register(reg), 4);
+        }
+
+        if (const auto padding = context.alignment_padding())
+            encode_rsp_adjust(out, 5, (int64_t) padding);
+    }
+
+    void encode_ret(code_buffer &out, const context::function_context &context, bool restore) {
+        if (restore) {
+            if (const auto padding = context.alignment_padding())
+                encode_rsp_adjust(out, 0, (int64_t) padding);
+
+            for (auto reg = std::rbegin(context::callee_saved); reg != std::rend(context::callee_saved); reg++) {
+                if (context.must_preserve(*reg))
+                    out.register_in_opcode(0x58, hardware_register(*reg), 4);
+            }
+
+            if (context.needs_frame())
+                out.u8(0xC9);
+        }
+
+        out.u8(0xC3);
+    }
+
+    void encode_push(code_buffer &out, const operand_info &op) {
+        switch (op.kind) {
+            case operand_kind::reg:
+                out.register_in_opcode(0x50, op.reg, 4);
+                return;
+            case operand_kind::imm:
+                if (fits_i8(op.imm)) {
+                    out.u8(0x6A);
+                    out.u8((uint8_t) op.imm);
+                } else {
+                    out.u8(0x68);
+                    out.u32((uint32_t) op.imm);
+                }
+                return;
+            case operand_kind::mem:
+                out.modrm_instruction({ 0xFF }, 6, false, op, 4);
+                return;
+            default:
+                throw std::runtime_error("symbol address cannot be pushed");
+        }
+    }
+
+    void encode_node(code_buffer &out, const context::function_context &context, const as::inst::asm_node &node) {
+        using namespace as::inst;
+
+        switch (node.kind) {
+            case asm_kind::stack_save:
+                encode_stack_save(out, context);
+                return;
+            case asm_kind::mov: {
+                const auto &mov = static_cast<const as::inst::mov &>(node);
+                encode_mov(out, describe(*mov.dest), describe(*mov.src));
+                return;
+            }
+            case asm_kind::lea: {
+                const auto &lea = static_cast<const as::inst::lea &>(node);
+                const auto dest = describe(*lea.dest);
+
+                if (dest.kind != operand_kind::reg)
+                    throw std::runtime_error("lea needs a register destination");
+
+                out.modrm_instruction({ 0x8D }, dest.reg, true, describe(*lea.ptr), dest.bytes);
+                return;
+            }
+            case asm_kind::cmov: {
+                // Printed as "cmov src, dest", src is the register written
+                const auto &cmov = static_cast<const as::inst::cmov &>(node);
+                const auto dest = describe(*cmov.src);
+
+                if (dest.kind != operand_kind::reg || dest.bytes == 1)
+                    throw std::runtime_error("cmov needs a 16, 32 or 64 bit register destination");
+
+                out.modrm_instruction({ 0x0F, (uint8_t) (0x40 | condition_code(cmov.type)) }, dest.reg, true,
+                                      describe(*cmov.dest), dest.bytes);
+                return;
+            }
+            case asm_kind::movsx: {
+                // Printed as "movsx src, dest" like cmov
+                const auto &movsx = static_cast<const as::inst::movsx &>(node);
+                const auto dest = describe(*movsx.src), src = describe(*movsx.dest);
+
+                if (dest.kind != operand_kind::reg)
+                    throw std::runtime_error("movsx needs a register destination");
+
+                if (src.bytes == 1)
+                    out.modrm_instruction({ 0x0F, 0xBE }, dest.reg, true, src, dest.bytes);
+                else if (src.bytes == 2)
+                    out.modrm_instruction({ 0x0F, 0xBF }, dest.reg, true, src, dest.bytes);
+                else if (src.bytes == 4 && dest.bytes == 8)
+                    out.modrm_instruction({ 0x63 }, dest.reg, true, src, 8);
+                else if (src.bytes == dest.bytes)
+                    encode_mov(out, dest, src);
+                else
+                    throw std::runtime_error("movsx cannot narrow its operand");
+
+                return;
+            }
+            case asm_kind::set: {
+                const auto &set = static_cast<const as::inst::set &>(node);
+                out.modrm_instruction({ 0x0F, (uint8_t) (0x90 | condition_code(set.type)) }, 0, false, describe(*set.op), 1);
+                return;
+            }
+            case asm_kind::cmp: {
+                const auto &cmp = static_cast<const as::inst::cmp &>(node);
+                encode_alu(out, 0x38, 7, describe(*cmp.oper1), describe(*cmp.oper2));
+                return;
+            }
+            case asm_kind::arithmetic: {
+                const auto &arithmetic = static_cast<const as::inst::arithmetic &>(node);
+                encode_arithmetic(out, arithmetic.type, describe(*arithmetic.oper1), describe(*arithmetic.oper2));
+                return;
+            }
+            case asm_kind::push:
+                encode_push(out, describe(*static_cast<const as::inst::push &>(node).op));
+                return;
+            case asm_kind::call:
+                out.u8(0xE8);
+                out.relocation(static_cast<const as::inst::call &>(node).function_name, as::relocation_kind::call_32, -4);
+                out.u32(0);
+                return;
+            case asm_kind::ret:
+                encode_ret(out, context, static_cast<const as::inst::ret &>(node).restore);
+                return;
+            case asm_kind::jmp:
+            case asm_kind::cond_jmp:
+                throw std::runtime_error("branches are encoded by encode_function");
+        }
+    }
+
+    // A run of encoded instructions, or a branch whose size is only known once relaxed
+    struct piece {
+        code_buffer code;
+
+        std::optional<size_t> target;
+        std::optional<uint8_t> condition;
+        bool near = false;
+
+        [[nodiscard]] size_t size() const {
+            if (!target)
+                return code.bytes.size();
+
+            if (!near)
+                return 2;
+
+            return condition ? 6 : 5;
+        }
+    };
+}
+
+as::encoded_function as::encode_function(const context::function_context &context, std::string name) {
+    std::unordered_map<std::string_view, size_t> label_index;
+
+    for (size_t b = 0; b < context.asm_blocks.size(); b++)
+        label_index.emplace(context.asm_blocks[b].name, b);
+
+    const auto find_label = [&](const std::string &label) {
+        const auto found = label_index.find(label);
+
+        if (found == label_index.end())
+            throw std::runtime_error("branch to unknown label " + label);
+
+        return found->second;
+    };
+
+    std::vector<piece> pieces;
+    std::vector<size_t> label_piece(context.asm_blocks.size());
+
+    for (size_t b = 0; b < context.asm_blocks.size(); b++) {
+        label_piece[b] = pieces.size();
+        pieces.emplace_back();
+
+        for (const auto &node : context.asm_blocks[b].nodes) {
+            if (!node->printable())
+                continue;
+
+            if (const auto *jmp = inst::asm_cast<inst::jmp>(node.get())) {
+                pieces.push_back({ .target = find_label(jmp->label_name) });
+                pieces.emplace_back();
+                continue;
+            }
+
+            if (const auto *cond_jmp = inst::asm_cast<inst::cond_jmp>(node.get())) {
+                pieces.push_back({ .target = find_label(cond_jmp->branch_name), .condition = condition_code(cond_jmp->type) });
+                pieces.emplace_back();
+                continue;
+            }
+
+            encode_node(pieces.back().code, context, *node);
+        }
+    }
+
+    // Widen branches until every one reaches its target, widening only ever moves targets
+    // further away so this settles
+    std::vector<size_t> offsets(pieces.size() + 1);
+
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (size_t p = 0; p < pieces.size(); p++)
+            offsets[p + 1] = offsets[p] + pieces[p].size();
+
+        for (size_t p = 0; p < pieces.size(); p++) {
+            auto &branch = pieces[p];
+
+            if (!branch.target || branch.near)
+                continue;
+
+            const auto displacement = (int64_t) offsets[label_piece[*branch.target]] - (int64_t) offsets[p + 1];
+
+            if (!fits_i8(displacement)) {
+                branch.near = true;
+                changed = true;
+            }
+        }
+    }
+
+    encoded_function result { .name = std::move(name) };
+    result.code.reserve(offsets.back());
+
+    for (size_t p = 0; p < pieces.size(); p++) {
+        auto &current = pieces[p];
+
+        if (!current.target) {
+            for (auto reloc : current.code.relocations) {
+                reloc.offset += result.code.size();
+                result.relocations.push_back(std::move(reloc));
+            }
+
+            result.code.insert(result.code.end(), current.code.bytes.begin(), current.code.bytes.end());
+            continue;
+        }
+
+        const auto displacement = (int64_t) offsets[label_piece[*current.target]] - (int64_t) offsets[p + 1];
+
+        code_buffer branch;
+
+        if (!current.near) {
+            branch.u8(current.condition ? (uint8_t) (0x70 | *current.condition) : (uint8_t) 0xEB);
+            branch.u8((uint8_t) displacement);
+        } else if (current.condition) {
+            branch.u8(0x0F);
+            branch.u8((uint8_t) (0x80 | *current.condition));
+            branch.u32((uint32_t) displacement);
+        } else {
+            branch.u8(0xE9);
+            branch.u32((uint32_t) displacement);
+        }
+
+        result.code.insert(result.code.end(), branch.bytes.begin(), branch.bytes.end());
+    }
+
+    return result;
+}
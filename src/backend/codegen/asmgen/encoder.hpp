@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace backend::context {
+    struct function_context;
+}
+
+namespace backend::as {
+    enum class relocation_kind : uint8_t {
+        // 32 bit displacement relative to the end of the field to a function, the target of a call
+        call_32,
+
+        // 32 bit displacement relative to the end of the field to data, e.g. a global string
+        pc_relative_32,
+    };
+
+    /**
+     *  A field at @offset in the encoded code which refers to @symbol, to be filled in once
+     *  its address is known, with its address plus @addend minus the field's own address.
+     */
+    struct relocation {
+        size_t offset;
+        std::string symbol;
+        relocation_kind kind;
+        int64_t addend;
+    };
+
+    struct encoded_function {
+        std::string name;
+        std::vector<uint8_t> code;
+        std::vector<relocation> relocations;
+    };
+
+    struct encoded_data {
+        std::string name;
+        std::vector<uint8_t> bytes;
+    };
+
+    /**
+     *  A module as x86-64 machine code rather than assembly text, functions are not placed
+     *  yet so calls and global references are left as relocations, also those between
+     *  functions of the same module.
+     */
+    struct encoded_module {
+        std::vector<encoded_function> functions;
+        std::vector<encoded_data> data;
+        std::vector<std::string> external_functions;
+    };
+
+    /**
+     *  Encodes the asm nodes of a generated function, the binary counterpart of printing
+     *  them. Branches are relaxed: each starts out in its 2 byte short form and is widened
+     *  to a rel32 near jump only if its target is out of reach.
+     *
+     *  Throws a std::runtime_error for instructions x86-64 has no encoding for, which the
+     *  text printer would leave for the assembler to reject (e.g. a memory to memory mov).
+     */
+    encoded_function encode_function(const context::function_context &context, std::string name);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdlib>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "asm_nodes.hpp"
+
+namespace backend::as::op {
+    struct reg : backend::as::op::operand_t {
+        backend::context::register_t index;
+
+        explicit reg(ir::value_size size, backend::context::register_t index)
+                : operand_t(operand_types::reg, size), index(index) {}
+        ~reg() override = default;
+
+        [[nodiscard]] std::string get_value() const override {
+            if (address) {
+                return context::get_stack_prefix(size)
+                    .append("[")
+                    .append(backend::context::register_as_string(index, ir::value_size::ptr))
+                    .append("]");
+            } else {
+                return backend::context::register_as_string(index, size);
+            }
+        }
+
+        [[nodiscard]] bool equals(const operand_t& other) override {
+            if (other.type != operand_types::reg)
+                return false;
+
+            return static_cast<const reg&>(other).index == index;
+        }
+
+        [[nodiscard]] std::optional<backend::context::register_t> direct_register() const override {
+            return address ? std::nullopt : std::make_optional(index);
+        }
+
+        [[nodiscard]] bool in_frame() const override {
+            return address && index == backend::context::register_t::rbp;
+        }
+    };
+
+    struct imm : backend::as::op::operand_t {
+        uint64_t val;
+
+        explicit imm(ir::value_size size, uint64_t val)
+                : operand_t(operand_types::literal, size), val(val) {}
+        ~imm() override = default;
+
+        [[nodiscard]] std::string get_value() const override {
+            return std::to_string(val);
+        }
+        [[nodiscard]] bool equals(const operand_t& other) override {
+            if (other.type != operand_types::literal)
+                return false;
+
+            return static_cast<const imm&>(other).val == val;
+        }
+    };
+
+    struct stack_memory : operand_t {
+        int64_t rbp_off;
+
+        explicit stack_memory(ir::value_size size, int64_t rbp_off)
+                : operand_t(operand_types::stack_mem, size), rbp_off(rbp_off) {}
+
+        [[nodiscard]] std::string get_value() const override {
+            std::stringstream ss;
+
+            if (!this->address)
+                ss << context::get_stack_prefix(size);
+
+            ss << "[rbp";
+
+            if (rbp_off != 0) {
+                ss << ((rbp_off < 0) ? " - " : " + ");
+                ss << std::abs(rbp_off);
+            }
+
+            ss << "]";
+
+            return ss.str();
+        }
+        [[nodiscard]] bool equals(const operand_t& other) override {
+            if (other.type != operand_types::stack_mem)
+                return false;
+
+            return static_cast<const stack_memory&>(other).rbp_off == rbp_off;
+        }
+
+        [[nodiscard]] bool in_frame() const override {
+            return true;
+        }
+    };
+
+    struct complex_ptr : operand_t {
+        int64_t base;
+
+        std::optional<backend::context::register_t> reg;
+        std::optional<int8_t> reg_scale;
+        std::optional<backend::context::register_t> unscaled_reg;
+
+        explicit complex_ptr(ir::value_size size, const backend::context::memory_addr &addr)
+                : operand_t(operand_types::complex_ptr, size), base(addr.offset) {
+            if (addr.scaled.has_value()) {
+                reg = addr.scaled->reg;
+                reg_scale = addr.scaled->scale;
+            }
+
+            if (addr.unscaled.has_value())
+                unscaled_reg = addr.unscaled;
+        }
+
+        [[nodiscard]] std::string get_value() const override {
+            std::stringstream ss;
+
+            if (!this->address)
+                ss << context::get_stack_prefix(size);
+
+            ss << "[";
+
+            if (reg_scale) {
+                if (*reg_scale != 1)
+                    ss << (int) *reg_scale << " * ";
+
+                ss << backend::context::register_as_string(*reg, ir::value_size::ptr);
+
+                ss << " + ";
+            }
+
+            if (unscaled_reg.has_value()) {
+                ss << backend::context::register_as_string(*unscaled_reg, ir::value_size::ptr);
+            }
+
+            if (base != 0) {
+                ss << ((base < 0) ? " - " : " + ");
+                ss << std::abs(base);
+            }
+
+            ss << "]";
+
+            return ss.str();
+        }
+        [[nodiscard]] bool equals(const operand_t& other) override {
+            if (other.type != operand_types::complex_ptr)
+                return false;
+
+            auto &other_ptr = static_cast<const complex_ptr&>(other);
+            return other_ptr.base == base && other_ptr.reg == reg && other_ptr.reg_scale == reg_scale;
+        }
+
+        [[nodiscard]] bool in_frame() const override {
+            return reg == backend::context::register_t::rbp || unscaled_reg == backend::context::register_t::rbp;
+        }
+    };
+
+    struct global_pointer : operand_t {
+        std::string name;
+
+        explicit global_pointer(std::string name)
+                : operand_t(operand_types::global_ptr, ir::value_size::ptr), name(std::move(name)) {}
+
+        [[nodiscard]] std::string get_value() const override {
+            return name;
+        }
+        [[nodiscard]] bool equals(const operand_t& other) override {
+            return other.type == operand_types::global_ptr;
+        }
+    };
+}
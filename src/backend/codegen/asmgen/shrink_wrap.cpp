@@ -0,0 +1,123 @@
+#include "shrink_wrap.hpp"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+#include "../context/function_context.hpp"
+
+using namespace backend;
+
+namespace {
+    std::vector<std::vector<size_t>> find_successors(const std::vector<as::label> &blocks) {
+        std::unordered_map<std::string_view, size_t> index;
+
+        for (size_t b = 0; b < blocks.size(); b++)
+            index.emplace(blocks[b].name, b);
+
+        std::vector<std::vector<size_t>> successors(blocks.size());
+
+        for (size_t b = 0; b < blocks.size(); b++) {
+            bool falls_through = true;
+
+            for (const auto &node : blocks[b].nodes) {
+                if (const auto *jmp = as::inst::asm_cast<as::inst::jmp>(node.get())) {
+                    successors[b].push_back(index.at(jmp->label_name));
+                    falls_through = false;
+                } else if (const auto *cond_jmp = as::inst::asm_cast<as::inst::cond_jmp>(node.get())) {
+                    successors[b].push_back(index.at(cond_jmp->branch_name));
+                } else if (node->kind == as::inst::asm_kind::ret) {
+                    falls_through = false;
+                }
+            }
+
+            if (falls_through && b + 1 < blocks.size())
+                successors[b].push_back(b + 1);
+        }
+
+        return successors;
+    }
+}
+
+void as::shrink_wrap(context::function_context &context) {
+    auto &blocks = context.asm_blocks;
+
+    std::vector<bool> region(blocks.size(), false);
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (const auto &node : blocks[b].nodes) {
+            node->for_each_operand([&](const op::operand_t &operand, bool written) {
+                const auto reg = operand.direct_register();
+
+                if ((written && reg && context.must_preserve(*reg)) || (context.needs_frame() && operand.in_frame()))
+                    region[b] = true;
+            });
+
+            // rsp is only aligned for calls once the saves and padding are in place
+            if (node->kind == inst::asm_kind::call)
+                region[b] = true;
+        }
+    }
+
+    // Saves needed from the first block on stay in the prologue
+    if (blocks.size() > 1 && region[1])
+        region[0] = true;
+
+    const auto successors = find_successors(blocks);
+    std::vector<std::vector<size_t>> predecessors(blocks.size());
+
+    for (size_t b = 0; b < blocks.size(); b++)
+        for (auto successor : successors[b])
+            predecessors[successor].push_back(b);
+
+    // Grow the region until it is closed under successors and every block in it is
+    // entered either only from inside it or only from outside it
+    std::vector<size_t> worklist;
+
+    for (size_t b = 0; b < blocks.size(); b++)
+        if (region[b])
+            worklist.push_back(b);
+
+    while (!worklist.empty()) {
+        const auto b = worklist.back();
+        worklist.pop_back();
+
+        const auto add = [&](size_t block) {
+            if (region[block])
+                return;
+
+            region[block] = true;
+            worklist.push_back(block);
+        };
+
+        for (auto successor : successors[b])
+            add(successor);
+
+        // Being inside, this block enters its successors from inside
+        for (auto successor : successors[b])
+            for (auto pred : predecessors[successor])
+                add(pred);
+    }
+
+    if (!blocks.empty() && !region[0]) {
+        for (auto &node : blocks[0].nodes)
+            if (node->kind == inst::asm_kind::stack_save)
+                node->is_valid = false;
+    }
+
+    for (size_t b = 1; b < blocks.size(); b++) {
+        if (region[b]) {
+            const auto entered_from_inside = std::any_of(predecessors[b].begin(), predecessors[b].end(),
+                                                         [&](size_t pred) { return region[pred]; });
+
+            if (!entered_from_inside)
+                blocks[b].nodes.insert(blocks[b].nodes.begin(), std::make_unique<inst::stack_save>());
+
+            continue;
+        }
+
+        for (auto &node : blocks[b].nodes)
+            if (auto *ret = inst::asm_cast<inst::ret>(node.get()))
+                ret->restore = false;
+    }
+}
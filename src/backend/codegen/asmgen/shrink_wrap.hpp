@@ -0,0 +1,20 @@
+#pragma once
+
+namespace backend::context {
+    struct function_context;
+}
+
+namespace backend::as {
+    /**
+     *  Moves the register saves and stack frame setup of a generated function out of
+     *  its prologue, onto the paths that need them. The saves are placed at the blocks
+     *  entering the smallest region that covers every block clobbering a saved register,
+     *  touching the frame or making a call, is closed under successors (so every path through it ends
+     *  in a return that restores), and is only entered from outside. Returns outside the
+     *  region leave without restoring anything.
+     *
+     *  E.g. the base case of a recursive function no longer pays for the saves of its
+     *  recursive case.
+     */
+    void shrink_wrap(context::function_context &context);
+}
@@ -0,0 +1,450 @@
+#include "block_state.hpp"
+
+#include <array>
+#include <span>
+#include <stdexcept>
+
+#include "asmgen/asm_nodes.hpp"
+#include "context/function_context.hpp"
+#include "../instrumentation.hpp"
+
+using namespace backend;
+
+namespace {
+    using context::virtual_memory;
+
+    using node_list = std::vector<std::unique_ptr<as::inst::asm_node>>;
+
+    // Where the values are at the end of a block, the storage state but for the last instruction's result
+    struct exit_state {
+        context::function_context &context;
+        std::optional<std::pair<ir::symbol_id, virtual_memory*>> defined;
+
+        [[nodiscard]] virtual_memory *find(ir::symbol_id id) const {
+            if (defined && defined->first == id)
+                return defined->second;
+
+            return context.storage.has_value(id) ? context.storage.value_map[id] : nullptr;
+        }
+    };
+
+    // A move on an edge into a block, from wherever the value is before it or from a literal
+    struct edge_copy {
+        virtual_memory *destination;
+        ir::value_size size;
+
+        virtual_memory *source = nullptr;
+        std::optional<ir::int_literal> literal;
+    };
+
+    const ir::block::block_instruction *phi_defining(const ir::block::block &block, ir::symbol_id id) {
+        for (const auto &instruction : block.instructions) {
+            if (instruction.type() == ir::block::node_type::phi && instruction.assigned_to && instruction.assigned_to->name.id == id)
+                return &instruction;
+        }
+
+        return nullptr;
+    }
+
+    // The operand @phi takes when entered from the block labelled @from
+    const ir::value *incoming(const ir::block::block_instruction &phi, ir::symbol_id from) {
+        const auto &labels = std::get<ir::block::phi>(phi.inst).labels;
+
+        for (size_t i = 0; i < labels.size() && i < phi.operands.size(); i++) {
+            if (labels[i].id == from)
+                return &phi.operands[i];
+        }
+
+        return nullptr;
+    }
+
+    /**
+     *  Decides where @block keeps its live-in variables and phis, from the state at the end
+     *  of the predecessor @from, or at the start of the block when it is generated before
+     *  any of its predecessors. Live-in variables stay where they are, a phi takes the
+     *  register its allocation gives it, else the register of its incoming value when
+     *  that value isn't needed after the edge, else the first one free.
+     */
+    std::vector<context::entry_location> decide_entry(context::function_context &context, const ir::global::function &function,
+                                                      size_t block, const exit_state &state, std::optional<size_t> from) {
+        std::vector<context::entry_location> entry;
+        std::array<bool, context::register_count> taken {};
+
+        for (const auto id : function.metadata->live_in[block]) {
+            auto *vmem = state.find(id);
+
+            if (!vmem)
+                continue;
+
+            const auto size = context.blocks->sizes[id];
+            entry.push_back({ id, vmem, size == ir::value_size::none ? vmem->size : size });
+
+            if (const auto *reg = context::vmem_cast<context::register_storage>(vmem))
+                taken[reg->reg] = true;
+        }
+
+        auto position = context.blocks->first_position[block];
+
+        for (const auto &instruction : function.blocks[block].instructions) {
+            position++;
+
+            if (instruction.type() != ir::block::node_type::phi || !instruction.assigned_to || instruction.operands.empty())
+                continue;
+
+            const auto id = instruction.assigned_to->name.id;
+            const bool across_call = context.live_across_call[id];
+
+            // Sized like its operands, as the parser sizes the variable it assigns, see block_instruction::finalize
+            const auto size = instruction.operands.back().get_size();
+
+            std::optional<context::register_t> chosen;
+
+            if (context.allocation) {
+                const auto *segment = context.allocation->segment_at(id, position);
+
+                if (segment && segment->reg && !taken[*segment->reg])
+                    chosen = *segment->reg;
+            }
+
+            if (!chosen && from) {
+                const auto *operand = incoming(instruction, function.blocks[*from].name.id);
+                const auto *reg = operand && operand->is_variable()
+                    ? context::vmem_cast<context::register_storage>(state.find(operand->get_id()))
+                    : nullptr;
+
+                if (reg && !taken[reg->reg] && (!across_call || register_save_class(reg->reg) == context::save_class::callee_saved))
+                    chosen = reg->reg;
+            }
+
+            const auto first_free = [&](std::span<const context::register_t> order, bool owned) -> std::optional<context::register_t> {
+                for (auto reg : order) {
+                    if (!taken[reg] && (owned || !context.storage.registers[reg]->in_use()))
+                        return reg;
+                }
+
+                return std::nullopt;
+            };
+
+            if (!chosen && across_call)
+                chosen = first_free(context::callee_saved, false);
+
+            if (!chosen)
+                chosen = first_free(context::allocatable, false);
+
+            // Values not needed in the block are only overwritten on the edges into it
+            if (!chosen)
+                chosen = first_free(context::allocatable, true);
+
+            if (chosen) {
+                taken[*chosen] = true;
+                entry.push_back({ id, context.storage.register_ref(*chosen), size });
+                continue;
+            }
+
+            instrument::count(instrument::counter::spills);
+
+            auto *slot = context::stack_allocate(context, ir::size_in_bytes(size));
+            slot->size = size;
+            entry.push_back({ id, slot, size });
+        }
+
+        return entry;
+    }
+
+    /**
+     *  Orders @copies so that no value is overwritten before it is read. Once every
+     *  destination left is still to be read, the copies form cycles, and one value is
+     *  set aside in a register no copy or live-in variable is using to break them.
+     *  Memory is moved to memory through such a register too.
+     */
+    node_list parallel_copy(context::function_context &context, std::vector<edge_copy> copies,
+                            const std::vector<context::entry_location> &entry) {
+        node_list moves;
+
+        const auto is_read = [&](const virtual_memory *vmem, size_t except) {
+            for (size_t i = 0; i < copies.size(); i++) {
+                if (i != except && copies[i].source == vmem)
+                    return true;
+            }
+
+            return false;
+        };
+
+        // Registers holding a value the copies leave alone, lent out when no other is free and restored after them
+        std::vector<std::pair<context::register_storage*, context::memory_addr*>> borrowed;
+
+        const auto copied = [&](const virtual_memory *storage) {
+            for (const auto &copy : copies) {
+                if (copy.source == storage || copy.destination == storage)
+                    return true;
+            }
+
+            return false;
+        };
+
+        const auto kept = [&](const virtual_memory *storage) {
+            for (const auto &location : entry) {
+                if (location.vmem == storage)
+                    return true;
+            }
+
+            return false;
+        };
+
+        const auto scratch = [&]() {
+            for (auto reg : context::allocatable) {
+                const auto *storage = context.storage.registers[reg].get();
+
+                if (!copied(storage) && !kept(storage))
+                    return context.storage.register_ref(reg);
+            }
+
+            for (const auto &[storage, slot] : borrowed) {
+                if (!copied(storage))
+                    return storage;
+            }
+
+            for (auto reg : context::allocatable) {
+                if (copied(context.storage.registers[reg].get()))
+                    continue;
+
+                instrument::count(instrument::counter::spills);
+
+                auto *slot = context::stack_allocate(context, ir::size_in_bytes(ir::value_size::i64));
+                slot->size = ir::value_size::i64;
+
+                moves.emplace_back(std::make_unique<as::inst::mov>(
+                    as::create_operand(slot, ir::value_size::i64),
+                    as::create_operand(reg, ir::value_size::i64)
+                ));
+
+                borrowed.emplace_back(context.storage.register_ref(reg), slot);
+                return borrowed.back().first;
+            }
+
+            throw std::runtime_error("no register left to move values between blocks through");
+        };
+
+        const auto emit = [&](const edge_copy &copy) {
+            auto source = copy.literal
+                ? as::create_operand(*copy.literal, copy.size)
+                : as::create_operand(copy.source, copy.size);
+
+            // Memory can't be moved to memory, nor a 64 bit immediate stored directly
+            const bool to_memory = context::vmem_cast<context::memory_addr>(copy.destination);
+            const bool through_register = to_memory && (copy.literal
+                ? (int64_t) copy.literal->value != (int32_t) copy.literal->value
+                : copy.source->kind == context::vmem_kind::memory_addr);
+
+            if (through_register) {
+                auto *reg = scratch();
+
+                moves.emplace_back(std::make_unique<as::inst::mov>(as::create_operand(reg->reg, copy.size), std::move(source)));
+                source = as::create_operand(reg->reg, copy.size);
+            }
+
+            moves.emplace_back(std::make_unique<as::inst::mov>(as::create_operand(copy.destination, copy.size), std::move(source)));
+        };
+
+        while (!copies.empty()) {
+            size_t ready = 0;
+
+            while (ready < copies.size() && is_read(copies[ready].destination, ready))
+                ready++;
+
+            if (ready < copies.size()) {
+                emit(copies[ready]);
+                copies.erase(copies.begin() + (ptrdiff_t) ready);
+                continue;
+            }
+
+            const auto *blocked = copies.front().destination;
+            auto *aside = scratch();
+            auto size = copies.front().size;
+
+            for (const auto &copy : copies) {
+                if (copy.source == blocked)
+                    size = copy.size;
+            }
+
+            moves.emplace_back(std::make_unique<as::inst::mov>(as::create_operand(aside->reg, size), as::create_operand(blocked, size)));
+
+            for (auto &copy : copies) {
+                if (copy.source == blocked)
+                    copy.source = aside;
+            }
+        }
+
+        for (const auto &[storage, slot] : borrowed) {
+            moves.emplace_back(std::make_unique<as::inst::mov>(
+                as::create_operand(storage->reg, ir::value_size::i64),
+                as::create_operand(slot, ir::value_size::i64)
+            ));
+        }
+
+        return moves;
+    }
+
+    // The moves on the edge from @from to @to, deciding where @to keeps its values if no edge has yet
+    node_list gen_edge(context::function_context &context, const ir::global::function &function,
+                       size_t from, size_t to, const exit_state &state) {
+        auto &entry = context.blocks->entries[to];
+
+        if (!entry)
+            entry = decide_entry(context, function, to, state, from);
+
+        const auto from_label = function.blocks[from].name.id;
+        std::vector<edge_copy> copies;
+
+        for (const auto &location : *entry) {
+            edge_copy copy { location.vmem, location.size };
+
+            if (const auto *phi = phi_defining(function.blocks[to], location.id)) {
+                const auto *operand = incoming(*phi, from_label);
+
+                if (!operand)
+                    continue;
+
+                if (operand->is_variable())
+                    copy.source = state.find(operand->get_id());
+                else
+                    copy.literal = std::get<ir::int_literal>(operand->val);
+            } else {
+                copy.source = state.find(location.id);
+            }
+
+            if ((!copy.source && !copy.literal) || copy.source == copy.destination)
+                continue;
+
+            copies.push_back(copy);
+        }
+
+        return parallel_copy(context, std::move(copies), *entry);
+    }
+}
+
+context::block_states::block_states(const ir::global::function &function)
+    :   flow(function),
+        first_position(function.blocks.size(), 0),
+        sizes(function.symbols.size(), ir::value_size::none),
+        entries(function.blocks.size()) {
+    uint32_t position = 0;
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        first_position[b] = position;
+        position += (uint32_t) function.blocks[b].instructions.size();
+
+        for (const auto &instruction : function.blocks[b].instructions) {
+            for (const auto &operand : instruction.operands) {
+                if (operand.is_variable())
+                    sizes[operand.get_id()] = operand.get_size();
+            }
+        }
+    }
+}
+
+void context::enter_block(function_context &context, const ir::global::function &function, size_t block) {
+    auto &entry = context.blocks->entries[block];
+
+    if (!entry)
+        entry = decide_entry(context, function, block, exit_state { context, std::nullopt }, std::nullopt);
+
+    auto &storage = context.storage;
+
+    // Whatever else holds the registers the block's values are kept in was left by another path
+    for (const auto &location : *entry) {
+        if (storage.has_value(location.id))
+            storage.erase_value(location.id);
+    }
+
+    for (const auto &location : *entry) {
+        const auto *reg = vmem_cast<register_storage>(location.vmem);
+
+        if (reg && reg->in_use())
+            storage.erase_value(reg->owner);
+    }
+
+    for (const auto &location : *entry) {
+        auto *reg = vmem_cast<register_storage>(location.vmem);
+
+        if (reg)
+            reg->size = location.size;
+
+        storage.map_value(location.id, location.vmem);
+
+        if (reg)
+            reg->frozen = false;
+    }
+}
+
+void context::leave_block(function_context &context, const ir::global::function &function, size_t block,
+                          std::optional<std::pair<ir::symbol_id, virtual_memory*>> defined) {
+    const exit_state state { context, defined };
+    const auto &flow = context.blocks->flow;
+    const auto &instructions = function.blocks[block].instructions;
+    const auto asm_index = context.block_index[function.blocks[block].name.id];
+
+    const auto target_name = [&](size_t target) {
+        return std::string { context.symbols.name(function.blocks[target].name) };
+    };
+
+    const auto terminator = instructions.empty() ? std::nullopt : std::optional { instructions.back().type() };
+
+    if (terminator == ir::block::node_type::ret)
+        return;
+
+    if (terminator == ir::block::node_type::jmp) {
+        const auto target = flow.block_of[std::get<ir::block::jmp>(instructions.back().inst).label.id];
+
+        if (target == SIZE_MAX)
+            return;
+
+        auto moves = gen_edge(context, function, block, target, state);
+        auto &nodes = context.asm_blocks[asm_index].nodes;
+
+        nodes.insert(nodes.end() - 1, std::make_move_iterator(moves.begin()), std::make_move_iterator(moves.end()));
+        return;
+    }
+
+    if (terminator == ir::block::node_type::branch) {
+        const auto &branch = std::get<ir::block::branch>(instructions.back().inst);
+        const auto true_target = flow.block_of[branch.true_branch.id];
+        const auto false_target = flow.block_of[branch.false_branch.id];
+
+        if (true_target == SIZE_MAX || false_target == SIZE_MAX)
+            return;
+
+        auto true_moves = gen_edge(context, function, block, true_target, state);
+        auto false_moves = gen_edge(context, function, block, false_target, state);
+
+        // After the conditional jump, so the flags are no longer needed
+        auto &nodes = context.asm_blocks[asm_index].nodes;
+        auto *cond_jmp = as::inst::asm_cast<as::inst::cond_jmp>(nodes[nodes.size() - 2].get());
+
+        nodes.insert(nodes.end() - 1, std::make_move_iterator(false_moves.begin()), std::make_move_iterator(false_moves.end()));
+
+        if (true_moves.empty())
+            return;
+
+        // The taken edge's moves get a block of their own to jump to, which may move every block
+        auto edge = std::string("__").append(std::to_string(asm_index)).append("_edge")
+            .append(std::to_string(context.asm_blocks.size()));
+
+        cond_jmp->branch_name = edge;
+
+        auto &edge_block = context.asm_blocks.emplace_back(std::move(edge));
+        edge_block.nodes = std::move(true_moves);
+        edge_block.nodes.emplace_back(std::make_unique<as::inst::jmp>(target_name(true_target)));
+
+        context.current_label = &context.asm_blocks[asm_index];
+        return;
+    }
+
+    if (block + 1 >= function.blocks.size())
+        return;
+
+    auto moves = gen_edge(context, function, block, block + 1, state);
+    auto &nodes = context.asm_blocks[asm_index].nodes;
+
+    nodes.insert(nodes.end(), std::make_move_iterator(moves.begin()), std::make_move_iterator(moves.end()));
+}
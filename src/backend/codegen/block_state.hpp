@@ -0,0 +1,52 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "valuegen.hpp"
+#include "../ir_optimizer/analyses.hpp"
+
+namespace backend::context {
+    struct function_context;
+
+    // Where the variable @id is kept on entry to a block
+    struct entry_location {
+        ir::symbol_id id;
+        virtual_memory *vmem;
+        ir::value_size size;
+    };
+
+    /**
+     *  Blocks are generated one after the other with a single storage state, but a block
+     *  can be entered from several places, each leaving the values it needs somewhere else.
+     *  The first edge into a block to be generated decides where the block's live-in
+     *  variables and phis are kept, and every edge into it moves them there on the way,
+     *  which is also how phis are given their incoming values.
+     */
+    struct block_states {
+        opt::control_flow flow;
+
+        // Indexed by block index, the number of instructions before the block, as md::live_range counts them
+        std::vector<uint32_t> first_position;
+
+        // Indexed by symbol id, the size the variable is read at, as storage may be larger than its value
+        std::vector<ir::value_size> sizes;
+
+        // Indexed by block index, decided by the first edge into the block to be generated
+        std::vector<std::optional<std::vector<entry_location>>> entries;
+
+        explicit block_states(const ir::global::function &function);
+    };
+
+    // Switches the storage state to where the values are kept on entry to @block
+    void enter_block(function_context &context, const ir::global::function &function, size_t block);
+
+    /**
+     *  Moves the values leaving @block to where its successors expect them, on the edges
+     *  the block's terminator has already been generated for, or at the end of the block
+     *  if it falls through. Called before the values the last instruction dropped are
+     *  erased, with @defined being that instruction's result, which isn't mapped yet.
+     */
+    void leave_block(function_context &context, const ir::global::function &function, size_t block,
+                     std::optional<std::pair<ir::symbol_id, virtual_memory*>> defined);
+}
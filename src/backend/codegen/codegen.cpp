@@ -1,37 +1,174 @@
+#include <algorithm>
 #include <sstream>
 
 #include "codegen.hpp"
+#include "block_state.hpp"
 #include "context/function_context.hpp"
 #include "instructions.hpp"
 #include "asmgen/asm_nodes.hpp"
+#include "asmgen/shrink_wrap.hpp"
 #include "context/value_reference.hpp"
+#include "regalloc/graph_coloring.hpp"
+#include "regalloc/linear_scan.hpp"
+#include "../compile_cache.hpp"
+#include "../instrumentation.hpp"
+#include "../parallel.hpp"
 
-void backend::context::generate(const ir::root& root, std::ostream& ostream) {
-    std::vector<std::unique_ptr<global_pointer>> global_strings;
+void backend::context::generate(const ir::root& root, std::ostream& ostream, const compile_options &options,
+                                std::span<const cached_function> cached) {
+    module_output output { ostream };
 
-    ostream << "[bits 64]\n";
+    gen_header(output);
 
-    ostream << "section .global_strings\n";
+    output.switch_section("global_strings");
     for (const auto& global_string : root.global_strings) {
-        ostream << global_string.name << " db \"" << global_string.value << "\", 0\n";
-        global_strings.emplace_back(std::make_unique<global_pointer>(global_string.name));
+        gen_global_string(output, global_string);
     }
 
-    ostream << "section .external_functions\n";
+    output.switch_section("external_functions");
     for (const auto& extern_function : root.extern_functions) {
-        ostream << "extern " << extern_function.name << '\n';
+        gen_extern_function(output, extern_function);
     }
 
-    ostream << "section .text\n";
-    for (const auto& function : root.functions) {
-        gen_function(root, ostream, function, global_strings);
+    output.switch_section("text");
+
+    const auto function_text = [&](size_t i) {
+        if (!cached.empty() && cached[i].text)
+            return *cached[i].text;
+
+        std::stringstream buffer;
+        gen_function(root, buffer, root.functions[i], output.global_strings, options);
+
+        auto text = std::move(buffer).str();
+
+        if (!cached.empty())
+            options.cache->store(cached[i].key, text);
+
+        return text;
+    };
+
+    if (options.threads <= 1) {
+        for (size_t i = 0; i < root.functions.size(); i++) {
+            if (cached.empty())
+                gen_function(root, ostream, root.functions[i], output.global_strings, options);
+            else
+                ostream << function_text(i);
+        }
+
+        return;
     }
+
+    // Functions are generated into their own buffers and spliced in source order,
+    // so the output is identical to generating them one after the other.
+    std::vector<std::string> function_output(root.functions.size());
+
+    backend::parallel_for(root.functions.size(), options.threads, [&](size_t i) {
+        function_output[i] = function_text(i);
+    });
+
+    for (const auto &text : function_output) {
+        ostream << text;
+    }
+}
+
+void backend::context::module_output::switch_section(std::string_view name) {
+    if (section == name)
+        return;
+
+    section = name;
+    ostream << "section ." << name << '\n';
+}
+
+void backend::context::gen_header(module_output &output) {
+    output.ostream << "[bits 64]\n";
+}
+
+void backend::context::gen_global_string(module_output &output, const ir::global::global_string &global_string) {
+    output.switch_section("global_strings");
+
+    output.ostream << global_string.name << " db \"" << global_string.value << "\", 0\n";
+    output.global_strings.emplace_back(std::make_unique<global_pointer>(global_string.name));
+}
+
+void backend::context::gen_extern_function(module_output &output, const ir::global::extern_function &extern_function) {
+    output.switch_section("external_functions");
+
+    output.ostream << "extern " << extern_function.name << '\n';
+}
+
+namespace {
+    void count_output(const backend::context::function_context &context, const ir::global::function &function) {
+        using namespace backend;
+
+        if (!instrument::active_profile.load(std::memory_order_relaxed))
+            return;
+
+        for (const auto &block : function.blocks)
+            instrument::count(instrument::counter::instructions_in, block.instructions.size());
+
+        for (const auto &block : context.asm_blocks) {
+            for (const auto &node : block.nodes) {
+                if (node->printable())
+                    instrument::count(instrument::counter::asm_nodes_out);
+                else if (node->kind == as::inst::asm_kind::mov)
+                    instrument::count(instrument::counter::movs_elided);
+            }
+        }
+
+        for (auto reg : context::callee_saved) {
+            if (context.must_preserve(reg))
+                instrument::count(instrument::counter::registers_pushed);
+        }
+    }
+}
+
+backend::as::encoded_module backend::context::encode(const ir::root &root, const compile_options &options) {
+    as::encoded_module module;
+    std::vector<std::unique_ptr<global_pointer>> global_strings;
+
+    for (const auto &global_string : root.global_strings) {
+        auto &data = module.data.emplace_back(as::encoded_data { global_string.name });
+        data.bytes.assign(global_string.value.begin(), global_string.value.end());
+        data.bytes.push_back(0);
+
+        global_strings.emplace_back(std::make_unique<global_pointer>(global_string.name));
+    }
+
+    for (const auto &extern_function : root.extern_functions)
+        module.external_functions.emplace_back(extern_function.name);
+
+    module.functions.resize(root.functions.size());
+
+    backend::parallel_for(root.functions.size(), options.threads, [&](size_t i) {
+        const auto &function = root.functions[i];
+        instrument::function_span span { function };
+
+        // Nothing is printed, but the context still needs somewhere to print to
+        std::stringstream unused;
+
+        backend::context::function_context context {
+            .return_type = function.return_type,
+            .ostream = unused,
+            .global_strings = global_strings,
+            .symbols = function.symbols,
+        };
+
+        lower_function(context, function, options);
+
+        instrument::phase_timer timer { instrument::phase::encode };
+        module.functions[i] = as::encode_function(context, function.name);
+    });
+
+    return module;
 }
 
 void backend::context::gen_function(const ir::root &,
                                     std::ostream &ostream,
                                     const ir::global::function &function,
-                                    std::vector<std::unique_ptr<global_pointer>> &global_strings) {
+                                    std::vector<std::unique_ptr<global_pointer>> &global_strings,
+                                    const compile_options &options) {
+    instrument::function_span span { function };
+
     ostream << "\nglobal " << function.name << "\n\n";
     ostream << function.name << ':' << '\n';
 
@@ -39,40 +176,122 @@ void backend::context::gen_function(const ir::root &,
         .return_type = function.return_type,
         .ostream = ostream,
         .global_strings = global_strings,
+        .symbols = function.symbols,
     };
 
+    lower_function(context, function, options);
+
+    instrument::phase_timer timer { instrument::phase::print };
+
+    for (const auto &block : context.asm_blocks) {
+        ostream << '.' << block.name << ":\n";
+        for (const auto &inst : block.nodes) {
+            if (!inst->printable())
+                continue;
+
+            inst->print(context);
+            context.ostream << '\n';
+        }
+    }
+}
+
+void backend::context::lower_function(function_context &context, const ir::global::function &function,
+                                      const compile_options &options) {
+    instrument::phase_timer timer { instrument::phase::codegen };
+
+    context.storage.reserve_symbols(function.symbols);
+    context.block_index.assign(function.symbols.size(), -1);
+
+    regalloc::allocation allocation;
+
+    switch (options.regalloc) {
+        case regalloc_mode::greedy:
+            break;
+        case regalloc_mode::linear:
+            allocation = regalloc::linear_scan(function);
+            context.allocation = &allocation;
+            break;
+        case regalloc_mode::coloring:
+            allocation = regalloc::graph_coloring(function);
+            context.allocation = &allocation;
+            break;
+    }
+
     context.asm_blocks.emplace_back("__stacksave");
     context.current_label = &context.asm_blocks.back();
     context.add_asm_node<as::inst::stack_save>();
 
     for (size_t i = 0; i < function.parameters.size(); i++){
-        auto reg = backend::context::param_register(i);
-
-        auto &name = function.parameters[i].name;
+        auto id = function.parameters[i].name.id;
         auto &size = function.parameters[i].size;
 
-        context.storage.value_map[name] = context.storage.get_register(reg, size);
-        context.register_is_param[reg] = true;
+        if (i < param_register_count) {
+            // Owned like any other value, so the register is saved across calls while the parameter is live
+            context.storage.map_value(id, context.storage.get_register(param_register((uint8_t) i), size));
+            continue;
+        }
+
+        const auto offset = stack_argument_offset + (int64_t) ((i - param_register_count) * stack_argument_size);
+
+        context.storage.value_map[id] = context.storage.get_misc_storage<memory_addr>(size, offset);
+        context.stack_parameters = true;
     }
 
+    // Positions of the function's calls, numbered like md::live_range
+    std::vector<uint32_t> calls;
+    uint32_t position = 0;
+
     for (const auto &block : function.blocks) {
-        context.asm_blocks.emplace_back(block.name);
+        for (const auto &instruction : block.instructions) {
+            position++;
+
+            if (instruction.type() == ir::block::node_type::call)
+                calls.push_back(position);
+        }
+    }
+
+    context.makes_calls = !calls.empty();
+
+    const auto &ranges = function.metadata->live_ranges;
+    context.live_across_call.assign(function.symbols.size(), false);
+
+    for (ir::symbol_id id = 0; id < ranges.size(); id++) {
+        const auto call = std::upper_bound(calls.begin(), calls.end(), ranges[id].start);
+        context.live_across_call[id] = call != calls.end() && *call < ranges[id].end;
+    }
+
+    block_states states { function };
+    context.blocks = &states;
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        const auto &block = function.blocks[b];
+
+        context.block_index[block.name.id] = (int64_t) context.asm_blocks.size();
+        context.asm_blocks.emplace_back(std::string { function.symbols.name(block.name) });
         context.current_label = &context.asm_blocks.back();
 
+        enter_block(context, function, b);
+
         for (const auto &instruction : block.instructions) {
-            context.current_instruction = instruction.metadata.get();
+            context.current_instruction = &instruction;
+            context.current_position++;
+
+            regalloc::apply_splits(context);
 
-            for (size_t i = 0; i < instruction.metadata->dropped_data.size(); i++) {
-                if (!instruction.metadata->dropped_data[i]) continue;
+            for (size_t i = 0; i < instruction.metadata.dropped_data.size(); i++) {
+                if (!instruction.metadata.dropped_data[i]) continue;
                 if (!instruction.operands[i].is_variable()) continue;
 
                 auto var = context.storage.get_value(instruction.operands[i]);
 
                 if (!var.is_variable()) continue;
 
-                context.storage.pending_drop.emplace_back(*var.get_name());
+                context.storage.pending_drop.emplace_back(*var.get_symbol());
             }
 
+            for (const auto id : instruction.metadata.dropped_after)
+                context.storage.pending_drop.emplace_back(id);
+
             if (context.auto_drop_reassignable())
                 context.storage.drop_reassignable();
 
@@ -81,10 +300,18 @@ void backend::context::gen_function(const ir::root &,
             if (!context.auto_drop_reassignable())
                 context.storage.drop_reassignable();
 
+            if (&instruction == &block.instructions.back()) {
+                const auto defined = info.return_dest && instruction.assigned_to
+                    ? std::optional { std::pair { instruction.assigned_to->name.id, info.return_dest } }
+                    : std::nullopt;
+
+                leave_block(context, function, b, defined);
+            }
+
             context.storage.erase_reassignable();
 
             for (const auto &reg : context.storage.registers) {
-                if (reg->owner.starts_with("__temp"))
+                if (context.storage.is_temp(reg->owner))
                     reg->unclaim();
                 reg->frozen = false;
             }
@@ -96,18 +323,17 @@ void backend::context::gen_function(const ir::root &,
                 );
             }
         }
+
+        if (block.instructions.empty())
+            leave_block(context, function, b, std::nullopt);
     }
 
-    for (const auto &block : context.asm_blocks) {
-        ostream << '.' << block.name << ":\n";
-        for (const auto &inst : block.nodes) {
-            if (!inst->printable())
-                continue;
+    as::shrink_wrap(context);
+    count_output(context, function);
 
-            inst->print(context);
-            context.ostream << '\n';
-        }
-    }
+    // The allocation and block states are local to this function, and only needed while generating
+    context.allocation = nullptr;
+    context.blocks = nullptr;
 }
 
 backend::context::instruction_return backend::context::gen_instruction(backend::context::function_context &context, const ir::block::block_instruction &instruction) {
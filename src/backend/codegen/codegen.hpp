@@ -3,21 +3,69 @@
 #include <span>
 #include <unordered_map>
 #include <functional>
+#include <optional>
+#include <string>
 
 #include "registers.hpp"
 #include "valuegen.hpp"
 
 #include "asmgen/asm_nodes.hpp"
+#include "asmgen/encoder.hpp"
 #include "../../ir/node_prototypes.hpp"
 #include "../ir_analyzer/node_metadata.hpp"
+#include "../compile_options.hpp"
 
 namespace backend::context {
     struct instruction_return;
     struct virtual_memory;
 
-    void generate(const ir::root& root, std::ostream& ostream);
+    /**
+     *  Module level output state. Sections are only switched when the next node requires
+     *  a different one, so nodes can be emitted in the order they are encountered.
+     */
+    struct module_output {
+        std::ostream &ostream;
+        std::vector<std::unique_ptr<global_pointer>> global_strings {};
+        std::string_view section {};
+
+        void switch_section(std::string_view name);
+    };
+
+    /**
+     *  A function's key in options.cache, and its assembly if it was found there.
+     */
+    struct cached_function {
+        std::string key;
+        std::optional<std::string> text;
+    };
+
+    /**
+     *  Functions with cached assembly in @cached are copied to the output as is, the
+     *  others are generated and added to options.cache. Without @cached every function
+     *  is generated and the cache is not consulted.
+     */
+    void generate(const ir::root& root, std::ostream& ostream, const compile_options &options = {},
+                  std::span<const cached_function> cached = {});
+
+    /**
+     *  Generates the module like generate, but encodes it to machine code instead of
+     *  printing it as assembly.
+     */
+    as::encoded_module encode(const ir::root &root, const compile_options &options = {});
+
+    void gen_header(module_output &output);
+    void gen_global_string(module_output &output, const ir::global::global_string &global_string);
+    void gen_extern_function(module_output &output, const ir::global::extern_function &extern_function);
     void gen_function(const ir::root &root, std::ostream &ostream, const ir::global::function &function,
-                      std::vector<std::unique_ptr<global_pointer>> &global_strings);
+                      std::vector<std::unique_ptr<global_pointer>> &global_strings,
+                      const compile_options &options = {});
+
+    /**
+     *  Generates the asm nodes of @function into @context, up to but not including
+     *  printing or encoding them.
+     */
+    void lower_function(function_context &context, const ir::global::function &function,
+                        const compile_options &options = {});
 
     instruction_return gen_instruction(backend::context::function_context &context, const ir::block::block_instruction &instruction);
 }
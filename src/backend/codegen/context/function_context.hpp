@@ -4,9 +4,11 @@
 #include "../codegen.hpp"
 #include "../registers.hpp"
 #include "../valuegen.hpp"
+#include "../regalloc/allocation.hpp"
+#include "../block_state.hpp"
 #include "function_storage.hpp"
 
-#include <unordered_map>
+#include <vector>
 
 namespace backend::context {
   struct function_context {
@@ -14,40 +16,90 @@ namespace backend::context {
 
     std::ostream& ostream;
     std::vector<std::unique_ptr<global_pointer>> &global_strings;
+    const ir::symbol_table &symbols;
+
     std::vector<backend::as::label> asm_blocks;
 
+    // asm_blocks index of each IR block by its label's symbol id, -1 until generated
+    std::vector<int64_t> block_index;
+
     backend::as::label *current_label;
-    const backend::md::instruction_metadata *current_instruction;
+    const ir::block::block_instruction *current_instruction;
+
+    // Set when registers were assigned ahead of generation, current_position numbers
+    // instructions like md::live_range and next_split indexes the allocation's splits
+    const regalloc::allocation *allocation = nullptr;
+    uint32_t current_position = 0;
+    size_t next_split = 0;
+
+    // Where each block expects its values on entry, only set while generating
+    block_states *blocks = nullptr;
 
     function_storage storage {
         .parent_context = *this
     };
 
-    std::unordered_map<std::string, owned_vmem> value_map;
-
     std::vector<register_t> dropped_available;
 
-    bool register_is_param[register_count] {};
+    // Indexed by symbol id, whether the variable is still needed after some call it outlives
+    std::vector<bool> live_across_call;
 
     size_t current_stack_size = 0;
 
+    // Set when the function makes calls, which need rsp 16 byte aligned, or takes parameters
+    // on the stack, which are addressed through rbp
+    bool makes_calls = false;
+    bool stack_parameters = false;
+
     template <typename T, typename... Args>
     void add_asm_node(Args... constructor_args) {
         this->current_label->nodes.emplace_back(std::make_unique<T>(std::move(constructor_args)...));
     }
 
-    int64_t find_block(std::string_view name) {
-      for (int64_t i = 0; i < (int64_t) asm_blocks.size(); i++) {
-        if (asm_blocks[i].name == name) {
-          return i;
-        }
-      }
+    int64_t find_block(ir::symbol label) {
+      if (label.id >= block_index.size() || block_index[label.id] < 0)
+        throw std::runtime_error("Block not found");
 
-      throw std::runtime_error("Block not found");
+      return block_index[label.id];
     }
 
     bool auto_drop_reassignable() const {
-      return current_instruction->instruction.inst->auto_drop_reassignable();
+      return current_instruction->auto_drop_reassignable();
+    }
+
+    // Whether the current instruction is the last to read the variable @id
+    bool dies_here(ir::symbol_id id) const {
+      const auto &instruction = *current_instruction;
+
+      for (size_t i = 0; i < instruction.operands.size() && i < instruction.metadata.dropped_data.size(); i++) {
+        if (instruction.metadata.dropped_data[i] && instruction.operands[i].is_variable() && instruction.operands[i].get_id() == id)
+          return true;
+      }
+
+      return false;
+    }
+
+    // Whether @reg has to be saved on entry and restored before returning
+    bool must_preserve(register_t reg) const {
+      return register_save_class(reg) == save_class::callee_saved && storage.registers[reg]->tampered;
+    }
+
+    bool needs_frame() const {
+      return current_stack_size != 0 || stack_parameters;
+    }
+
+    // Bytes rsp is lowered by below the saved registers so that it is 16 byte aligned at calls,
+    // counting the return address, the frame and the saved registers above it
+    size_t alignment_padding() const {
+      if (!makes_calls)
+        return 0;
+
+      size_t offset = 8 + (needs_frame() ? 8 + current_stack_size : 0);
+
+      for (auto reg : callee_saved)
+        offset += must_preserve(reg) ? 8 : 0;
+
+      return (16 - offset % 16) % 16;
     }
   };
 }
\ No newline at end of file
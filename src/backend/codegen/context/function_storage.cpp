@@ -5,26 +5,35 @@
 
 using namespace backend;
 
-void context::function_storage::remap_value(std::string name, backend::context::virtual_memory *value) {
-    if (has_value(name)) {
-        drop_ownership(name);
-        erase_value(name);
+void context::function_storage::reserve_symbols(const ir::symbol_table &symbols) {
+    value_map.assign(symbols.size(), nullptr);
+    first_temp = static_cast<ir::symbol_id>(symbols.size());
+}
+
+bool context::function_storage::is_temp(ir::symbol_id id) const {
+    return id != ir::no_symbol && id >= first_temp;
+}
+
+void context::function_storage::remap_value(ir::symbol_id id, backend::context::virtual_memory *value) {
+    if (has_value(id)) {
+        drop_ownership(id);
+        erase_value(id);
     }
 
-    map_value(name, value);
+    map_value(id, value);
 }
 
-void context::function_storage::map_value(std::string name, virtual_memory *value) {
-    value_map[name] = value;
+void context::function_storage::map_value(ir::symbol_id id, virtual_memory *value) {
+    value_map[id] = value;
 
-    if (auto *ptr = dynamic_cast<register_storage*>(value)) {
+    if (auto *ptr = vmem_cast<register_storage>(value)) {
         ptr->grab(value->size);
-        ptr->owner = std::move(name);
+        ptr->owner = id;
     }
 }
 
 void context::function_storage::map_value(const ir::variable &var, virtual_memory *value) {
-    map_value(var.name, value);
+    map_value(var.name.id, value);
 }
 
 context::register_storage *context::function_storage::register_ref(backend::context::register_t reg) {
@@ -43,36 +52,34 @@ context::register_storage *context::function_storage::get_register(backend::cont
 
 void
 context::function_storage::claim_temp_register(backend::context::register_t reg, context::value_reference &val) {
-    static int temp_counter = 0;
-
-    auto temp_name = std::string { "__temp" + std::to_string(temp_counter++) };
+    const auto temp = static_cast<ir::symbol_id>(value_map.size());
+    value_map.push_back(nullptr);
 
     auto *reg_storage = get_register(reg, val.get_size());
-    map_value(temp_name, reg_storage);
+    map_value(temp, reg_storage);
 
-    val.value = std::move(temp_name);
+    val.value = temp;
 }
 
-void context::function_storage::drop_ownership(std::string_view name) {
-    if (!has_value(name))
+void context::function_storage::drop_ownership(ir::symbol_id id) {
+    if (!has_value(id))
         return;
 
-    auto value = value_map[std::string { name }];
+    auto value = value_map[id];
 
-    if (auto *reg = dynamic_cast<register_storage*>(value)) {
+    if (auto *reg = vmem_cast<register_storage>(value)) {
         reg->unclaim();
     }
 
     dropped_available.emplace_back(value);
 }
 
-void context::function_storage::erase_value(std::string_view name) {
-    auto owned = std::string { name };
-    auto val = value_map[owned];
+void context::function_storage::erase_value(ir::symbol_id id) {
+    auto val = value_map[id];
 
-    value_map.erase(std::string { name });
+    value_map[id] = nullptr;
 
-    if (auto *reg = dynamic_cast<register_storage*>(val)) {
+    if (auto *reg = vmem_cast<register_storage>(val)) {
         reg->unclaim();
     }
 }
@@ -91,8 +98,8 @@ void context::function_storage::erase_reassignable() {
     pending_drop.clear();
 }
 
-context::value_reference context::function_storage::get_value(std::string_view name) {
-    return context::value_reference { parent_context, std::string { name } };
+context::value_reference context::function_storage::get_value(ir::symbol_id id) {
+    return context::value_reference { parent_context, id };
 }
 
 context::value_reference context::function_storage::get_value(const ir::value &value) {
@@ -100,15 +107,15 @@ context::value_reference context::function_storage::get_value(const ir::value &v
 }
 
 context::value_reference context::function_storage::get_value(const ir::variable &var) {
-    return get_value(var.name);
+    return get_value(var.name.id);
 }
 
 context::value_reference context::function_storage::get_value(const ir::int_literal &literal) {
     return context::value_reference { parent_context, literal };
 }
 
-bool context::function_storage::has_value(std::string_view name) const {
-    return value_map.contains(std::string { name });
+bool context::function_storage::has_value(ir::symbol_id id) const {
+    return id < value_map.size() && value_map[id];
 }
 
 void context::function_storage::ensure_in_register(value_reference &val) {
@@ -124,8 +131,8 @@ void context::function_storage::ensure_in_register(value_reference &val) {
         );
     } else {
         parent_context.add_asm_node<as::inst::mov>(
-            val.gen_operand(),
-            as::create_operand(reg->reg, val.get_size())
+            as::create_operand(reg->reg, val.get_size()),
+            val.gen_operand()
         );
     }
 
@@ -31,38 +31,43 @@ value_reference::gen_address() const {
     return operand;
 }
 
-std::optional<std::string_view> value_reference::get_name() const {
+std::optional<ir::symbol_id> value_reference::get_symbol() const {
     if (is_variable())
-        return std::get<std::string>(value);
+        return std::get<var_type>(value);
 
     return std::nullopt;
 }
 
-const std::string &value_reference::get_name_ref() const {
-    return std::get<std::string>(value);
-}
-
 [[nodiscard]] std::optional<virtual_memory *> value_reference::get_vmem() const {
     if (!is_variable())
         return std::nullopt;
 
-    if (context.storage.value_map.contains(std::get<std::string>(value)))
-        return context.storage.value_map.at(std::get<std::string>(value));
+    const auto id = std::get<var_type>(value);
+
+    if (context.storage.has_value(id))
+        return context.storage.value_map[id];
+
+    if (context.storage.is_temp(id)) {
+        std::cerr << "Temporary " << id << " not found in value map\n";
+        return std::nullopt;
+    }
 
     // look for a global string with the same name
+    const auto name = context.symbols.name(id);
+
     for (const auto &global_string : context.global_strings) {
-        if (global_string->name == std::get<std::string>(value))
+        if (global_string->name == name)
             return global_string.get();
     }
 
-    std::cerr << "Variable " << std::get<std::string>(value) << " not found in value map\n";
+    std::cerr << "Variable " << name << " not found in value map\n";
     return std::nullopt;
 }
 
 std::optional<backend::context::register_t>
 value_reference::get_register() const {
     if (auto vmem = get_vmem()) {
-        if (auto reg = dynamic_cast<const register_storage *>(*vmem); reg)
+        if (auto reg = vmem_cast<register_storage>(*vmem); reg)
             return reg->reg;
     }
 
@@ -12,7 +12,7 @@ namespace backend::context {
     struct function_context;
 
     struct value_reference {
-        using var_type = std::string;
+        using var_type = ir::symbol_id;
         using literal_type = ir::int_literal;
 
         function_context &context;
@@ -30,16 +30,14 @@ namespace backend::context {
         [[nodiscard]] std::unique_ptr<as::op::operand_t> gen_address() const;
 
         [[nodiscard]] bool is_variable() const {
-            return std::holds_alternative<std::string>(value);
+            return std::holds_alternative<var_type>(value);
         }
 
         [[nodiscard]] bool is_literal() const {
             return std::holds_alternative<ir::int_literal>(value);
         }
 
-        [[nodiscard]] std::optional<std::string_view> get_name() const;
-
-        [[nodiscard]] const std::string& get_name_ref() const;
+        [[nodiscard]] std::optional<ir::symbol_id> get_symbol() const;
 
         [[nodiscard]] std::optional<virtual_memory *> get_vmem() const;
 
@@ -53,7 +51,7 @@ namespace backend::context {
 
         template <typename T>
         [[nodiscard]] T *get_vptr_type() const {
-            return dynamic_cast<T*>(*get_vmem());
+            return vmem_cast<T>(get_vmem().value_or(nullptr));
         }
     };
 }
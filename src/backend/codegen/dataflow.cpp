@@ -3,6 +3,7 @@
 
 #include "context/function_context.hpp"
 #include "context/value_reference.hpp"
+#include "../instrumentation.hpp"
 
 void backend::context::copy_to_register(backend::context::function_context &context,
                                         const ir::value &value,
@@ -34,7 +35,7 @@ backend::context::virtual_memory * backend::context::empty_register(backend::con
         old_mem.gen_operand()
     );
 
-    context.storage.remap_value(old_mem.get_name_ref(), new_mem);
+    context.storage.remap_value(*old_mem.get_symbol(), new_mem);
     return new_mem;
 }
 
@@ -45,5 +46,46 @@ backend::context::find_val_storage(backend::context::function_context &context,
     if (reg)
         return reg;
 
+    instrument::count(instrument::counter::spills);
     return backend::context::stack_allocate(context, ir::size_in_bytes(size));
-}
\ No newline at end of file
+}
+
+void backend::context::save_caller_saved(backend::context::function_context &context) {
+    for (const auto &reg : context.storage.registers) {
+        if (!reg->in_use() || context.storage.is_temp(reg->owner) || context.dies_here(reg->owner))
+            continue;
+
+        if (register_save_class(reg->reg) != save_class::caller_saved)
+            continue;
+
+        const auto owner = reg->owner;
+        auto value = context.storage.get_value(owner);
+        const auto size = value.get_size();
+
+        virtual_memory *destination = nullptr;
+
+        for (auto saved : callee_saved) {
+            const auto &candidate = context.storage.registers[saved];
+
+            if (candidate->in_use() || candidate->frozen) continue;
+
+            destination = context.storage.get_register(saved, size);
+            break;
+        }
+
+        if (!destination) {
+            instrument::count(instrument::counter::spills);
+
+            auto *slot = stack_allocate(context, ir::size_in_bytes(size));
+            slot->size = size;
+            destination = slot;
+        }
+
+        context.add_asm_node<as::inst::mov>(
+            as::create_operand(destination, size),
+            value.gen_operand()
+        );
+
+        context.storage.remap_value(owner, destination);
+    }
+}
@@ -12,4 +12,11 @@ namespace backend::context {
 
     virtual_memory *
     find_val_storage(backend::context::function_context &context, ir::value_size size);
+
+    /**
+     *  Moves the values still needed after the current instruction, a call, out of the caller
+     *  saved registers the callee is free to overwrite, into a free callee saved register or
+     *  onto the stack.
+     */
+    void save_caller_saved(backend::context::function_context &context);
 }
\ No newline at end of file
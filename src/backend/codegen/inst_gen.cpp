@@ -12,7 +12,7 @@ void codegen::gen_lea(context::function_context &context, const context::virtual
             ir::value_size::none,
             (int64_t) b,
             context::memory_addr::scaled_reg {
-                dynamic_cast<const context::register_storage *>(x)->reg,
+                context::vmem_cast<context::register_storage>(x)->reg,
                 (int8_t) m
             }
         })
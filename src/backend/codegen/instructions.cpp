@@ -109,11 +109,11 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
 
     context.add_asm_node<as::inst::cond_jmp>(
         icmp_result->flag,
-        inst.true_branch
+        std::string { context.symbols.name(inst.true_branch) }
     );
 
     context.add_asm_node<as::inst::jmp>(
-        inst.false_branch
+        std::string { context.symbols.name(inst.false_branch) }
     );
 
     return {};
@@ -127,7 +127,7 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
 ) {
     debug::assert(operands.empty(), "Invalid Parameter Count for Jump");
 
-    context.add_asm_node<as::inst::jmp>(inst.label);
+    context.add_asm_node<as::inst::jmp>(std::string { context.symbols.name(inst.label) });
     return {};
 }
 
@@ -167,23 +167,39 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
     auto lhs = context.storage.get_value(operands[0]);
     auto rhs = context.storage.get_value(operands[1]);
 
-    const auto &[dom, sub] = [&]() {
-        if (lhs.get_register()) {
-            return std::make_pair(lhs, rhs);
-        }
+    // Sized by the IR, spilled values' storage is sized as a pointer
+    const auto size = operands[0].get_size();
+
+    // The result overwrites the left operand, which is only done in place when nothing
+    // reads it afterwards. Otherwise it is copied first, and the operands are never swapped
+    // since sub is not commutative.
+    if (lhs.get_register() && context.dies_here(operands[0].get_id())) {
+        context.add_asm_node<as::inst::arithmetic>(
+            inst.type,
+            lhs.gen_operand(size),
+            rhs.gen_operand(size)
+        );
+
+        return {
+            .return_dest = *lhs.get_vmem()
+        };
+    }
+
+    auto *dest = backend::context::force_find_register(context, size);
 
-        context.storage.ensure_in_register(rhs);
-        return std::make_pair(rhs, lhs);
-    }();
+    context.add_asm_node<as::inst::mov>(
+        as::create_operand(dest, size),
+        lhs.gen_operand(size)
+    );
 
     context.add_asm_node<as::inst::arithmetic>(
         inst.type,
-        dom.gen_operand(),
-        sub.gen_operand()
+        as::create_operand(dest, size),
+        rhs.gen_operand(size)
     );
 
     return {
-        .return_dest = *dom.get_vmem()
+        .return_dest = dest
     };
 }
 
@@ -193,10 +209,47 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
         const ir::block::call &inst,
         const v_operands &operands
 ) {
-    for (size_t i = 0; i < operands.size(); i++) {
+    save_caller_saved(context);
+
+    // Arguments past the registers are pushed right to left, padded so that rsp stays 16 byte aligned
+    const auto stack_arguments = operands.size() > param_register_count ? operands.size() - param_register_count : 0;
+    const auto stack_padding = (stack_arguments * stack_argument_size) % 16;
+
+    if (stack_padding) {
+        context.add_asm_node<as::inst::arithmetic>(
+            ir::block::arithmetic_type::sub,
+            as::create_operand(register_t::rsp, ir::value_size::i64),
+            as::create_operand(ir::int_literal { ir::value_size::i64, stack_padding })
+        );
+    }
+
+    for (size_t i = operands.size(); i-- > param_register_count;) {
+        auto operand_storage = context.storage.get_value(operands[i]);
+
+        if (auto *complex = operand_storage.get_vptr_type<memory_addr>(); complex && operands[i].get_size() == ir::value_size::ptr) {
+            empty_register(context, register_t::rax);
+
+            context.add_asm_node<as::inst::lea>(
+                as::create_operand(register_t::rax, ir::value_size::ptr),
+                as::create_operand(complex)
+            );
+            context.add_asm_node<as::inst::push>(as::create_operand(register_t::rax, ir::value_size::i64));
+            continue;
+        }
+
+        context.add_asm_node<as::inst::push>(operand_storage.gen_operand(ir::value_size::i64));
+    }
+
+    for (size_t i = 0; i < operands.size() && i < param_register_count; i++) {
         const auto param_reg_id = backend::context::param_register((uint8_t) i);
         auto operand_storage = context.storage.get_value(operands[i]);
 
+        // Keeps the argument from being moved while the remaining ones are set up
+        const auto hold = [&]() {
+            value_reference argument { context, ir::int_literal { operands[i].get_size(), 0 } };
+            context.storage.claim_temp_register(param_reg_id, argument);
+        };
+
         if (operands[i].get_size() == ir::value_size::ptr) {
             if (auto *complex = operand_storage.get_vptr_type<memory_addr>()) {
               context::empty_register(context, param_reg_id);
@@ -205,16 +258,19 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
                     as::create_operand(param_reg_id, complex->size),
                     as::create_operand(complex)
                 );
+                hold();
                 continue;
             }
         }
 
-        if (!context.current_instruction->dropped_data[i] &&
+        if (!context.current_instruction->metadata.dropped_data[i] &&
             operand_storage.get_register() == param_reg_id) {
             empty_register(context, param_reg_id);
         } else {
             copy_to_register(context, operands[i], param_reg_id);
         }
+
+        hold();
     }
 
     empty_register(context, backend::context::register_t::rax);
@@ -222,7 +278,15 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
         as::create_operand(backend::context::register_t::rax, ir::value_size::i64),
         as::create_operand(ir::int_literal { ir::value_size::i64, 0 })
     );
-    context.add_asm_node<as::inst::call>(inst.name);
+    context.add_asm_node<as::inst::call>(std::string { context.symbols.name(inst.name) });
+
+    if (stack_arguments) {
+        context.add_asm_node<as::inst::arithmetic>(
+            ir::block::arithmetic_type::add,
+            as::create_operand(register_t::rsp, ir::value_size::i64),
+            as::create_operand(ir::int_literal { ir::value_size::i64, stack_arguments * stack_argument_size + stack_padding })
+        );
+    }
 
     return {
         .return_dest = context.storage.get_register(backend::context::register_t::rax, inst.get_return_size())
@@ -236,62 +300,12 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
         const backend::context::v_operands &operands
 ) {
     debug::assert(operands.size() == inst.labels.size(), "Invalid Parameter Count for Phi");
-    auto mem = backend::context::find_val_storage(context, inst.get_return_size());
-    const auto &phi_block = context.current_label->name;
-
-    for (size_t op = 0; op < operands.size(); op++) {
-        const auto &target = inst.labels[op];
-        const auto &val = context.storage.get_value(operands[op]);
-        const auto &val_name = operands[0].get_name();
-
-        auto branch = context.find_block(target);
-        auto &nodes = context.asm_blocks[branch].nodes;
-
-        if (nodes.empty()) {
-            nodes.emplace_back(std::make_unique<as::inst::mov>(
-                    as::create_operand(mem),
-                    val.gen_operand()
-            ));
-            continue;
-        }
-
-        for (int64_t i = 0; i < (int64_t) nodes.size(); i++) {
-            auto iter = nodes.begin() + i;
-
-            if (auto *jmp = dynamic_cast<const as::inst::jmp*>(iter->get())) {
-                if (jmp->label_name != phi_block) continue;
-
-                nodes.insert(iter, std::make_unique<as::inst::mov>(
-                        as::create_operand(mem),
-                        val.gen_operand()
-                ));
-                i++;
-            } else if (auto *cond_jmp = dynamic_cast<as::inst::cond_jmp*>(iter->get())) {
-                if (cond_jmp->branch_name != phi_block) continue;
-
-                std::string temp_phi = std::string("__").append(std::to_string(branch)).append("_phi").append(val_name);
-
-                cond_jmp->branch_name = temp_phi;
-
-                auto &temp_block = context.asm_blocks.emplace_back(std::move(temp_phi));
 
-                auto cached_context = context.current_label;
-                context.current_label = &temp_block;
-
-                context.add_asm_node<as::inst::mov>(
-                    as::create_operand(mem),
-                    val.gen_operand()
-                );
-
-                context.current_label = cached_context;
-
-                temp_block.nodes.emplace_back(std::make_unique<as::inst::jmp>(phi_block));
-            }
-        }
-    }
+    // Placed on entry to the block, and given its value by the moves on each edge into it, see block_states
+    const auto id = context.current_instruction->assigned_to->name.id;
 
     return {
-        .return_dest = mem
+        .return_dest = context.storage.value_map[id]
     };
 }
 
@@ -335,21 +349,21 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
 ) {
     debug::assert(operands.size() == 3, "Invalid Parameter Count for Select");
 
-    const auto cond = context.storage.get_value(operands[0]).get_vptr_type<context::icmp_result>();
+    const auto *icmp = context.storage.get_value(operands[0]).get_vptr_type<context::icmp_result>();
     auto true_val= context.storage.get_value(operands[1]);
     auto false_val = context.storage.get_value(operands[2]);
 
-    const auto *icmp = dynamic_cast<const backend::context::icmp_result*>(cond);
-
     debug::assert(true_val.get_size() == false_val.get_size(), "Select Operands must be the same size");
     debug::assert(icmp, "First parameter of Select is not a ICMP Result!");
 
     if (true_val.is_literal() && false_val.is_literal()) {
         if (auto arith_select = gen_arithmetic_select(context, inst, operands))
             return *arith_select;
+    }
 
+    // cmov has no immediate form, the true value has to be in a register
+    if (true_val.is_literal())
         context.storage.ensure_in_register(true_val);
-    }
 
     auto icmp_type = icmp->flag;
     auto mem = backend::context::force_find_register(context, true_val.get_size());
@@ -432,7 +446,7 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
 ) {
     debug::assert(operands.size() == 1, "Invalid Parameter Count for Zext");
 
-    if (const auto *literal = context.storage.get_value(operands[0]).get_vptr_type<ir::int_literal>()) {
+    if (const auto literal = context.storage.get_value(operands[0]).get_literal()) {
         return {
             .return_dest = context.storage.get_misc_storage<vptr_int_literal>(inst.get_return_size(), literal->value)
         };
@@ -471,12 +485,9 @@ backend::context::instruction_return backend::context::gen_instruction<ir::block
 
     auto new_mem = backend::context::find_val_storage(context, inst.get_return_size());
 
-    if (context.storage.get_value(operands[0]).get_vptr_type<ir::int_literal>()) {
+    if (const auto literal = input.get_literal()) {
         return {
-            .return_dest = context.storage.get_misc_storage<vptr_int_literal>(
-                    inst.get_return_size(),
-                    context.storage.get_value(operands[0]).get_literal()->value
-            )
+            .return_dest = context.storage.get_misc_storage<vptr_int_literal>(inst.get_return_size(), literal->value)
         };
     }
 
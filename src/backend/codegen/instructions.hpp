@@ -13,7 +13,7 @@ namespace ir::block {
 namespace backend::context {
     struct function_context;
 
-    using v_operands = std::vector<ir::value>;
+    using v_operands = ir::operand_list;
 
     struct instruction_return {
         virtual_memory* return_dest;
@@ -0,0 +1,121 @@
+#include "allocation.hpp"
+
+#include <algorithm>
+
+#include "../dataflow.hpp"
+#include "../context/function_context.hpp"
+#include "../context/value_reference.hpp"
+#include "../../instrumentation.hpp"
+
+using namespace backend;
+
+const regalloc::segment *regalloc::allocation::segment_at(ir::symbol_id id, uint32_t position) const {
+    if (id >= segments.size())
+        return nullptr;
+
+    const auto &variable = segments[id];
+    const auto after = std::upper_bound(variable.begin(), variable.end(), position,
+                                        [](uint32_t position, const segment &seg) { return position < seg.from; });
+
+    if (after == variable.begin())
+        return nullptr;
+
+    return &*std::prev(after);
+}
+
+namespace {
+    bool reads(const ir::block::block_instruction &instruction, ir::symbol_id id) {
+        return std::any_of(instruction.operands.begin(), instruction.operands.end(), [&](const ir::value &operand) {
+            return operand.is_variable() && operand.get_id() == id;
+        });
+    }
+
+    // Moves whatever holds @reg elsewhere. Assignments are not consulted while doing so,
+    // as the register being freed is usually the one they would hand out.
+    void relocate(context::function_context &context, context::register_t reg) {
+        const auto *allocation = std::exchange(context.allocation, nullptr);
+        context::empty_register(context, reg);
+        context.allocation = allocation;
+    }
+}
+
+context::register_storage *regalloc::find_assigned_register(context::function_context &context, ir::value_size size) {
+    if (!context.allocation || !context.current_instruction->assigned_to)
+        return nullptr;
+
+    // Call results always arrive in rax, registers found during a call are for its arguments
+    if (context.current_instruction->type() == ir::block::node_type::call)
+        return nullptr;
+
+    const auto id = context.current_instruction->assigned_to->name.id;
+    const auto *segment = context.allocation->segment_at(id, context.current_position);
+
+    if (!segment || !segment->reg)
+        return nullptr;
+
+    auto *storage = context.storage.registers[*segment->reg].get();
+
+    if (storage->in_use()) {
+        if (context.storage.is_temp(storage->owner) || reads(*context.current_instruction, storage->owner))
+            return nullptr;
+
+        relocate(context, storage->reg);
+    } else if (storage->frozen) {
+        // Already handed out as a temporary of this instruction
+        return nullptr;
+    }
+
+    return context.storage.get_register(storage->reg, size);
+}
+
+void regalloc::apply_splits(context::function_context &context) {
+    if (!context.allocation)
+        return;
+
+    const auto &splits = context.allocation->splits;
+
+    for (; context.next_split < splits.size(); context.next_split++) {
+        const auto [position, id] = splits[context.next_split];
+
+        if (position > context.current_position)
+            break;
+
+        if (!context.storage.has_value(id))
+            continue;
+
+        auto value = context.storage.get_value(id);
+        const auto size = value.get_size();
+        const auto *current = value.get_vptr_type<context::register_storage>();
+        const auto *segment = context.allocation->segment_at(id, position);
+
+        // Only values kept in a register or a stack slot are moved, not literals or flags
+        if (!current && !value.get_vptr_type<context::memory_addr>())
+            continue;
+
+        context::virtual_memory *destination;
+
+        if (segment->reg) {
+            if (current && current->reg == *segment->reg)
+                continue;
+
+            relocate(context, *segment->reg);
+            destination = context.storage.get_register(*segment->reg, size);
+        } else {
+            if (!current)
+                continue;
+
+            instrument::count(instrument::counter::spills);
+
+            auto *slot = context::stack_allocate(context, ir::size_in_bytes(size));
+            slot->size = size;
+            destination = slot;
+        }
+
+        context.add_asm_node<as::inst::mov>(
+            as::create_operand(destination, size),
+            value.gen_operand()
+        );
+
+        context.storage.remap_value(id, destination);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../registers.hpp"
+#include "../../../ir/symbol_table.hpp"
+
+namespace backend::context {
+    struct function_context;
+    struct register_storage;
+}
+
+namespace backend::regalloc {
+    /**
+     *  Where a variable is kept from position @from on, until the next segment of the
+     *  same variable. A segment without @reg means the variable is spilled to the stack.
+     */
+    struct segment {
+        uint32_t from;
+        std::optional<context::register_t> reg;
+    };
+
+    /**
+     *  Registers assigned to a function's variables ahead of code generation. Positions
+     *  are numbered as in md::live_range.
+     */
+    struct allocation {
+        // Indexed by symbol id, each sorted by position
+        std::vector<std::vector<segment>> segments;
+
+        // Every point a variable moves from one segment to the next, sorted by position
+        std::vector<std::pair<uint32_t, ir::symbol_id>> splits;
+
+        [[nodiscard]] const segment *segment_at(ir::symbol_id id, uint32_t position) const;
+    };
+
+    /**
+     *  The register assigned to the variable the current instruction defines, if it
+     *  has one, evicting any variable the allocation has already moved out of it.
+     *  Returns nullptr to fall back to choosing a register greedily.
+     */
+    context::register_storage *find_assigned_register(context::function_context &context, ir::value_size size);
+
+    /**
+     *  Moves the variables which are split at the current instruction into their next
+     *  segment's register or stack slot. Called before generating each instruction.
+     */
+    void apply_splits(context::function_context &context);
+}
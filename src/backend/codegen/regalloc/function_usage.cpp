@@ -0,0 +1,146 @@
+#include "function_usage.hpp"
+
+#include <algorithm>
+
+#include "../../../ir/nodes.hpp"
+
+using namespace backend;
+
+namespace {
+    bool needs_register(const ir::block::block_instruction &instruction) {
+        switch (instruction.type()) {
+            case ir::block::node_type::literal:
+            case ir::block::node_type::allocate:
+            case ir::block::node_type::icmp:
+                return false;
+            default:
+                return true;
+        }
+    }
+}
+
+std::optional<uint32_t> regalloc::function_usage::next_use(ir::symbol_id id, uint32_t after) const {
+    const auto &positions = uses[id];
+    const auto use = std::upper_bound(positions.begin(), positions.end(), after);
+
+    return use == positions.end() ? std::nullopt : std::make_optional(*use);
+}
+
+std::optional<uint32_t> regalloc::function_usage::next_call(uint32_t after) const {
+    const auto call = std::upper_bound(calls.begin(), calls.end(), after);
+
+    return call == calls.end() ? std::nullopt : std::make_optional(*call);
+}
+
+bool regalloc::function_usage::crosses_call(uint32_t start, uint32_t end) const {
+    const auto call = next_call(start);
+
+    return call && *call < end;
+}
+
+float regalloc::function_usage::spill_weight(ir::symbol_id id, uint32_t start, uint32_t end) const {
+    float weight = 0;
+
+    for (auto position : uses[id]) {
+        if (position >= start && position <= end)
+            weight += use_weight[position];
+    }
+
+    return weight / static_cast<float>(end - start + 1);
+}
+
+regalloc::function_usage regalloc::gather_usage(const ir::global::function &function) {
+    const auto symbol_count = function.symbols.size();
+
+    function_usage usage;
+    usage.uses.resize(symbol_count);
+    usage.allocated.assign(symbol_count, false);
+    usage.fixed.resize(symbol_count);
+    usage.preferred.resize(symbol_count);
+
+    for (size_t i = 0; i < function.parameters.size() && i < context::param_register_count; i++) {
+        const auto id = function.parameters[i].name.id;
+
+        usage.allocated[id] = true;
+        usage.fixed[id] = context::param_register((uint8_t) i);
+    }
+
+    // Loop depth of each block, every back-edge (a jump to the same or an earlier block)
+    // deepens the blocks between its target and its source
+    std::vector<int32_t> depth_delta(function.blocks.size() + 1, 0);
+    std::vector<uint32_t> block_start(function.blocks.size(), 0);
+
+    std::vector<size_t> block_of(symbol_count, SIZE_MAX);
+    for (size_t b = 0; b < function.blocks.size(); b++)
+        block_of[function.blocks[b].name.id] = b;
+
+    uint32_t position = 0;
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        block_start[b] = position + 1;
+
+        for (const auto &instruction : function.blocks[b].instructions) {
+            position++;
+
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                const auto &operand = instruction.operands[i];
+
+                if (!operand.is_variable())
+                    continue;
+
+                auto &positions = usage.uses[operand.get_id()];
+
+                if (positions.empty() || positions.back() != position)
+                    positions.push_back(position);
+
+                if (instruction.type() == ir::block::node_type::ret)
+                    usage.preferred[operand.get_id()] = context::rax;
+                else if (instruction.type() == ir::block::node_type::call && i < context::param_register_count)
+                    usage.preferred[operand.get_id()] = context::param_register((uint8_t) i);
+            }
+
+            if (instruction.type() == ir::block::node_type::call)
+                usage.calls.push_back(position);
+
+            if (instruction.type() == ir::block::node_type::branch || instruction.type() == ir::block::node_type::jmp) {
+                for (const auto &label : instruction.labels_referenced) {
+                    const auto target = label.id < block_of.size() ? block_of[label.id] : SIZE_MAX;
+
+                    if (target > b)
+                        continue;
+
+                    depth_delta[target]++;
+                    depth_delta[b + 1]--;
+                }
+            }
+
+            if (!instruction.assigned_to || !needs_register(instruction))
+                continue;
+
+            const auto id = instruction.assigned_to->name.id;
+            usage.allocated[id] = true;
+
+            if (instruction.type() == ir::block::node_type::call)
+                usage.fixed[id] = context::rax;
+        }
+    }
+
+    usage.use_weight.assign(position + 1, 1);
+
+    int32_t depth = 0;
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        depth += depth_delta[b];
+
+        float weight = 1;
+        for (int32_t i = 0; i < std::min(depth, 4); i++)
+            weight *= 10;
+
+        const auto end = b + 1 < function.blocks.size() ? block_start[b + 1] : position + 1;
+
+        for (auto p = block_start[b]; p < end; p++)
+            usage.use_weight[p] = weight;
+    }
+
+    return usage;
+}
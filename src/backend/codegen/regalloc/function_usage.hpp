@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "../registers.hpp"
+#include "../../../ir/node_prototypes.hpp"
+#include "../../../ir/symbol_table.hpp"
+
+namespace backend::regalloc {
+    /**
+     *  How a function's variables are used, in the positions of md::live_range, as needed
+     *  to decide which of them to keep in registers.
+     */
+    struct function_usage {
+        // Indexed by symbol id, the distinct positions each variable is read at in order
+        std::vector<std::vector<uint32_t>> uses;
+
+        // Positions of calls, in order
+        std::vector<uint32_t> calls;
+
+        // Spill weight of a use at each position, growing with loop depth
+        std::vector<float> use_weight;
+
+        // Indexed by symbol id, whether the variable is kept in a register at all (literals,
+        // allocations and comparisons are kept as constants, stack addresses and flags)
+        std::vector<bool> allocated;
+
+        // Indexed by symbol id, the register a parameter or call result arrives in
+        std::vector<std::optional<context::register_t>> fixed;
+
+        // Indexed by symbol id, the register a variable is moved into when read by a call
+        // or return, so keeping it there saves a move
+        std::vector<std::optional<context::register_t>> preferred;
+
+        [[nodiscard]] std::optional<uint32_t> next_use(ir::symbol_id id, uint32_t after) const;
+        [[nodiscard]] std::optional<uint32_t> next_call(uint32_t after) const;
+
+        [[nodiscard]] bool crosses_call(uint32_t start, uint32_t end) const;
+
+        /**
+         *  Weighted uses of @id within [@start, @end] per position covered, the cost
+         *  of keeping it out of a register over that span.
+         */
+        [[nodiscard]] float spill_weight(ir::symbol_id id, uint32_t start, uint32_t end) const;
+    };
+
+    function_usage gather_usage(const ir::global::function &function);
+}
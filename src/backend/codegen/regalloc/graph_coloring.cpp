@@ -0,0 +1,350 @@
+#include "graph_coloring.hpp"
+#include "function_usage.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <set>
+
+#include "../../../ir/nodes.hpp"
+#include "../../ir_analyzer/node_metadata.hpp"
+
+using namespace backend;
+
+namespace {
+    // One bit per register
+    using register_mask = uint32_t;
+
+    template <size_t N>
+    constexpr register_mask mask_of(const context::register_t (&registers)[N]) {
+        register_mask mask = 0;
+
+        for (auto reg : registers)
+            mask |= register_mask { 1 } << reg;
+
+        return mask;
+    }
+
+    constexpr auto no_node = UINT32_MAX;
+
+    struct node {
+        ir::symbol_id id;
+        uint32_t start, end;
+
+        register_mask allowed;
+        std::optional<context::register_t> color;
+        std::optional<context::register_t> preferred;
+
+        float weight;
+        bool precolored;
+    };
+
+    struct move {
+        uint32_t lhs, rhs;
+        float weight;
+    };
+
+    struct coloring_state {
+        const regalloc::function_usage &usage;
+
+        std::vector<node> nodes {};
+        std::vector<uint32_t> node_of {};
+
+        // Coalesced nodes point at the node they were merged into
+        std::vector<uint32_t> alias {};
+        std::vector<std::set<uint32_t>> adjacent {};
+
+        uint32_t find(uint32_t n) {
+            while (alias[n] != n)
+                n = alias[n] = alias[alias[n]];
+
+            return n;
+        }
+
+        void build_nodes(const std::vector<md::live_range> &ranges);
+        void build_interference();
+        void coalesce(const ir::global::function &function);
+        std::vector<uint32_t> simplify();
+        void select(std::vector<uint32_t> stack);
+    };
+
+    void coloring_state::build_nodes(const std::vector<md::live_range> &ranges) {
+        node_of.assign(ranges.size(), no_node);
+
+        for (ir::symbol_id id = 0; id < ranges.size(); id++) {
+            const auto [start, end] = ranges[id];
+
+            if (!usage.allocated[id] || end <= start)
+                continue;
+
+            const auto crosses_call = usage.crosses_call(start, end);
+
+            // A parameter or call result only stays where it arrives if no call clobbers it
+            // in the meantime, otherwise it is moved once it has arrived
+            const auto precolored = usage.fixed[id] && !crosses_call;
+
+            node_of[id] = (uint32_t) nodes.size();
+            nodes.push_back(node {
+                .id = id,
+                .start = start,
+                .end = end,
+                .allowed = precolored ? register_mask { 1 } << *usage.fixed[id]
+                    : crosses_call ? mask_of(context::callee_saved) : mask_of(context::allocatable),
+                .color = precolored ? usage.fixed[id] : std::nullopt,
+                .preferred = usage.preferred[id],
+                .weight = usage.spill_weight(id, start, end),
+                .precolored = precolored,
+            });
+        }
+
+        alias.resize(nodes.size());
+        std::iota(alias.begin(), alias.end(), 0);
+        adjacent.resize(nodes.size());
+    }
+
+    void coloring_state::build_interference() {
+        std::vector<uint32_t> order(nodes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return nodes[lhs].start < nodes[rhs].start;
+        });
+
+        // A variable dying at an instruction does not interfere with the one it defines
+        std::vector<uint32_t> live;
+
+        for (auto n : order) {
+            std::erase_if(live, [&](uint32_t other) { return nodes[other].end <= nodes[n].start; });
+
+            for (auto other : live) {
+                adjacent[n].insert(other);
+                adjacent[other].insert(n);
+            }
+
+            live.push_back(n);
+        }
+    }
+
+    void coloring_state::coalesce(const ir::global::function &function) {
+        std::vector<move> moves;
+        uint32_t position = 0;
+
+        for (const auto &block : function.blocks) {
+            for (const auto &instruction : block.instructions) {
+                position++;
+
+                if (!instruction.assigned_to)
+                    continue;
+
+                const auto dest = node_of[instruction.assigned_to->name.id];
+
+                if (dest == no_node)
+                    continue;
+
+                const auto add_move = [&](const ir::value &operand) {
+                    if (operand.is_variable() && node_of[operand.get_id()] != no_node)
+                        moves.push_back({ dest, node_of[operand.get_id()], usage.use_weight[position] });
+                };
+
+                switch (instruction.type()) {
+                    case ir::block::node_type::phi:
+                        for (const auto &operand : instruction.operands)
+                            add_move(operand);
+                        break;
+                    case ir::block::node_type::arithmetic:
+                    case ir::block::node_type::sext:
+                    case ir::block::node_type::zext:
+                        if (!instruction.operands.empty())
+                            add_move(instruction.operands[0]);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        // Copies executed most often are the most valuable to remove
+        std::stable_sort(moves.begin(), moves.end(), [](const move &lhs, const move &rhs) {
+            return lhs.weight > rhs.weight;
+        });
+
+        for (const auto &[lhs_node, rhs_node, weight] : moves) {
+            const auto lhs = find(lhs_node), rhs = find(rhs_node);
+
+            if (lhs == rhs || adjacent[lhs].contains(rhs))
+                continue;
+
+            // Precolored nodes are not merged, their partner is only biased towards the color
+            if (nodes[lhs].precolored || nodes[rhs].precolored) {
+                auto &free = nodes[lhs].precolored ? nodes[rhs] : nodes[lhs];
+                const auto &fixed = nodes[lhs].precolored ? nodes[lhs] : nodes[rhs];
+
+                if (!free.precolored && (free.allowed & fixed.allowed))
+                    free.preferred = fixed.color;
+
+                continue;
+            }
+
+            const auto allowed = nodes[lhs].allowed & nodes[rhs].allowed;
+            const auto k = (size_t) std::popcount(allowed);
+
+            if (!k)
+                continue;
+
+            // Briggs: the merged node has fewer than k neighbors of significant degree
+            std::set<uint32_t> neighbors = adjacent[lhs];
+            neighbors.insert(adjacent[rhs].begin(), adjacent[rhs].end());
+
+            const auto significant = std::count_if(neighbors.begin(), neighbors.end(), [&](uint32_t n) {
+                return adjacent[n].size() >= k;
+            });
+
+            if ((size_t) significant >= k)
+                continue;
+
+            alias[rhs] = lhs;
+            nodes[lhs].allowed = allowed;
+            nodes[lhs].weight += nodes[rhs].weight;
+
+            if (!nodes[lhs].preferred)
+                nodes[lhs].preferred = nodes[rhs].preferred;
+
+            for (auto n : adjacent[rhs]) {
+                adjacent[n].erase(rhs);
+                adjacent[n].insert(lhs);
+                adjacent[lhs].insert(n);
+            }
+
+            adjacent[rhs].clear();
+        }
+    }
+
+    std::vector<uint32_t> coloring_state::simplify() {
+        std::vector<uint32_t> stack;
+        std::vector<size_t> degree(nodes.size());
+        std::vector<bool> removed(nodes.size(), true);
+
+        std::vector<uint32_t> low;
+        size_t remaining = 0;
+
+        for (uint32_t n = 0; n < nodes.size(); n++) {
+            if (find(n) != n || nodes[n].precolored)
+                continue;
+
+            removed[n] = false;
+            degree[n] = adjacent[n].size();
+            remaining++;
+
+            if (degree[n] < (size_t) std::popcount(nodes[n].allowed))
+                low.push_back(n);
+        }
+
+        const auto remove = [&](uint32_t n) {
+            removed[n] = true;
+            stack.push_back(n);
+            remaining--;
+
+            for (auto neighbor : adjacent[n]) {
+                if (removed[neighbor])
+                    continue;
+
+                if (degree[neighbor]-- == (size_t) std::popcount(nodes[neighbor].allowed))
+                    low.push_back(neighbor);
+            }
+        };
+
+        while (remaining) {
+            if (!low.empty()) {
+                const auto n = low.back();
+                low.pop_back();
+
+                if (!removed[n])
+                    remove(n);
+
+                continue;
+            }
+
+            // Every node left has significant degree, optimistically push the one cheapest
+            // to spill relative to how many neighbors it constrains
+            std::optional<uint32_t> candidate;
+            float candidate_cost = 0;
+
+            for (uint32_t n = 0; n < nodes.size(); n++) {
+                if (removed[n])
+                    continue;
+
+                const auto cost = nodes[n].weight / (float) (degree[n] + 1);
+
+                if (!candidate || cost < candidate_cost) {
+                    candidate = n;
+                    candidate_cost = cost;
+                }
+            }
+
+            remove(*candidate);
+        }
+
+        return stack;
+    }
+
+    void coloring_state::select(std::vector<uint32_t> stack) {
+        while (!stack.empty()) {
+            auto &current = nodes[stack.back()];
+            const auto n = stack.back();
+            stack.pop_back();
+
+            register_mask used = 0;
+
+            for (auto neighbor : adjacent[n]) {
+                if (nodes[neighbor].color)
+                    used |= register_mask { 1 } << *nodes[neighbor].color;
+            }
+
+            const auto available = current.allowed & ~used;
+
+            if (current.preferred && (available & (register_mask { 1 } << *current.preferred))) {
+                current.color = current.preferred;
+                continue;
+            }
+
+            for (auto reg : context::allocatable) {
+                if (available & (register_mask { 1 } << reg)) {
+                    current.color = reg;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+regalloc::allocation regalloc::graph_coloring(const ir::global::function &function) {
+    const auto &ranges = function.metadata->live_ranges;
+    const auto usage = gather_usage(function);
+
+    coloring_state state { .usage = usage };
+    state.build_nodes(ranges);
+    state.build_interference();
+    state.coalesce(function);
+    state.select(state.simplify());
+
+    allocation result;
+    result.segments.resize(function.symbols.size());
+
+    for (const auto &node : state.nodes) {
+        const auto color = state.nodes[state.find(state.node_of[node.id])].color;
+        auto &segments = result.segments[node.id];
+
+        // Moved out of the register it arrived in before the first instruction after its arrival
+        if (usage.fixed[node.id] && !node.precolored && color != usage.fixed[node.id]) {
+            segments.push_back(segment { node.start, usage.fixed[node.id] });
+            segments.push_back(segment { node.start + 1, color });
+            result.splits.emplace_back(node.start + 1, node.id);
+            continue;
+        }
+
+        segments.push_back(segment { node.start, color });
+    }
+
+    std::sort(result.splits.begin(), result.splits.end());
+
+    return result;
+}
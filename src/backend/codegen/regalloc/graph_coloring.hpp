@@ -0,0 +1,20 @@
+#pragma once
+
+#include "allocation.hpp"
+#include "../../../ir/node_prototypes.hpp"
+
+namespace backend::regalloc {
+    /**
+     *  Assigns registers to the variables of an analyzed function by coloring their
+     *  interference graph, Chaitin-Briggs style: variables whose live ranges overlap
+     *  interfere, values related by a copy (phi operands, and the operand an arithmetic
+     *  or extension result overwrites) are coalesced when Briggs' test shows this cannot
+     *  make the graph uncolorable, and coloring is optimistic, so a node picked as a
+     *  spill candidate may still find a register.
+     *
+     *  Slower than linear_scan but sees the whole function at once, meant for builds
+     *  where the speed of the emitted code matters most. Spilled variables are not
+     *  rewritten and retried, code generation places them as it goes.
+     */
+    allocation graph_coloring(const ir::global::function &function);
+}
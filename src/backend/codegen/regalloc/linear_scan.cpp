@@ -0,0 +1,196 @@
+#include "linear_scan.hpp"
+#include "function_usage.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <span>
+#include <tuple>
+
+#include "../../../ir/nodes.hpp"
+#include "../../ir_analyzer/node_metadata.hpp"
+
+using namespace backend;
+
+namespace {
+    struct interval {
+        ir::symbol_id id;
+        uint32_t start, end;
+
+        // False for the remainder of a split interval, which starts at a use
+        bool at_definition;
+        std::optional<context::register_t> fixed;
+    };
+
+    struct active_interval {
+        ir::symbol_id id;
+        uint32_t end;
+        context::register_t reg;
+        bool fixed;
+    };
+
+    struct later_start {
+        bool operator ()(const interval &lhs, const interval &rhs) const {
+            return std::tie(lhs.start, lhs.id) > std::tie(rhs.start, rhs.id);
+        }
+    };
+
+    struct linear_scan_state {
+        regalloc::allocation result;
+
+        const regalloc::function_usage &usage;
+
+        std::priority_queue<interval, std::vector<interval>, later_start> unhandled {};
+        std::vector<active_interval> active {};
+
+        void place(ir::symbol_id id, uint32_t from, std::optional<context::register_t> reg) {
+            auto &segments = result.segments[id];
+
+            if (!segments.empty() && segments.back().reg == reg)
+                return;
+
+            if (!segments.empty())
+                result.splits.emplace_back(from, id);
+
+            segments.push_back(regalloc::segment { from, reg });
+        }
+
+        // Requeues the rest of an interval from its first use after @position. A single use
+        // left can read the spilled value directly, loading it into a register would not
+        // save anything.
+        void requeue_after(ir::symbol_id id, uint32_t position, uint32_t end) {
+            const auto use = usage.next_use(id, position);
+
+            if (!use || *use > end)
+                return;
+
+            if (const auto second = usage.next_use(id, *use); !second || *second > end)
+                return;
+
+            unhandled.push({ id, *use, end, false, std::nullopt });
+        }
+
+        void spill(const interval &current) {
+            place(current.id, current.start, std::nullopt);
+            requeue_after(current.id, current.start, current.end);
+        }
+
+        // Spills an active interval from @position on, leaving its register free
+        void split_active(size_t index, uint32_t position, uint32_t end) {
+            const auto victim = active[index];
+            active.erase(active.begin() + (std::ptrdiff_t) index);
+
+            place(victim.id, position, std::nullopt);
+            requeue_after(victim.id, position, end);
+        }
+
+        [[nodiscard]] bool held(context::register_t reg) const {
+            return std::any_of(active.begin(), active.end(), [&](const auto &a) { return a.reg == reg; });
+        }
+
+        void assign(const interval &current, context::register_t reg, uint32_t end, bool fixed) {
+            place(current.id, current.start, reg);
+            active.push_back({ current.id, end, reg, fixed });
+        }
+
+        void allocate(const interval &current, const std::vector<md::live_range> &ranges);
+    };
+
+    void linear_scan_state::allocate(const interval &current, const std::vector<md::live_range> &ranges) {
+        // A variable dying at an instruction can share its register with the one defined by it,
+        // but not with one which is only read there
+        std::erase_if(active, [&](const active_interval &a) {
+            return current.at_definition ? a.end <= current.start : a.end < current.start;
+        });
+
+        // The remainder of a split interval starts at a use, which may be a call it outlives
+        const auto call = usage.next_call(current.at_definition ? current.start : current.start - 1);
+        const auto crosses_call = call && *call < current.end;
+
+        if (current.fixed) {
+            for (size_t i = 0; i < active.size(); i++) {
+                if (active[i].reg != *current.fixed)
+                    continue;
+
+                split_active(i, current.start, ranges[active[i].id].end);
+                break;
+            }
+
+            // Calls clobber argument registers and rax, the rest is moved right before the call
+            // and competes for a register the call preserves
+            if (crosses_call) {
+                assign(current, *current.fixed, *call, true);
+                unhandled.push({ current.id, *call, current.end, false, std::nullopt });
+            } else {
+                assign(current, *current.fixed, current.end, true);
+            }
+
+            return;
+        }
+
+        const auto candidates = crosses_call
+            ? std::span<const context::register_t> { context::callee_saved }
+            : std::span<const context::register_t> { context::allocatable };
+
+        for (auto reg : candidates) {
+            if (held(reg))
+                continue;
+
+            assign(current, reg, current.end, false);
+            return;
+        }
+
+        // No register is free, take one from the active interval which is cheapest to spill
+        // for the rest of its range, if that is cheaper than spilling this one
+        std::optional<size_t> victim;
+        float victim_weight = 0;
+
+        for (size_t i = 0; i < active.size(); i++) {
+            const auto &a = active[i];
+
+            if (a.fixed || std::find(candidates.begin(), candidates.end(), a.reg) == candidates.end())
+                continue;
+
+            const auto weight = usage.spill_weight(a.id, current.start, a.end);
+
+            if (!victim || weight < victim_weight) {
+                victim = i;
+                victim_weight = weight;
+            }
+        }
+
+        if (!victim || victim_weight >= usage.spill_weight(current.id, current.start, current.end)) {
+            spill(current);
+            return;
+        }
+
+        const auto reg = active[*victim].reg;
+        split_active(*victim, current.start, ranges[active[*victim].id].end);
+        assign(current, reg, current.end, false);
+    }
+}
+
+regalloc::allocation regalloc::linear_scan(const ir::global::function &function) {
+    const auto &ranges = function.metadata->live_ranges;
+    const auto usage = gather_usage(function);
+
+    linear_scan_state state { .usage = usage };
+    state.result.segments.resize(function.symbols.size());
+
+    for (ir::symbol_id id = 0; id < function.symbols.size(); id++) {
+        if (!usage.allocated[id] || ranges[id].end <= ranges[id].start)
+            continue;
+
+        state.unhandled.push({ id, ranges[id].start, ranges[id].end, true, usage.fixed[id] });
+    }
+
+    while (!state.unhandled.empty()) {
+        const auto current = state.unhandled.top();
+        state.unhandled.pop();
+
+        state.allocate(current, ranges);
+    }
+
+    std::sort(state.result.splits.begin(), state.result.splits.end());
+
+    return std::move(state.result);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "allocation.hpp"
+#include "../../../ir/node_prototypes.hpp"
+
+namespace backend::regalloc {
+    /**
+     *  Assigns registers to the variables of an analyzed function by a linear scan over
+     *  their live ranges. Values live across a call are kept in callee saved registers,
+     *  and when registers run out the interval with the lowest spill weight (uses per
+     *  instruction covered, weighted by loop depth) is split: it is spilled from that
+     *  point and competes for a register again from its next use.
+     */
+    allocation linear_scan(const ir::global::function &function);
+}
@@ -18,18 +18,23 @@ const char*context::register_name[register_count + 2][4] = {
         { "r13b", "r13w", "r13d", "r13" },
         { "r14b", "r14w", "r14d", "r14" },
         { "r15b", "r15w", "r15d", "r15" },
-        { "r16b", "r16w", "r16d", "r16" },
         { "rsp", "rsp", "rsp", "rsp" },
         { "rbp", "rbp", "rbp", "rbp" }
 };
 
 context::register_t context::param_register(uint8_t index) {
-    const static register_t call_registers[] = {
+    const static register_t call_registers[param_register_count] = {
             rdi,
             rsi,
-            rdx
+            rdx,
+            rcx,
+            r8,
+            r9
     };
 
+    if (index >= param_register_count)
+        throw std::runtime_error("parameter is passed on the stack, not in a register");
+
     return call_registers[index];
 }
 
@@ -13,13 +13,47 @@ namespace backend::context {
         rax, rbx, rcx, rdx,
         rsi, rdi,
         r8, r9, r10, r11, r12,
-        r13, r14, r15, r16,
+        r13, r14, r15,
 
         // Not to be used for regular storage
         rsp, rbp
     };
 
-    constexpr size_t register_count = register_t::r16 + 1;
+    constexpr size_t register_count = register_t::r15 + 1;
+
+    /**
+     *  Who preserves a register across a call under the System V ABI. A caller that still
+     *  needs a value in a caller saved register after a call has to move it first, a function
+     *  modifying a callee saved register has to restore it before returning. rsp and rbp
+     *  belong to the stack frame.
+     */
+    enum class save_class : uint8_t {
+        caller_saved,
+        callee_saved,
+        reserved
+    };
+
+    constexpr save_class register_save_class(register_t reg) {
+        switch (reg) {
+            case rbx: case r12: case r13: case r14: case r15:
+                return save_class::callee_saved;
+            case rsp: case rbp:
+                return save_class::reserved;
+            default:
+                return save_class::caller_saved;
+        }
+    }
+
+    // The registers values are kept in, caller saved ones first as using them costs no save
+    inline constexpr register_t allocatable[] = {
+        rax, rcx, rdx, rsi, rdi, r8, r9, r10, r11,
+        rbx, r12, r13, r14, r15,
+    };
+
+    // Where values live across a call are kept
+    inline constexpr register_t callee_saved[] = {
+        rbx, r12, r13, r14, r15,
+    };
 
     enum register_size : uint8_t {
         byte,
@@ -32,6 +66,14 @@ namespace backend::context {
 
     const char * register_as_string(backend::context::register_t reg, ir::value_size size);
 
+    // Arguments after the first param_register_count are passed on the stack
+    constexpr size_t param_register_count = 6;
+
+    // Size of each argument passed on the stack, and where the first one is found relative to rbp
+    // once the callee's frame is set up, above the saved rbp and the return address
+    constexpr size_t stack_argument_size = 8;
+    constexpr int64_t stack_argument_offset = 16;
+
     register_t  param_register(uint8_t index);
     const char * param_register_string(uint8_t index, ir::value_size size);
 }
@@ -1,6 +1,7 @@
 #include "valuegen.hpp"
 #include "dataflow.hpp"
 #include "context/function_context.hpp"
+#include "regalloc/allocation.hpp"
 
 #include <sstream>
 
@@ -29,11 +30,14 @@ backend::context::stack_allocate(backend::context::function_context &context, si
 
     context.storage.misc_storage.emplace_back(std::move(addr));
 
-    return dynamic_cast<backend::context::memory_addr*>(addr_ptr);
+    return addr_ptr;
 }
 
 backend::context::register_storage *
 backend::context::find_register(backend::context::function_context &context, ir::value_size size) {
+    if (auto *assigned = backend::regalloc::find_assigned_register(context, size))
+        return assigned;
+
     // First check if any registers are being dropped, the most recent dropped registers are going
     // to be the operands dropped in the current instruction, so a separate routine for defaulting to
     // those is not needed.
@@ -44,12 +48,22 @@ backend::context::find_register(backend::context::function_context &context, ir:
         return context.storage.get_register(reassign, size);
     }
 
-    // Otherwise check to see if any registers can be taken temporarily
-    // i = 1 as rax should not be tampered with
-    for (auto &reg : context.storage.registers) {
-        if (reg->in_use()) continue;
+    // Otherwise take the first free register, a value that has to survive a call is best
+    // kept where the call preserves it, anything else where it costs no save
+    const auto &assigned_to = context.current_instruction->assigned_to;
 
-        return context.storage.get_register(reg->reg, size);
+    if (assigned_to && context.live_across_call[assigned_to->name.id]) {
+        for (auto reg : backend::context::callee_saved) {
+            if (context.storage.registers[reg]->in_use()) continue;
+
+            return context.storage.get_register(reg, size);
+        }
+    }
+
+    for (auto reg : backend::context::allocatable) {
+        if (context.storage.registers[reg]->in_use()) continue;
+
+        return context.storage.get_register(reg, size);
     }
 
     return nullptr;
@@ -11,16 +11,42 @@ namespace backend::context {
     struct register_storage;
     struct memory_addr;
 
+    enum class vmem_kind : uint8_t {
+        memory_addr,
+        register_storage,
+        int_literal,
+        global_pointer,
+        icmp_result,
+    };
+
+    /**
+     *  Every kind of virtual memory carries its @kind, and each subclass its own
+     *  as a static @tag, so that vmem_cast can check a downcast without RTTI.
+     */
     struct virtual_memory {
+        const vmem_kind kind;
         ir::value_size size;
 
-        explicit virtual_memory(ir::value_size size) : size(size) {}
+        explicit virtual_memory(vmem_kind kind, ir::value_size size) : kind(kind), size(size) {}
         virtual ~virtual_memory() = default;
 
-        [[nodiscard]] virtual bool addressable () const { return true; }
+        [[nodiscard]] bool addressable() const { return kind != vmem_kind::int_literal; }
     };
     using owned_vmem = std::unique_ptr<virtual_memory>;
 
+    /**
+     *  Downcasts @vmem to @T, returning nullptr if it is null or of another kind.
+     */
+    template <typename T>
+    T *vmem_cast(virtual_memory *vmem) {
+        return vmem && vmem->kind == T::tag ? static_cast<T*>(vmem) : nullptr;
+    }
+
+    template <typename T>
+    const T *vmem_cast(const virtual_memory *vmem) {
+        return vmem && vmem->kind == T::tag ? static_cast<const T*>(vmem) : nullptr;
+    }
+
     memory_addr* stack_allocate(backend::context::function_context &context, size_t size);
 
     register_storage * find_register(backend::context::function_context &context, ir::value_size size);
@@ -29,6 +55,8 @@ namespace backend::context {
     std::string get_stack_prefix(ir::value_size size);
 
     struct memory_addr : virtual_memory {
+        static constexpr vmem_kind tag = vmem_kind::memory_addr;
+
         struct scaled_reg {
             register_t reg;
             int8_t scale;
@@ -40,30 +68,32 @@ namespace backend::context {
         std::optional<register_t> unscaled;
 
         memory_addr(ir::value_size element_size, int64_t offset, scaled_reg scaled, register_t unscaled)
-            : virtual_memory(element_size), offset(offset), scaled(scaled), unscaled(unscaled) {}
+            : virtual_memory(tag, element_size), offset(offset), scaled(scaled), unscaled(unscaled) {}
         memory_addr(ir::value_size element_size, int64_t offset, register_t unscaled)
-                : virtual_memory(element_size), offset(offset), unscaled(unscaled) {}
+                : virtual_memory(tag, element_size), offset(offset), unscaled(unscaled) {}
         memory_addr(ir::value_size element_size, int64_t offset, scaled_reg scaled)
-            : virtual_memory(element_size), offset(offset), scaled(scaled) {}
+            : virtual_memory(tag, element_size), offset(offset), scaled(scaled) {}
         memory_addr(ir::value_size element_size, int64_t rbp_off)
-            : virtual_memory(element_size), offset(rbp_off), unscaled(register_t::rbp) {}
+            : virtual_memory(tag, element_size), offset(rbp_off), unscaled(register_t::rbp) {}
         ~memory_addr() override = default;
     };
 
     struct register_storage : virtual_memory {
+        static constexpr vmem_kind tag = vmem_kind::register_storage;
+
         backend::context::register_t reg;
-        std::string owner;
+        ir::symbol_id owner = ir::no_symbol;
         bool tampered = false;
 
         // do not allow register to be moved out of
         bool frozen = false;
 
         explicit register_storage(backend::context::register_t reg)
-            : virtual_memory(ir::value_size::none), reg(reg) {}
+            : virtual_memory(tag, ir::value_size::none), reg(reg) {}
         ~register_storage() override = default;
 
         [[nodiscard]] bool in_use() const {
-            return !owner.empty();
+            return owner != ir::no_symbol;
         }
 
         void grab(ir::value_size size) {
@@ -73,36 +103,38 @@ namespace backend::context {
         }
 
         void unclaim() {
-            this->owner.clear();
+            this->owner = ir::no_symbol;
             this->frozen = false;
         }
     };
 
     struct vptr_int_literal : virtual_memory {
+        static constexpr vmem_kind tag = vmem_kind::int_literal;
+
         uint64_t value;
 
         explicit vptr_int_literal(ir::value_size size, uint64_t value)
-            : virtual_memory(size), value(value) {}
+            : virtual_memory(tag, size), value(value) {}
         ~vptr_int_literal() override = default;
-
-        [[nodiscard]] bool addressable() const override {
-            return false;
-        }
     };
 
     struct global_pointer : virtual_memory {
+        static constexpr vmem_kind tag = vmem_kind::global_pointer;
+
         std::string name;
 
         explicit global_pointer(std::string name)
-            : virtual_memory(ir::value_size::ptr), name(std::move(name)) {}
+            : virtual_memory(tag, ir::value_size::ptr), name(std::move(name)) {}
         ~global_pointer() override = default;
     };
 
     struct icmp_result : virtual_memory {
+        static constexpr vmem_kind tag = vmem_kind::icmp_result;
+
         ir::block::icmp_type flag;
 
         explicit icmp_result(ir::block::icmp_type flag)
-            : virtual_memory(ir::value_size::i1), flag(flag) {}
+            : virtual_memory(tag, ir::value_size::i1), flag(flag) {}
         ~icmp_result() override = default;
     };
 }
\ No newline at end of file
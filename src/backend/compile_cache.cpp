@@ -0,0 +1,189 @@
+#include "compile_cache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "ir_optimizer/pass_manager.hpp"
+#include "../ir/output/ir_emitter.hpp"
+
+namespace {
+    // Part of every key, to be bumped whenever the generated code changes so entries
+    // written by an older compiler are not reused
+    constexpr std::string_view cache_format_version = "2";
+
+    constexpr std::string_view entry_extension = ".asm";
+
+    __extension__ using uint128 = unsigned __int128;
+
+    std::string fnv1a_128(std::string_view data) {
+        constexpr uint128 prime = ((uint128) 1 << 88) + 0x13B;
+        uint128 hash = ((uint128) 0x6C62272E07BB0142 << 64) + 0x62B821756295C58D;
+
+        for (const auto c : data) {
+            hash ^= (uint8_t) c;
+            hash *= prime;
+        }
+
+        constexpr char digits[] = "0123456789abcdef";
+        std::string result(32, '0');
+
+        for (size_t i = 0; i < 32; i++) {
+            result[31 - i] = digits[(size_t) (hash & 0xF)];
+            hash >>= 4;
+        }
+
+        return result;
+    }
+}
+
+backend::compile_cache::compile_cache(std::filesystem::path directory, size_t max_bytes)
+        : directory(std::move(directory)), max_bytes(max_bytes) {
+    std::filesystem::create_directories(this->directory);
+
+    struct existing {
+        std::string key;
+        size_t size;
+        std::filesystem::file_time_type last_use;
+    };
+
+    std::vector<existing> found;
+
+    for (const auto &file : std::filesystem::directory_iterator { this->directory }) {
+        if (!file.is_regular_file() || file.path().extension() != entry_extension)
+            continue;
+
+        found.push_back({ file.path().stem().string(), (size_t) file.file_size(), file.last_write_time() });
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) {
+        return a.last_use > b.last_use;
+    });
+
+    for (auto &file : found) {
+        total_bytes += file.size;
+        recency.push_back(file.key);
+        entries.emplace(std::move(file.key), entry { file.size, std::prev(recency.end()) });
+    }
+
+    // The limit may have been lowered since the entries were written
+    evict(0);
+}
+
+std::filesystem::path backend::compile_cache::entry_path(std::string_view key) const {
+    return directory / std::string(key).append(entry_extension);
+}
+
+std::string backend::compile_cache::key(const ir::global::function &function, const compile_options &options) {
+    std::stringstream canonical;
+
+    canonical << cache_format_version << '\n'
+              << (int) options.regalloc << '\n';
+
+    // Entries hold the generated code of the IR before optimization
+    for (const auto *pass : opt::pipeline(options))
+        canonical << pass->name << ' ';
+
+    canonical << '\n';
+
+    ir::output::emit_function(canonical, function);
+
+    return fnv1a_128(canonical.view());
+}
+
+std::optional<std::string> backend::compile_cache::find(const std::string &key) {
+    std::lock_guard lock { mutex };
+
+    const auto found = entries.find(key);
+
+    if (found == entries.end()) {
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    const auto path = entry_path(key);
+    std::ifstream file { path, std::ios::binary };
+
+    // Removed by another process, which counts as a miss
+    if (!file) {
+        total_bytes -= found->second.size;
+        recency.erase(found->second.recency);
+        entries.erase(found);
+
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    std::string text { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+
+    recency.splice(recency.begin(), recency, found->second.recency);
+
+    std::error_code ignored;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ignored);
+
+    stats.hits++;
+    return text;
+}
+
+void backend::compile_cache::store(const std::string &key, std::string_view text) {
+    std::lock_guard lock { mutex };
+
+    if (text.size() > max_bytes || entries.contains(key))
+        return;
+
+    evict(text.size());
+
+    // Written under a temporary name first, so other processes never read a partial entry
+    const auto path = entry_path(key);
+    auto temporary = path;
+    temporary += ".tmp";
+
+    {
+        std::ofstream file { temporary, std::ios::binary };
+        file.write(text.data(), (std::streamsize) text.size());
+
+        if (!file)
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+
+    recency.push_front(key);
+    entries.emplace(key, entry { text.size(), recency.begin() });
+    total_bytes += text.size();
+
+    stats.stores++;
+}
+
+void backend::compile_cache::evict(size_t bytes_needed) {
+    while (!recency.empty() && total_bytes + bytes_needed > max_bytes) {
+        const auto &key = recency.back();
+        const auto found = entries.find(key);
+
+        std::error_code ignored;
+        std::filesystem::remove(entry_path(key), ignored);
+
+        total_bytes -= found->second.size;
+        entries.erase(found);
+        recency.pop_back();
+
+        stats.evictions++;
+    }
+}
+
+backend::cache_statistics backend::compile_cache::statistics() const {
+    std::lock_guard lock { mutex };
+    return stats;
+}
+
+size_t backend::compile_cache::size_in_bytes() const {
+    std::lock_guard lock { mutex };
+    return total_bytes;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../ir/nodes.hpp"
+#include "compile_options.hpp"
+
+namespace backend {
+    struct cache_statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t stores = 0;
+        size_t evictions = 0;
+    };
+
+    /**
+     *  An on-disk cache of generated assembly, one file per function in @directory named
+     *  after a hash of the function's IR and the options it was compiled with, so an
+     *  unchanged function is found again by whichever process compiles it next.
+     *
+     *  The cache is kept under @max_bytes by evicting the least recently used entries.
+     *  Recency survives between processes as the entries' modification times, which
+     *  hits refresh. It is safe to use from several threads at once.
+     */
+    class compile_cache {
+        struct entry {
+            size_t size;
+            std::list<std::string>::iterator recency;
+        };
+
+        std::filesystem::path directory;
+        size_t max_bytes;
+
+        mutable std::mutex mutex;
+
+        // Keys from most to least recently used
+        std::list<std::string> recency;
+        std::unordered_map<std::string, entry> entries;
+        size_t total_bytes = 0;
+
+        cache_statistics stats {};
+
+        [[nodiscard]] std::filesystem::path entry_path(std::string_view key) const;
+        void evict(size_t bytes_needed);
+
+    public:
+        compile_cache(std::filesystem::path directory, size_t max_bytes);
+
+        /**
+         *  The key of @function's generated code, a 128 bit FNV-1a hash of its emitted IR
+         *  and the options affecting codegen.
+         */
+        [[nodiscard]] static std::string key(const ir::global::function &function, const compile_options &options);
+
+        std::optional<std::string> find(const std::string &key);
+        void store(const std::string &key, std::string_view text);
+
+        [[nodiscard]] cache_statistics statistics() const;
+        [[nodiscard]] size_t size_in_bytes() const;
+    };
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace backend {
+    class compile_cache;
+
+    namespace opt {
+        class pass_statistics;
+    }
+
+    enum class regalloc_mode : uint8_t {
+        /**
+         *  Registers are chosen while instructions are generated, taking the first
+         *  free one and spilling on demand.
+         */
+        greedy,
+
+        /**
+         *  Registers are assigned ahead of generation by a linear scan over the
+         *  variables' live ranges, see backend::regalloc::linear_scan.
+         */
+        linear,
+
+        /**
+         *  Registers are assigned ahead of generation by coloring the interference
+         *  graph, see backend::regalloc::graph_coloring. Slower to compile, for builds
+         *  where the speed of the emitted code matters most.
+         */
+        coloring,
+    };
+
+    inline std::optional<regalloc_mode> parse_regalloc_mode(std::string_view name) {
+        if (name == "greedy") return regalloc_mode::greedy;
+        if (name == "linear") return regalloc_mode::linear;
+        if (name == "coloring") return regalloc_mode::coloring;
+
+        return std::nullopt;
+    }
+
+    enum class opt_level : uint8_t {
+        // The IR is generated as written
+        O0,
+
+        // Only cleanups which are cheap and never make the generated code slower
+        O1,
+
+        // Every optimization, for builds where the speed of the emitted code matters most
+        O2,
+    };
+
+    // The level named by what follows -O on the command line
+    inline std::optional<opt_level> parse_opt_level(std::string_view name) {
+        if (name == "0") return opt_level::O0;
+        if (name == "1") return opt_level::O1;
+        if (name == "2") return opt_level::O2;
+
+        return std::nullopt;
+    }
+
+    struct compile_options {
+        /**
+         *  Number of threads functions are analyzed and generated on. Functions are
+         *  still emitted in source order, so the output does not depend on this.
+         */
+        size_t threads = 1;
+
+        regalloc_mode regalloc = regalloc_mode::greedy;
+
+        /**
+         *  If set, functions whose generated assembly is in the cache are neither analyzed
+         *  nor generated again, and newly generated ones are added to it.
+         */
+        compile_cache *cache = nullptr;
+
+        opt_level optimization = opt_level::O1;
+
+        /**
+         *  If not empty, the IR passes run instead of the optimization level's pipeline,
+         *  by name and in order, see backend::opt::registered_passes.
+         */
+        std::vector<std::string> passes {};
+
+        // If set, the time and change in IR size of every pass run are added to it
+        opt::pass_statistics *pass_statistics = nullptr;
+    };
+}
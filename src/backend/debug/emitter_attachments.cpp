@@ -5,16 +5,20 @@
 
 #include <vector>
 
-void backend::output::attach_variable_drop(std::ostream &ostream, const ir::block::block_instruction &block_instruction) {
-    std::vector<std::string> dropped_vars;
+void backend::output::attach_variable_drop(std::ostream &ostream, const ir::symbol_table &symbols,
+                                           const ir::block::block_instruction &block_instruction) {
+    std::vector<std::string_view> dropped_vars;
 
     for (size_t i = 0; i < block_instruction.operands.size(); i++) {
-        if (!block_instruction.metadata->dropped_data[i]) continue;
+        if (!block_instruction.metadata.dropped_data[i]) continue;
 
         const auto &operand = block_instruction.operands[i];
-        dropped_vars.emplace_back(operand.get_name());
+        dropped_vars.emplace_back(symbols.name(operand.get_id()));
     }
 
+    for (const auto id : block_instruction.metadata.dropped_after)
+        dropped_vars.emplace_back(symbols.name(id));
+
     if (dropped_vars.empty())
         return;
 
@@ -2,10 +2,15 @@
 
 #include <ostream>
 
+namespace ir {
+    struct symbol_table;
+}
+
 namespace ir::block {
     struct block_instruction;
 }
 
 namespace backend::output {
-    void attach_variable_drop(std::ostream &ostream, const ir::block::block_instruction &block_instruction);
+    void attach_variable_drop(std::ostream &ostream, const ir::symbol_table &symbols,
+                              const ir::block::block_instruction &block_instruction);
 }
\ No newline at end of file
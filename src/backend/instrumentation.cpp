@@ -0,0 +1,273 @@
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#include "../ir/nodes.hpp"
+
+#ifdef BACKEND_COUNT_ALLOCATIONS
+namespace {
+    thread_local uint64_t allocation_count = 0;
+
+    void *counted_allocate(std::size_t size) noexcept {
+        allocation_count++;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+// Every unaligned form is replaced, so that memory is never freed by a different allocator
+// than the one it came from
+void *operator new(std::size_t size) {
+    if (void *memory = counted_allocate(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size);
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+
+uint64_t backend::instrument::thread_allocations() {
+    return allocation_count;
+}
+
+bool backend::instrument::counts_allocations() {
+    return true;
+}
+#else
+uint64_t backend::instrument::thread_allocations() {
+    return 0;
+}
+
+bool backend::instrument::counts_allocations() {
+    return false;
+}
+#endif
+
+const char *backend::instrument::phase_name(phase which) {
+    switch (which) {
+        case phase::lex: return "lex";
+        case phase::parse: return "parse";
+        case phase::optimize: return "optimize";
+        case phase::metadata: return "metadata";
+        case phase::variable_lifetimes: return "variable_lifetimes";
+        case phase::codegen: return "codegen";
+        case phase::print: return "print";
+        case phase::encode: return "encode";
+    }
+
+    return "unknown";
+}
+
+const char *backend::instrument::counter_name(counter which) {
+    switch (which) {
+        case counter::instructions_in: return "instructions_in";
+        case counter::asm_nodes_out: return "asm_nodes_out";
+        case counter::spills: return "spills";
+        case counter::movs_elided: return "movs_elided";
+        case counter::registers_pushed: return "registers_pushed";
+    }
+
+    return "unknown";
+}
+
+void backend::instrument::profile::add_phase(phase which, uint64_t duration, uint64_t allocation_count) {
+    const auto index = (size_t) which;
+
+    calls[index].fetch_add(1, std::memory_order_relaxed);
+    nanoseconds[index].fetch_add(duration, std::memory_order_relaxed);
+    allocations[index].fetch_add(allocation_count, std::memory_order_relaxed);
+}
+
+void backend::instrument::profile::add(counter which, uint64_t amount) {
+    counters[(size_t) which].fetch_add(amount, std::memory_order_relaxed);
+}
+
+backend::instrument::phase_totals backend::instrument::profile::totals(phase which) const {
+    const auto index = (size_t) which;
+
+    return {
+        .calls = calls[index].load(std::memory_order_relaxed),
+        .nanoseconds = nanoseconds[index].load(std::memory_order_relaxed),
+        .allocations = allocations[index].load(std::memory_order_relaxed),
+    };
+}
+
+uint64_t backend::instrument::profile::value(counter which) const {
+    return counters[(size_t) which].load(std::memory_order_relaxed);
+}
+
+void backend::instrument::profile::write_table(std::ostream &ostream) const {
+    const auto flags = ostream.flags();
+    const auto precision = ostream.precision();
+
+    ostream << std::left << std::setw(20) << "phase"
+            << std::right << std::setw(10) << "calls"
+            << std::setw(14) << "time (ms)"
+            << std::setw(14) << "allocations" << '\n';
+
+    for (size_t i = 0; i < phase_count; i++) {
+        const auto current = totals((phase) i);
+
+        ostream << std::left << std::setw(20) << phase_name((phase) i)
+                << std::right << std::setw(10) << current.calls
+                << std::setw(14) << std::fixed << std::setprecision(3) << (double) current.nanoseconds / 1e6;
+
+        if (counts_allocations())
+            ostream << std::setw(14) << current.allocations << '\n';
+        else
+            ostream << std::setw(14) << "-" << '\n';
+    }
+
+    ostream << '\n' << std::left << std::setw(20) << "counter" << std::right << std::setw(10) << "value" << '\n';
+
+    for (size_t i = 0; i < counter_count; i++) {
+        ostream << std::left << std::setw(20) << counter_name((counter) i)
+                << std::right << std::setw(10) << value((counter) i) << '\n';
+    }
+
+    ostream.flags(flags);
+    ostream.precision(precision);
+}
+
+void backend::instrument::profile::write_json(std::ostream &ostream) const {
+    ostream << "{\"phases\":{";
+
+    for (size_t i = 0; i < phase_count; i++) {
+        const auto current = totals((phase) i);
+
+        if (i != 0) ostream << ',';
+
+        ostream << '"' << phase_name((phase) i) << "\":{"
+                << "\"calls\":" << current.calls << ','
+                << "\"nanoseconds\":" << current.nanoseconds << ','
+                << "\"allocations\":";
+
+        if (counts_allocations())
+            ostream << current.allocations;
+        else
+            ostream << "null";
+
+        ostream << '}';
+    }
+
+    ostream << "},\"counters\":{";
+
+    for (size_t i = 0; i < counter_count; i++) {
+        if (i != 0) ostream << ',';
+
+        ostream << '"' << counter_name((counter) i) << "\":" << value((counter) i);
+    }
+
+    ostream << "}}\n";
+}
+
+void backend::instrument::trace::add(event span) {
+    std::lock_guard lock { mutex };
+    recorded.emplace_back(std::move(span));
+}
+
+std::vector<backend::instrument::trace::event> backend::instrument::trace::events() const {
+    std::lock_guard lock { mutex };
+    return recorded;
+}
+
+namespace {
+    void write_json_string(std::ostream &ostream, std::string_view text) {
+        ostream << '"';
+
+        for (const auto c : text) {
+            if (c == '"' || c == '\\') {
+                ostream << '\\' << c;
+            } else if ((unsigned char) c < 0x20) {
+                constexpr char digits[] = "0123456789abcdef";
+                ostream << "\\u00" << digits[(c >> 4) & 0xF] << digits[c & 0xF];
+            } else {
+                ostream << c;
+            }
+        }
+
+        ostream << '"';
+    }
+
+    void write_microseconds(std::ostream &ostream, std::chrono::steady_clock::duration duration) {
+        const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+        // Fixed point, since the viewers read fractional microseconds
+        ostream << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+    }
+}
+
+void backend::instrument::trace::write_json(std::ostream &ostream) const {
+    const auto flags = ostream.flags();
+    const auto fill = ostream.fill();
+
+    ostream << "{\"traceEvents\":[";
+
+    bool first = true;
+
+    for (const auto &span : events()) {
+        if (!first) ostream << ',';
+        first = false;
+
+        // Complete events, each with its own start and duration
+        ostream << "\n{\"name\":";
+        write_json_string(ostream, span.name);
+        ostream << ",\"cat\":\"" << span.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.thread
+                << ",\"ts\":";
+        write_microseconds(ostream, std::max(span.start - origin, clock::duration::zero()));
+        ostream << ",\"dur\":";
+        write_microseconds(ostream, span.end - span.start);
+
+        if (span.details) {
+            ostream << ",\"args\":{\"function\":";
+            write_json_string(ostream, span.name);
+            ostream << ",\"blocks\":" << span.details->blocks
+                    << ",\"instructions\":" << span.details->instructions << '}';
+        }
+
+        ostream << '}';
+    }
+
+    ostream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    ostream.flags(flags);
+    ostream.fill(fill);
+}
+
+uint32_t backend::instrument::trace_thread() {
+    static std::atomic<uint32_t> next_thread = 1;
+    thread_local const uint32_t thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+
+    return thread;
+}
+
+void backend::instrument::function_span::finish() {
+    size_t instructions = 0;
+
+    for (const auto &block : function->blocks)
+        instructions += block.instructions.size();
+
+    tracing->add({
+        function->name, "function", start, trace::clock::now(), trace_thread(),
+        trace::function_details { function->blocks.size(), instructions }
+    });
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ir::global {
+    struct function;
+}
+
+namespace backend::instrument {
+    enum class phase : uint8_t {
+        lex, parse, optimize, metadata, variable_lifetimes, codegen, print, encode
+    };
+
+    constexpr size_t phase_count = (size_t) phase::encode + 1;
+
+    enum class counter : uint8_t {
+        // IR instructions of the generated functions
+        instructions_in,
+
+        // Asm nodes left to print or encode after codegen
+        asm_nodes_out,
+
+        // Values moved to the stack for lack of a register
+        spills,
+
+        // Movs dropped for having the same source and destination
+        movs_elided,
+
+        // Callee saved registers pushed by function prologues
+        registers_pushed,
+    };
+
+    constexpr size_t counter_count = (size_t) counter::registers_pushed + 1;
+
+    const char *phase_name(phase which);
+    const char *counter_name(counter which);
+
+    struct phase_totals {
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+        uint64_t allocations = 0;
+    };
+
+    /**
+     *  Where compile time and allocations go, per phase, and counts of what was generated.
+     *  Phases on several threads are summed, so with threads their times can add up to
+     *  more than the wall time of the compile.
+     */
+    class profile {
+        std::array<std::atomic<uint64_t>, phase_count> calls {};
+        std::array<std::atomic<uint64_t>, phase_count> nanoseconds {};
+        std::array<std::atomic<uint64_t>, phase_count> allocations {};
+        std::array<std::atomic<uint64_t>, counter_count> counters {};
+
+    public:
+        void add_phase(phase which, uint64_t duration, uint64_t allocation_count);
+        void add(counter which, uint64_t amount);
+
+        [[nodiscard]] phase_totals totals(phase which) const;
+        [[nodiscard]] uint64_t value(counter which) const;
+
+        void write_table(std::ostream &ostream) const;
+        void write_json(std::ostream &ostream) const;
+    };
+
+    // The profile being recorded into, set by profile_scope
+    inline std::atomic<profile*> active_profile = nullptr;
+
+    /**
+     *  Records into @target while in scope, instrumentation elsewhere is a single
+     *  load and branch.
+     */
+    class profile_scope {
+        profile *previous;
+
+    public:
+        explicit profile_scope(profile &target) : previous(active_profile.exchange(&target)) {}
+        ~profile_scope() { active_profile = previous; }
+
+        profile_scope(const profile_scope&) = delete;
+        profile_scope &operator=(const profile_scope&) = delete;
+    };
+
+    /**
+     *  Heap allocations made by the calling thread so far. Only counted in builds
+     *  defining BACKEND_COUNT_ALLOCATIONS, which replaces the global operator new.
+     */
+    uint64_t thread_allocations();
+    bool counts_allocations();
+
+    /**
+     *  A timeline of spans in the Chrome trace event format, which Perfetto and
+     *  chrome://tracing load, to find which functions of a module are slow to compile.
+     *  Spans are recorded for every phase and every function generated.
+     */
+    class trace {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        struct function_details {
+            size_t blocks;
+            size_t instructions;
+        };
+
+        struct event {
+            std::string name;
+            const char *category;
+            clock::time_point start;
+            clock::time_point end;
+            uint32_t thread;
+
+            // Only set for the spans of generated functions
+            std::optional<function_details> details;
+        };
+
+    private:
+        clock::time_point origin = clock::now();
+
+        mutable std::mutex mutex;
+        std::vector<event> recorded;
+
+    public:
+        void add(event span);
+
+        [[nodiscard]] std::vector<event> events() const;
+
+        void write_json(std::ostream &ostream) const;
+    };
+
+    // The trace being recorded into, set by trace_scope
+    inline std::atomic<trace*> active_trace = nullptr;
+
+    class trace_scope {
+        trace *previous;
+
+    public:
+        explicit trace_scope(trace &target) : previous(active_trace.exchange(&target)) {}
+        ~trace_scope() { active_trace = previous; }
+
+        trace_scope(const trace_scope&) = delete;
+        trace_scope &operator=(const trace_scope&) = delete;
+    };
+
+    // A small number identifying the calling thread in traces
+    uint32_t trace_thread();
+
+    /**
+     *  Adds the time and allocations from construction to destruction to @which, and
+     *  a span for it to the active trace.
+     */
+    class phase_timer {
+        using clock = std::chrono::steady_clock;
+
+        profile *target;
+        trace *tracing;
+        phase which;
+        clock::time_point start {};
+        uint64_t start_allocations = 0;
+
+    public:
+        explicit phase_timer(phase which) : target(active_profile.load(std::memory_order_relaxed)),
+                                            tracing(active_trace.load(std::memory_order_relaxed)),
+                                            which(which) {
+            if (!target && !tracing) return;
+
+            if (target)
+                start_allocations = thread_allocations();
+
+            start = clock::now();
+        }
+
+        ~phase_timer() {
+            if (!target && !tracing) return;
+
+            const auto end = clock::now();
+
+            if (target) {
+                const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                target->add_phase(which, (uint64_t) duration.count(), thread_allocations() - start_allocations);
+            }
+
+            if (tracing)
+                tracing->add({ phase_name(which), "phase", start, end, trace_thread(), std::nullopt });
+        }
+
+        phase_timer(const phase_timer&) = delete;
+        phase_timer &operator=(const phase_timer&) = delete;
+    };
+
+    /**
+     *  Adds a span for generating @function to the active trace, annotated with its
+     *  name and size. Its blocks are only counted when tracing.
+     */
+    class function_span {
+        trace *tracing;
+        const ir::global::function *function = nullptr;
+        trace::clock::time_point start {};
+
+        void finish();
+
+    public:
+        explicit function_span(const ir::global::function &function) : tracing(active_trace.load(std::memory_order_relaxed)) {
+            if (!tracing) return;
+
+            this->function = &function;
+            start = trace::clock::now();
+        }
+
+        ~function_span() {
+            if (tracing) finish();
+        }
+
+        function_span(const function_span&) = delete;
+        function_span &operator=(const function_span&) = delete;
+    };
+
+    inline void count(counter which, uint64_t amount = 1) {
+        if (auto *target = active_profile.load(std::memory_order_relaxed))
+            target->add(which, amount);
+    }
+}
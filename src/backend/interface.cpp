@@ -1,41 +1,147 @@
 #include "interface.hpp"
 
 #include <iostream>
-#include <fstream>
 
 #include "ir_analyzer/ir_analyzer.hpp"
 #include "codegen/codegen.hpp"
+#include "compile_cache.hpp"
+#include "instrumentation.hpp"
+#include "codegen/asmgen/elf_writer.hpp"
+#include "ir_optimizer/pass_manager.hpp"
+#include "parallel.hpp"
 #include "../ir/input/lexer.hpp"
 #include "../ir/input/parser.hpp"
 
-std::vector<ir::lexer::token> backend::lex(std::string_view file_name) {
-    std::ifstream file { file_name.begin() };
+backend::lexed_file backend::lex(std::string_view file_name) {
+    backend::lexed_file lexed { ir::input::source_file { file_name } };
 
-    if (!file.is_open()) {
+    if (!lexed.source.is_open()) {
         std::cerr << "Failed to open file " << file_name << '\n';
         exit(1);
     }
 
-    std::string input { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
-
-    return ir::lexer::lex(input);
+    lexed.tokens = ir::lexer::lex(lexed.source.view(), lexed.identifiers);
+    return lexed;
 }
 
 ir::root backend::gen_ast(std::string_view file_name) {
     auto lex = backend::lex(file_name);
-    return ir::parser::parse(lex);
+    return ir::parser::parse(lex.tokens);
 }
 
-void backend::compile(ir::root &root, std::ostream &ostream) {
-    analyze_ir(root);
-    backend::context::generate(root, ostream);
+void backend::compile(ir::root &root, std::ostream &ostream, const compile_options &options) {
+    if (!options.cache) {
+        backend::opt::optimize(root, options);
+        analyze_ir(root, options);
+        backend::context::generate(root, ostream, options);
+        return;
+    }
+
+    // Functions are looked up by their IR before optimization, so only those missing
+    // from the cache are optimized and need their metadata
+    std::vector<backend::context::cached_function> cached(root.functions.size());
+    const auto passes = backend::opt::pipeline(options);
+
+    backend::parallel_for(root.functions.size(), options.threads, [&](size_t i) {
+        cached[i].key = compile_cache::key(root.functions[i], options);
+        cached[i].text = options.cache->find(cached[i].key);
+
+        if (cached[i].text)
+            return;
+
+        {
+            backend::instrument::phase_timer timer { backend::instrument::phase::optimize };
+            backend::opt::optimize_function(root.functions[i], passes, options.pass_statistics);
+        }
+
+        backend::md::analyze_function(root.functions[i]);
+    });
+
+    backend::context::generate(root, ostream, options, cached);
 }
 
-void backend::compile(std::string_view file_name, std::ostream &ostream) {
+void backend::compile(std::string_view file_name, std::ostream &ostream, const compile_options &options) {
     auto ast = backend::gen_ast(file_name);
-    backend::compile(ast, ostream);
+    backend::compile(ast, ostream, options);
+}
+
+backend::as::encoded_module backend::assemble(ir::root &root, const compile_options &options) {
+    backend::opt::optimize(root, options);
+    analyze_ir(root, options);
+    return backend::context::encode(root, options);
+}
+
+void backend::compile_object(ir::root &root, std::ostream &ostream, const compile_options &options) {
+    backend::as::write_elf_object(assemble(root, options), ostream);
+}
+
+void backend::compile_streaming(std::string_view file_name, std::ostream &ostream, const compile_options &options) {
+    ir::input::source_file source { file_name };
+
+    if (!source.is_open()) {
+        std::cerr << "Failed to open file " << file_name << '\n';
+        exit(1);
+    }
+
+    ir::lexer::identifier_table identifiers;
+    ir::lexer::incremental_lexer lexer { source.view(), identifiers };
+    std::vector<ir::lexer::token> tokens;
+
+    // Only holds global strings and extern declarations, functions are dropped once generated
+    ir::root root {};
+    backend::context::module_output output { ostream };
+
+    constexpr size_t release_granularity = 1024 * 1024;
+    size_t released = 0;
+
+    const auto passes = backend::opt::pipeline(options);
+
+    backend::context::gen_header(output);
+
+    while (lexer.next_global(tokens)) {
+        auto start = tokens.cbegin();
+        auto global = [&]() {
+            backend::instrument::phase_timer timer { backend::instrument::phase::parse };
+            return ir::parser::parse_global(start, tokens.cend());
+        }();
+
+        tokens.clear();
+
+        if (!global)
+            continue;
+
+        std::visit([&](auto &&node) {
+            using T = std::decay_t<decltype(node)>;
+
+            if constexpr (std::is_same_v<T, ir::global::global_string>) {
+                backend::context::gen_global_string(output, node);
+                root.global_strings.emplace_back(std::move(node));
+            } else if constexpr (std::is_same_v<T, ir::global::extern_function>) {
+                backend::context::gen_extern_function(output, node);
+                root.extern_functions.emplace_back(std::move(node));
+            } else {
+                {
+                    backend::instrument::phase_timer timer { backend::instrument::phase::optimize };
+                    backend::opt::optimize_function(node, passes, options.pass_statistics);
+                }
+
+                backend::md::analyze_function(node);
+
+                output.switch_section("text");
+                backend::context::gen_function(root, ostream, node, output.global_strings, options);
+            }
+        }, *global);
+
+        // Dropping consumed pages one function at a time would mostly be syscall overhead
+        if (lexer.pos - released >= release_granularity) {
+            source.release_before(lexer.pos);
+            released = lexer.pos;
+        }
+    }
 }
 
-void backend::analyze_ir(ir::root &root) {
-    backend::md::analyze(root);
+void backend::analyze_ir(ir::root &root, const compile_options &options) {
+    backend::parallel_for(root.functions.size(), options.threads, [&](size_t i) {
+        backend::md::analyze_function(root.functions[i]);
+    });
 }
\ No newline at end of file
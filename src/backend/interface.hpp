@@ -5,15 +5,53 @@
 
 #include "../ir/nodes.hpp"
 #include "../ir/input/lexer.hpp"
+#include "../ir/input/source_file.hpp"
+#include "ir_optimizer/constant_propagation.hpp"
 #include "ir_optimizer/dead_code_elim.hpp"
+#include "ir_optimizer/mem2reg.hpp"
+#include "ir_optimizer/pass_manager.hpp"
+#include "compile_options.hpp"
+#include "codegen/asmgen/encoder.hpp"
 
 namespace backend {
-    std::vector<ir::lexer::token> lex(std::string_view file_name);
+    /**
+     *  Tokens are views into the mapped source, so the two are kept together
+     *  and share a lifetime.
+     */
+    struct lexed_file {
+        ir::input::source_file source;
+        ir::lexer::identifier_table identifiers {};
+        std::vector<ir::lexer::token> tokens {};
+    };
+
+    lexed_file lex(std::string_view file_name);
 
     ir::root gen_ast(std::string_view file_name);
 
-    void compile(ir::root &root, std::ostream &ostream);
-    void compile(std::string_view file_name, std::ostream &ostream);
+    void compile(ir::root &root, std::ostream &ostream, const compile_options &options = {});
+    void compile(std::string_view file_name, std::ostream &ostream, const compile_options &options = {});
+
+    /**
+     *  Compiles to x86-64 machine code instead of assembly text, leaving references
+     *  to functions and globals as relocations.
+     */
+    as::encoded_module assemble(ir::root &root, const compile_options &options = {});
+
+    /**
+     *  Compiles to an ELF64 relocatable object written to @ostream, ready to be linked
+     *  without going through an assembler.
+     */
+    void compile_object(ir::root &root, std::ostream &ostream, const compile_options &options = {});
+
+    /**
+     *  Compiles a file one global node at a time: each function is lexed, parsed,
+     *  optimized, analyzed and generated before the next one is read, and freed afterwards,
+     *  so memory use is bounded by the largest function rather than the module.
+     *
+     *  Unlike compile, a global string must be declared before any function
+     *  referencing it.
+     */
+    void compile_streaming(std::string_view file_name, std::ostream &ostream, const compile_options &options = {});
 
-    void analyze_ir(ir::root &root);
+    void analyze_ir(ir::root &root, const compile_options &options = {});
 }
@@ -2,25 +2,32 @@
 
 #include "node_metadata.hpp"
 #include "scope_analyzer.hpp"
+#include "../instrumentation.hpp"
 
-void add_empty_metadata(ir::root &root);
+void add_empty_metadata(ir::global::function &function);
 
 void backend::md::analyze(ir::root &root) {
-    add_empty_metadata(root);
-
     for (auto &node : root.functions) {
-        backend::md::analyze_variable_lifetimes(node);
+        backend::md::analyze_function(node);
     }
 }
 
-void add_empty_metadata(ir::root &root) {
-    for (auto &function : root.functions) {
-        function.metadata = std::make_unique<backend::md::function_metadata>(function);
+void backend::md::analyze_function(ir::global::function &function) {
+    {
+        backend::instrument::phase_timer timer { backend::instrument::phase::metadata };
+        add_empty_metadata(function);
+    }
+
+    backend::instrument::phase_timer timer { backend::instrument::phase::variable_lifetimes };
+    backend::md::analyze_variable_lifetimes(function);
+}
+
+void add_empty_metadata(ir::global::function &function) {
+    function.metadata = std::make_unique<backend::md::function_metadata>(function);
 
-        for (auto &block : function.blocks) {
-            for (auto &instruction : block.instructions) {
-                instruction.metadata = std::make_unique<backend::md::instruction_metadata>(instruction);
-            }
+    for (auto &block : function.blocks) {
+        for (auto &instruction : block.instructions) {
+            instruction.metadata = {};
         }
     }
 }
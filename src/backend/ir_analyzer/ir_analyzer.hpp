@@ -4,4 +4,5 @@
 
 namespace backend::md {
     void analyze(ir::root &root);
-}
\ No newline at end of file
+    void analyze_function(ir::global::function &function);
+}
@@ -6,19 +6,40 @@
 #include <variant>
 
 #include "../../ir/node_prototypes.hpp"
+#include "../../ir/small_vector.hpp"
+#include "../../ir/symbol_table.hpp"
 
 namespace backend::md {
+    /**
+     *  Held inline by the instruction it describes. @dropped_data has one entry per
+     *  operand, set if the operand's variable is dead after the instruction.
+     *  @dropped_after lists variables not used by the instruction which are dead
+     *  after it, only ever set on the last instruction of a block.
+     */
     struct instruction_metadata {
-        const ir::block::block_instruction &instruction;
-        std::vector<bool> dropped_data;
+        ir::small_vector<bool, 6> dropped_data;
+        ir::small_vector<ir::symbol_id, 2> dropped_after;
+    };
 
-        explicit instruction_metadata(const ir::block::block_instruction &instruction)
-            : instruction(instruction) {}
+    /**
+     *  The span of instruction positions (numbered from 1 in block order, 0 being
+     *  function entry) over which a variable has to be kept, from its definition to
+     *  the last point it is live. An @end of 0 means the variable is never used.
+     */
+    struct live_range {
+        uint32_t start = 0;
+        uint32_t end = 0;
     };
 
     struct function_metadata {
         const ir::global::function &function;
 
+        // Indexed by symbol id
+        std::vector<live_range> live_ranges {};
+
+        // Indexed by block index, the variables live on entry to each block, its phis aside
+        std::vector<std::vector<ir::symbol_id>> live_in {};
+
         explicit function_metadata(const ir::global::function &function)
             : function(function) {}
     };
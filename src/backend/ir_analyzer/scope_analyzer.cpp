@@ -1,43 +1,239 @@
 #include "scope_analyzer.hpp"
 #include "node_metadata.hpp"
 
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
-void backend::md::analyze_variable_lifetimes(ir::global::function &function) {
-    std::unordered_map<std::string, const ir::block::block_instruction*> lifetime_map {};
+namespace {
+    /**
+     *  One bitset of @width words per block, stored contiguously, over the symbol
+     *  ids of a function.
+     */
+    struct block_sets {
+        size_t width;
+        std::vector<uint64_t> words;
 
-    const auto document_lifetime = [&] (const ir::value &value, const ir::block::block_instruction &instruction) {
-        if (value.is_literal()) return;
+        block_sets(size_t blocks, size_t symbols)
+            : width((symbols + 63) / 64), words(blocks * width, 0) {}
 
-        lifetime_map[value.get_name().data()] = &instruction;
+        uint64_t *operator [](size_t block) { return words.data() + block * width; }
+        const uint64_t *operator [](size_t block) const { return words.data() + block * width; }
     };
 
-    // First Pass - Document the last instruction where a variable is referenced
-    for (const auto &block : function.blocks) {
-        for (const auto &instruction : block.instructions) {
-            if (instruction.assigned_to.has_value())
-                lifetime_map[instruction.assigned_to->name] = &instruction;
+    void insert(uint64_t *set, ir::symbol_id id) {
+        set[id / 64] |= uint64_t { 1 } << (id % 64);
+    }
+
+    bool contains(const uint64_t *set, ir::symbol_id id) {
+        return set[id / 64] & (uint64_t { 1 } << (id % 64));
+    }
+
+    template <typename F>
+    void for_each_id(const uint64_t *set, size_t width, F fn) {
+        for (size_t i = 0; i < width; i++) {
+            for (auto word = set[i]; word; word &= word - 1)
+                fn(static_cast<ir::symbol_id>(i * 64 + __builtin_ctzll(word)));
+        }
+    }
+
+    /**
+     *  Indices of the blocks control may flow to after @block_index: the targets
+     *  of its branch or jmp, nothing after a ret, and otherwise the next block.
+     */
+    std::vector<size_t> successors(const ir::global::function &function,
+                                   const std::vector<size_t> &block_of,
+                                   size_t block_index) {
+        const auto &instructions = function.blocks[block_index].instructions;
+
+        if (!instructions.empty()) {
+            const auto &last = instructions.back();
+
+            switch (last.type()) {
+                case ir::block::node_type::branch:
+                case ir::block::node_type::jmp: {
+                    std::vector<size_t> targets;
+
+                    for (const auto &label : last.labels_referenced) {
+                        if (label.id < block_of.size() && block_of[label.id] != SIZE_MAX)
+                            targets.push_back(block_of[label.id]);
+                    }
+
+                    return targets;
+                }
+                case ir::block::node_type::ret:
+                    return {};
+                default:
+                    break;
+            }
+        }
+
+        if (block_index + 1 < function.blocks.size())
+            return { block_index + 1 };
+
+        return {};
+    }
+}
+
+void backend::md::analyze_variable_lifetimes(ir::global::function &function) {
+    const auto block_count = function.blocks.size();
+    const auto symbol_count = function.symbols.size();
+
+    std::vector<size_t> block_of(symbol_count, SIZE_MAX);
+
+    for (size_t i = 0; i < block_count; i++)
+        block_of[function.blocks[i].name.id] = i;
+
+    block_sets uses { block_count, symbol_count }, defs { block_count, symbol_count };
+    block_sets live_in { block_count, symbol_count }, live_out { block_count, symbol_count };
+
+    // A phi operand is not live into the phi's block, only out of the block it comes from
+    std::vector<std::vector<ir::symbol_id>> phi_uses(block_count);
+
+    std::vector<std::vector<size_t>> succs(block_count), preds(block_count);
+
+    for (size_t b = 0; b < block_count; b++) {
+        for (const auto &instruction : function.blocks[b].instructions) {
+            const auto *phi = std::get_if<ir::block::phi>(&instruction.inst);
+
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                const auto &operand = instruction.operands[i];
+
+                if (!operand.is_variable())
+                    continue;
+
+                if (phi) {
+                    if (i < phi->labels.size() && block_of[phi->labels[i].id] != SIZE_MAX)
+                        phi_uses[block_of[phi->labels[i].id]].push_back(operand.get_id());
+                } else if (!contains(defs[b], operand.get_id())) {
+                    insert(uses[b], operand.get_id());
+                }
+            }
+
+            if (instruction.assigned_to)
+                insert(defs[b], instruction.assigned_to->name.id);
+        }
+
+        succs[b] = successors(function, block_of, b);
+
+        for (auto succ : succs[b])
+            preds[succ].push_back(b);
+    }
+
+    // Backward dataflow to a fixed point, a block is revisited only when the live-in
+    // of one of its successors grew
+    std::vector<size_t> worklist;
+    std::vector<bool> queued(block_count, true);
+
+    for (size_t b = 0; b < block_count; b++)
+        worklist.push_back(b);
+
+    while (!worklist.empty()) {
+        const auto b = worklist.back();
+        worklist.pop_back();
+        queued[b] = false;
+
+        auto *out = live_out[b];
+
+        for (auto succ : succs[b]) {
+            const auto *succ_in = live_in[succ];
+
+            for (size_t w = 0; w < live_out.width; w++)
+                out[w] |= succ_in[w];
+        }
 
-            for (const auto &operand : instruction.operands)
-                document_lifetime(operand, instruction);
+        for (auto id : phi_uses[b])
+            insert(out, id);
+
+        bool changed = false;
+        auto *in = live_in[b];
+
+        for (size_t w = 0; w < live_in.width; w++) {
+            const auto word = uses[b][w] | (out[w] & ~defs[b][w]);
+
+            changed |= word != in[w];
+            in[w] = word;
+        }
+
+        if (!changed)
+            continue;
+
+        for (auto pred : preds[b]) {
+            if (queued[pred]) continue;
+
+            queued[pred] = true;
+            worklist.push_back(pred);
         }
     }
 
-    // Second Pass - Assign this information to the metadata
-    for (auto &block : function.blocks) {
-        for (auto &instruction : block.instructions) {
-            auto &metadata = instruction.metadata;
+    auto &block_live_in = function.metadata->live_in;
+    block_live_in.assign(block_count, {});
 
-            const auto detect_dropped = [&](const ir::value &val) {
-                if (!val.is_variable())
-                    return false;
+    for (size_t b = 0; b < block_count; b++) {
+        for_each_id(live_in[b], live_in.width, [&](ir::symbol_id id) {
+            block_live_in[b].push_back(id);
+        });
+    }
 
-                return lifetime_map[val.get_name().data()] == &instruction;
-            };
+    // Code is generated in block order with a single storage state, so a variable may only
+    // be released once it is live at no later point of that order.
+    auto &ranges = function.metadata->live_ranges;
+    ranges.assign(symbol_count, {});
 
-            for (const auto &operand : instruction.operands)
-                metadata->dropped_data.emplace_back(detect_dropped(operand));
+    std::vector<uint32_t> block_end(block_count, 0);
+    uint32_t position = 0;
+
+    for (size_t b = 0; b < block_count; b++) {
+        for (const auto &instruction : function.blocks[b].instructions) {
+            position++;
+
+            for (const auto &operand : instruction.operands) {
+                if (operand.is_variable())
+                    ranges[operand.get_id()].end = position;
+            }
+
+            if (instruction.assigned_to && !ranges[instruction.assigned_to->name.id].start)
+                ranges[instruction.assigned_to->name.id].start = position;
         }
+
+        if (function.blocks[b].instructions.empty())
+            continue;
+
+        block_end[b] = position;
+        for_each_id(live_out[b], live_out.width, [&](ir::symbol_id id) {
+            ranges[id].end = position;
+        });
+    }
+
+    position = 0;
+
+    for (size_t b = 0; b < block_count; b++) {
+        for (auto &instruction : function.blocks[b].instructions) {
+            position++;
+
+            for (const auto &operand : instruction.operands) {
+                instruction.metadata.dropped_data.emplace_back(
+                    operand.is_variable() && ranges[operand.get_id()].end == position
+                );
+            }
+        }
+
+        if (!block_end[b])
+            continue;
+
+        // Variables live out of the block whose range ends here without a use in the
+        // terminator, e.g. values carried around a loop
+        auto &terminator = function.blocks[b].instructions.back();
+
+        for_each_id(live_out[b], live_out.width, [&](ir::symbol_id id) {
+            if (ranges[id].end != block_end[b])
+                return;
+
+            for (const auto &operand : terminator.operands) {
+                if (operand.is_variable() && operand.get_id() == id)
+                    return;
+            }
+
+            terminator.metadata.dropped_after.push_back(id);
+        });
     }
-}
\ No newline at end of file
+}
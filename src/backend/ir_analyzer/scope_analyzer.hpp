@@ -5,5 +5,10 @@
 namespace backend::md {
     struct function_metadata;
 
+    /**
+     *  Marks where each variable dies, from a backward liveness analysis over the
+     *  function's control flow graph, so values live around a loop or into a later
+     *  branch are not released at their textually last use.
+     */
     void analyze_variable_lifetimes(ir::global::function &function);
 }
\ No newline at end of file
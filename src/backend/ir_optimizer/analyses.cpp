@@ -0,0 +1,166 @@
+#include "analyses.hpp"
+
+#include <algorithm>
+
+backend::opt::control_flow::control_flow(const ir::global::function &function)
+    :   block_of(function.symbols.size(), SIZE_MAX),
+        successors(function.blocks.size()),
+        predecessors(function.blocks.size()) {
+    for (size_t b = 0; b < function.blocks.size(); b++)
+        block_of[function.blocks[b].name.id] = b;
+
+    for (size_t b = 0; b < function.blocks.size(); b++) {
+        const auto &instructions = function.blocks[b].instructions;
+        const auto terminator = instructions.empty() ? std::nullopt : std::optional { instructions.back().type() };
+
+        if (terminator == ir::block::node_type::branch || terminator == ir::block::node_type::jmp) {
+            for (const auto &label : instructions.back().labels_referenced) {
+                const auto target = block_of[label.id];
+
+                // Both targets of a branch can be the same block, which is still one edge
+                if (target != SIZE_MAX && std::find(successors[b].begin(), successors[b].end(), target) == successors[b].end())
+                    successors[b].push_back(target);
+            }
+        } else if (terminator != ir::block::node_type::ret && b + 1 < function.blocks.size()) {
+            successors[b].push_back(b + 1);
+        }
+
+        for (const auto successor : successors[b])
+            predecessors[successor].push_back(b);
+    }
+}
+
+backend::opt::dominators::dominators(const control_flow &flow)
+    :   immediate(flow.successors.size(), SIZE_MAX),
+        children(flow.successors.size()),
+        frontier(flow.successors.size()) {
+    const auto block_count = flow.successors.size();
+
+    if (block_count == 0)
+        return;
+
+    // Postorder by an explicit depth first search, each block is finished once its last successor is
+    std::vector<size_t> postorder;
+    std::vector<bool> visited(block_count, false);
+    std::vector<std::pair<size_t, size_t>> stack { { 0, 0 } };
+
+    visited[0] = true;
+
+    while (!stack.empty()) {
+        auto &[block, next] = stack.back();
+
+        if (next < flow.successors[block].size()) {
+            const auto successor = flow.successors[block][next++];
+
+            if (!visited[successor]) {
+                visited[successor] = true;
+                stack.emplace_back(successor, 0);
+            }
+
+            continue;
+        }
+
+        postorder.push_back(block);
+        stack.pop_back();
+    }
+
+    reverse_postorder.assign(postorder.rbegin(), postorder.rend());
+
+    std::vector<size_t> order(block_count, SIZE_MAX);
+
+    for (size_t i = 0; i < postorder.size(); i++)
+        order[postorder[i]] = i;
+
+    const auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (order[a] < order[b]) a = immediate[a];
+            while (order[b] < order[a]) b = immediate[b];
+        }
+
+        return a;
+    };
+
+    // The entry block is its own immediate dominator while solving, so the walks in intersect stop there
+    immediate[0] = 0;
+
+    for (bool changed = true; changed;) {
+        changed = false;
+
+        for (const auto block : reverse_postorder) {
+            if (block == 0)
+                continue;
+
+            auto dominator = SIZE_MAX;
+
+            for (const auto predecessor : flow.predecessors[block]) {
+                if (immediate[predecessor] == SIZE_MAX)
+                    continue;
+
+                dominator = dominator == SIZE_MAX ? predecessor : intersect(predecessor, dominator);
+            }
+
+            if (immediate[block] != dominator) {
+                immediate[block] = dominator;
+                changed = true;
+            }
+        }
+    }
+
+    immediate[0] = SIZE_MAX;
+
+    for (const auto block : reverse_postorder) {
+        if (immediate[block] != SIZE_MAX)
+            children[immediate[block]].push_back(block);
+    }
+
+    // A join point is in the frontier of each block on the way up from its predecessors to its immediate dominator
+    for (const auto block : reverse_postorder) {
+        if (flow.predecessors[block].size() < 2)
+            continue;
+
+        for (const auto predecessor : flow.predecessors[block]) {
+            if (!reachable(predecessor))
+                continue;
+
+            for (auto runner = predecessor; runner != immediate[block] && runner != SIZE_MAX; runner = immediate[runner]) {
+                if (std::find(frontier[runner].begin(), frontier[runner].end(), block) == frontier[runner].end())
+                    frontier[runner].push_back(block);
+            }
+        }
+    }
+}
+
+bool backend::opt::dominators::reachable(size_t block) const {
+    return block == 0 || immediate[block] != SIZE_MAX;
+}
+
+const backend::opt::control_flow &backend::opt::function_analyses::cfg() {
+    if (!flow)
+        flow.emplace(function);
+
+    return *flow;
+}
+
+const backend::opt::dominators &backend::opt::function_analyses::dominator_tree() {
+    if (!tree)
+        tree.emplace(cfg());
+
+    return *tree;
+}
+
+bool backend::opt::function_analyses::is_valid(analysis which) const {
+    switch (which) {
+        case analysis::control_flow: return flow.has_value();
+        case analysis::dominators: return tree.has_value();
+    }
+
+    return false;
+}
+
+void backend::opt::function_analyses::invalidate(analysis_set preserved) {
+    if (!preserved[(size_t) analysis::control_flow])
+        flow.reset();
+
+    if (!preserved[(size_t) analysis::dominators] || !flow)
+        tree.reset();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "../../ir/nodes.hpp"
+
+namespace backend::opt {
+    enum class analysis : uint8_t {
+        control_flow,
+        dominators,
+    };
+
+    constexpr size_t analysis_count = (size_t) analysis::dominators + 1;
+
+    using analysis_set = std::bitset<analysis_count>;
+
+    /**
+     *  The edges between a function's blocks, as indices into its blocks. Control
+     *  leaves a block through the targets of its branch or jmp, nowhere after a ret,
+     *  and otherwise falls through to the next block.
+     */
+    struct control_flow {
+        // Indexed by symbol id, SIZE_MAX for symbols not naming a block
+        std::vector<size_t> block_of;
+
+        std::vector<std::vector<size_t>> successors;
+        std::vector<std::vector<size_t>> predecessors;
+
+        explicit control_flow(const ir::global::function &function);
+    };
+
+    /**
+     *  The dominator tree of the blocks reachable from the entry block, found with
+     *  Cooper, Harvey and Kennedy's iterative algorithm over reverse postorder, and the
+     *  dominance frontier of each block, the blocks where its dominance ends.
+     */
+    struct dominators {
+        // Indexed by block index, SIZE_MAX for the entry block and blocks that can't be reached
+        std::vector<size_t> immediate;
+
+        std::vector<std::vector<size_t>> children;
+        std::vector<std::vector<size_t>> frontier;
+
+        // The reachable blocks, each after every block dominating it
+        std::vector<size_t> reverse_postorder;
+
+        explicit dominators(const control_flow &flow);
+
+        [[nodiscard]] bool reachable(size_t block) const;
+    };
+
+    /**
+     *  The analyses of one function, each computed on first use and kept until a
+     *  transform changing the function invalidates it.
+     */
+    class function_analyses {
+        const ir::global::function &function;
+
+        std::optional<control_flow> flow;
+        std::optional<dominators> tree;
+
+    public:
+        explicit function_analyses(const ir::global::function &function) : function(function) {}
+
+        const control_flow &cfg();
+        const dominators &dominator_tree();
+
+        [[nodiscard]] bool is_valid(analysis which) const;
+
+        // Drops every analysis not in @preserved, and any computed from one dropped
+        void invalidate(analysis_set preserved);
+    };
+}
@@ -0,0 +1,519 @@
+#include "constant_propagation.hpp"
+#include "analyses.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+#include <vector>
+
+namespace {
+    bool is_integer(ir::value_size size) {
+        return size >= ir::value_size::i1 && size <= ir::value_size::i64;
+    }
+
+    int bit_width(ir::value_size size) {
+        return size == ir::value_size::i1 ? 1 : ir::size_in_bytes(size) * 8;
+    }
+
+    // The size of the value @instruction assigns, which the parser doesn't always record on the variable
+    ir::value_size result_size(const ir::block::block_instruction &instruction) {
+        const auto size = instruction.get_return_size();
+
+        if (size == ir::value_size::param_dependent)
+            return instruction.operands.empty() ? ir::value_size::none : instruction.operands.back().get_size();
+
+        return size;
+    }
+
+    /**
+     *  What is known of a value so far. Starts as unknown, and only ever moves
+     *  down, to a constant once one is seen and to overdefined once two different
+     *  ones are, so every value changes at most twice.
+     */
+    struct lattice_value {
+        enum class state : uint8_t {
+            unknown, constant, overdefined
+        };
+
+        state kind = state::unknown;
+        uint64_t value = 0;
+
+        static lattice_value constant(uint64_t value) { return { state::constant, value }; }
+        static lattice_value overdefined() { return { state::overdefined, 0 }; }
+
+        [[nodiscard]] bool is_constant() const { return kind == state::constant; }
+        [[nodiscard]] bool is_overdefined() const { return kind == state::overdefined; }
+
+        bool operator==(const lattice_value &) const = default;
+    };
+
+    lattice_value meet(lattice_value lhs, lattice_value rhs) {
+        if (lhs.kind == lattice_value::state::unknown) return rhs;
+        if (rhs.kind == lattice_value::state::unknown) return lhs;
+
+        if (lhs.is_constant() && rhs.is_constant() && lhs.value == rhs.value)
+            return lhs;
+
+        return lattice_value::overdefined();
+    }
+
+    // Whether @value can be written into the IR as a literal of @size, which codegen
+    // encodes as an immediate, at most 32 bits sign extended to 64
+    bool materializable(uint64_t value, ir::value_size size) {
+        return size != ir::value_size::i64 || ((int64_t) value >= INT32_MIN && (int64_t) value <= INT32_MAX);
+    }
+
+    ir::block::icmp_type mirror(ir::block::icmp_type type) {
+        using enum ir::block::icmp_type;
+
+        switch (type) {
+            case slt: return sgt;
+            case sgt: return slt;
+            case sle: return sge;
+            case sge: return sle;
+            case ult: return ugt;
+            case ugt: return ult;
+            case ule: return uge;
+            case uge: return ule;
+
+            default: return type;
+        }
+    }
+
+    void drop_incoming(ir::block::block_instruction &phi, ir::symbol_id from) {
+        auto &labels = std::get<ir::block::phi>(phi.inst).labels;
+
+        for (size_t i = labels.size(); i-- > 0;) {
+            if (labels[i].id != from) continue;
+
+            labels.erase(labels.begin() + (ptrdiff_t) i);
+            phi.labels_referenced.erase(phi.labels_referenced.begin() + (ptrdiff_t) i);
+            phi.operands.erase(phi.operands.begin() + (ptrdiff_t) i);
+        }
+    }
+
+    class propagator {
+        using location = std::pair<size_t, size_t>;
+
+        ir::global::function &fn;
+        const backend::opt::control_flow &flow;
+
+        // Indexed by symbol id
+        std::vector<lattice_value> values;
+        std::vector<std::vector<location>> users;
+
+        std::vector<bool> executable;
+        std::vector<std::vector<size_t>> executable_predecessors;
+
+        std::vector<size_t> block_worklist;
+        std::vector<ir::symbol_id> value_worklist;
+
+    public:
+        propagator(ir::global::function &fn, const backend::opt::control_flow &flow)
+            :   fn(fn), flow(flow),
+                values(fn.symbols.size(), lattice_value::overdefined()),
+                users(fn.symbols.size()),
+                executable(fn.blocks.size(), false),
+                executable_predecessors(fn.blocks.size()) {
+            // Anything not assigned by an instruction, parameters included, could be any value
+            for (size_t b = 0; b < fn.blocks.size(); b++) {
+                const auto &instructions = fn.blocks[b].instructions;
+
+                for (size_t i = 0; i < instructions.size(); i++) {
+                    if (instructions[i].assigned_to)
+                        values[instructions[i].assigned_to->name.id] = {};
+
+                    for (const auto &operand : instructions[i].operands) {
+                        if (operand.is_variable())
+                            users[operand.get_id()].emplace_back(b, i);
+                    }
+                }
+            }
+        }
+
+        void solve() {
+            if (fn.blocks.empty()) return;
+
+            executable[0] = true;
+            block_worklist.push_back(0);
+
+            while (!block_worklist.empty() || !value_worklist.empty()) {
+                while (!value_worklist.empty()) {
+                    const auto id = value_worklist.back();
+                    value_worklist.pop_back();
+
+                    for (const auto &[b, i] : users[id]) {
+                        if (executable[b])
+                            evaluate(b, i);
+                    }
+                }
+
+                if (block_worklist.empty()) continue;
+
+                const auto b = block_worklist.back();
+                block_worklist.pop_back();
+
+                const auto &instructions = fn.blocks[b].instructions;
+
+                for (size_t i = 0; i < instructions.size(); i++)
+                    evaluate(b, i);
+
+                if (instructions.empty() || !is_terminator(instructions.back()))
+                    mark_edge(b, b + 1);
+            }
+        }
+
+        bool rewrite();
+
+    private:
+        static bool is_terminator(const ir::block::block_instruction &instruction) {
+            const auto type = instruction.type();
+            return type == ir::block::node_type::branch || type == ir::block::node_type::jmp || type == ir::block::node_type::ret;
+        }
+
+        [[nodiscard]] lattice_value value_of(const ir::value &operand) const {
+            if (!is_integer(operand.get_size()))
+                return lattice_value::overdefined();
+
+            if (operand.is_literal())
+                return lattice_value::constant(backend::opt::truncate(operand.lit().value, operand.get_size()));
+
+            return values[operand.get_id()];
+        }
+
+        [[nodiscard]] bool edge_executable(size_t from, size_t to) const {
+            const auto &predecessors = executable_predecessors[to];
+            return std::find(predecessors.begin(), predecessors.end(), from) != predecessors.end();
+        }
+
+        void mark_edge(size_t from, size_t to) {
+            if (to >= fn.blocks.size() || edge_executable(from, to)) return;
+
+            executable_predecessors[to].push_back(from);
+
+            if (!executable[to]) {
+                executable[to] = true;
+                block_worklist.push_back(to);
+                return;
+            }
+
+            // Only the phis see which edge control came in along
+            const auto &instructions = fn.blocks[to].instructions;
+
+            for (size_t i = 0; i < instructions.size(); i++) {
+                if (instructions[i].type() == ir::block::node_type::phi)
+                    evaluate(to, i);
+            }
+        }
+
+        void mark_edge(size_t from, ir::symbol label) {
+            mark_edge(from, flow.block_of[label.id]);
+        }
+
+        void evaluate(size_t b, size_t i);
+        lattice_value compute(size_t b, const ir::block::block_instruction &instruction) const;
+    };
+
+    void propagator::evaluate(size_t b, size_t i) {
+        const auto &instruction = fn.blocks[b].instructions[i];
+
+        switch (instruction.type()) {
+            case ir::block::node_type::branch: {
+                const auto &branch = std::get<ir::block::branch>(instruction.inst);
+                const auto condition = value_of(instruction.operands[0]);
+
+                if (condition.is_constant()) {
+                    mark_edge(b, condition.value ? branch.true_branch : branch.false_branch);
+                } else if (condition.is_overdefined()) {
+                    mark_edge(b, branch.true_branch);
+                    mark_edge(b, branch.false_branch);
+                }
+
+                return;
+            }
+            case ir::block::node_type::jmp:
+                mark_edge(b, std::get<ir::block::jmp>(instruction.inst).label);
+                return;
+            default:
+                break;
+        }
+
+        if (!instruction.assigned_to) return;
+
+        const auto id = instruction.assigned_to->name.id;
+        const auto &old = values[id];
+
+        const auto lowered = is_integer(result_size(instruction))
+            ? meet(old, compute(b, instruction))
+            : lattice_value::overdefined();
+
+        if (lowered == old) return;
+
+        values[id] = lowered;
+        value_worklist.push_back(id);
+    }
+
+    lattice_value propagator::compute(size_t b, const ir::block::block_instruction &instruction) const {
+        const auto &operands = instruction.operands;
+
+        // The instructions reading their operands as numbers, constant only once all of them are
+        const auto all_constant = [&]() -> std::optional<lattice_value> {
+            lattice_value result = lattice_value::constant(0);
+
+            for (const auto &operand : operands) {
+                const auto value = value_of(operand);
+
+                if (value.is_overdefined()) return value;
+                if (!value.is_constant()) result = {};
+            }
+
+            return result.is_constant() ? std::nullopt : std::optional { result };
+        };
+
+        switch (instruction.type()) {
+            case ir::block::node_type::literal: {
+                const auto &literal = std::get<ir::block::literal>(instruction.inst).value;
+                return lattice_value::constant(backend::opt::truncate(literal.value, literal.size));
+            }
+            case ir::block::node_type::arithmetic: {
+                if (const auto unresolved = all_constant()) return *unresolved;
+
+                const auto folded = backend::opt::fold_arithmetic(
+                    std::get<ir::block::arithmetic>(instruction.inst).type, operands[0].get_size(),
+                    value_of(operands[0]).value, value_of(operands[1]).value
+                );
+
+                return folded ? lattice_value::constant(*folded) : lattice_value::overdefined();
+            }
+            case ir::block::node_type::icmp: {
+                if (const auto unresolved = all_constant()) return *unresolved;
+
+                return lattice_value::constant(backend::opt::fold_icmp(
+                    std::get<ir::block::icmp>(instruction.inst).type, operands[0].get_size(),
+                    value_of(operands[0]).value, value_of(operands[1]).value
+                ));
+            }
+            case ir::block::node_type::sext:
+            case ir::block::node_type::zext: {
+                if (const auto unresolved = all_constant()) return *unresolved;
+
+                const auto from = operands[0].get_size();
+                const auto to = instruction.get_return_size();
+                const auto value = value_of(operands[0]).value;
+
+                return lattice_value::constant(instruction.type() == ir::block::node_type::sext
+                    ? backend::opt::fold_sext(value, from, to)
+                    : backend::opt::fold_zext(value, from, to));
+            }
+            case ir::block::node_type::select: {
+                const auto condition = value_of(operands[0]);
+
+                if (condition.is_constant())
+                    return value_of(operands[condition.value ? 1 : 2]);
+
+                if (condition.is_overdefined())
+                    return meet(value_of(operands[1]), value_of(operands[2]));
+
+                return {};
+            }
+            case ir::block::node_type::phi: {
+                const auto &labels = std::get<ir::block::phi>(instruction.inst).labels;
+                lattice_value result {};
+
+                // Values coming in along edges never taken don't count
+                for (size_t i = 0; i < labels.size(); i++) {
+                    const auto from = flow.block_of[labels[i].id];
+
+                    if (from != SIZE_MAX && edge_executable(from, b))
+                        result = meet(result, value_of(operands[i]));
+                }
+
+                return result;
+            }
+            default:
+                return lattice_value::overdefined();
+        }
+    }
+
+    bool propagator::rewrite() {
+        bool changed = false;
+
+        // Selects on a constant condition are the operand they select, whether or not it is constant
+        std::vector<std::optional<ir::value>> forwarded(fn.symbols.size());
+
+        for (size_t b = 0; b < fn.blocks.size(); b++) {
+            if (!executable[b]) continue;
+
+            for (const auto &instruction : fn.blocks[b].instructions) {
+                if (instruction.type() != ir::block::node_type::select || !instruction.assigned_to)
+                    continue;
+
+                const auto condition = value_of(instruction.operands[0]);
+
+                if (condition.is_constant())
+                    forwarded[instruction.assigned_to->name.id] = instruction.operands[condition.value ? 1 : 2];
+            }
+        }
+
+        const auto resolve = [&](ir::value operand, bool fold) {
+            while (operand.is_variable()) {
+                const auto id = operand.get_id();
+
+                if (forwarded[id]) {
+                    operand = *forwarded[id];
+                    continue;
+                }
+
+                const auto value = values[id];
+                const auto size = operand.get_size();
+
+                if (fold && value.is_constant() && materializable(value.value, size))
+                    return ir::value { ir::int_literal { size, value.value } };
+
+                break;
+            }
+
+            return operand;
+        };
+
+        for (size_t b = 0; b < fn.blocks.size(); b++) {
+            auto &block = fn.blocks[b];
+
+            // Blocks never reached are left as they are for the unreachable pass, only
+            // kept from reading the selects removed below
+            const bool fold = executable[b];
+
+            for (auto &instruction : block.instructions) {
+                const auto type = instruction.type();
+
+                if (fold && instruction.assigned_to) {
+                    const auto size = result_size(instruction);
+                    const auto value = values[instruction.assigned_to->name.id];
+
+                    if (value.is_constant() && materializable(value.value, size)) {
+                        const auto *literal = std::get_if<ir::block::literal>(&instruction.inst);
+
+                        if (!literal || literal->value.value != value.value) {
+                            instruction.inst = ir::block::literal { ir::int_literal { size, value.value } };
+                            instruction.operands.clear();
+                            instruction.labels_referenced.clear();
+                            changed = true;
+                        }
+
+                        continue;
+                    }
+                }
+
+                // Extending a literal is only folded by the above, codegen doesn't extend literals itself
+                if (type == ir::block::node_type::sext || type == ir::block::node_type::zext)
+                    continue;
+
+                for (auto &operand : instruction.operands) {
+                    const auto resolved = resolve(operand, fold);
+
+                    if (resolved.is_literal() == operand.is_literal() && (resolved.is_literal() || resolved.get_id() == operand.get_id()))
+                        continue;
+
+                    operand = resolved;
+                    changed = true;
+                }
+
+                // cmp can't take an immediate on the left, so the comparison is turned around
+                if (type == ir::block::node_type::icmp && instruction.operands[0].is_literal() && instruction.operands[1].is_variable()) {
+                    auto &icmp = std::get<ir::block::icmp>(instruction.inst);
+
+                    std::swap(instruction.operands[0], instruction.operands[1]);
+                    icmp.type = mirror(icmp.type);
+                    changed = true;
+                }
+
+                if (fold && type == ir::block::node_type::branch && instruction.operands[0].is_literal()) {
+                    const auto branch = std::get<ir::block::branch>(instruction.inst);
+                    const bool taken = backend::opt::truncate(instruction.operands[0].lit().value, instruction.operands[0].get_size()) != 0;
+
+                    const auto target = taken ? branch.true_branch : branch.false_branch;
+                    const auto skipped = taken ? branch.false_branch : branch.true_branch;
+
+                    instruction.inst = ir::block::jmp { target };
+                    instruction.operands.clear();
+                    instruction.labels_referenced = { target };
+                    changed = true;
+
+                    if (const auto skipped_block = flow.block_of[skipped.id]; skipped.id != target.id && skipped_block != SIZE_MAX) {
+                        for (auto &phi : fn.blocks[skipped_block].instructions) {
+                            if (phi.type() == ir::block::node_type::phi)
+                                drop_incoming(phi, block.name.id);
+                        }
+                    }
+                }
+            }
+
+            const auto erased = std::erase_if(block.instructions, [&](const ir::block::block_instruction &instruction) {
+                return instruction.assigned_to && forwarded[instruction.assigned_to->name.id];
+            });
+
+            changed |= erased != 0;
+        }
+
+        return changed;
+    }
+}
+
+uint64_t backend::opt::truncate(uint64_t value, ir::value_size size) {
+    const auto width = bit_width(size);
+    return width == 64 ? value : value & (((uint64_t) 1 << width) - 1);
+}
+
+int64_t backend::opt::sign_extend(uint64_t value, ir::value_size size) {
+    const auto shift = 64 - bit_width(size);
+    return (int64_t) (value << shift) >> shift;
+}
+
+std::optional<uint64_t> backend::opt::fold_arithmetic(ir::block::arithmetic_type type, ir::value_size size,
+                                                      uint64_t lhs, uint64_t rhs) {
+    // Division is signed, as codegen emits idiv
+    const auto signed_lhs = sign_extend(lhs, size);
+    const auto signed_rhs = sign_extend(rhs, size);
+    const auto lowest = sign_extend((uint64_t) 1 << (bit_width(size) - 1), size);
+
+    switch (type) {
+        case ir::block::add: return truncate(lhs + rhs, size);
+        case ir::block::sub: return truncate(lhs - rhs, size);
+        case ir::block::mul: return truncate(lhs * rhs, size);
+
+        case ir::block::div:
+        case ir::block::mod:
+            if (signed_rhs == 0 || (signed_lhs == lowest && signed_rhs == -1))
+                return std::nullopt;
+
+            return truncate((uint64_t) (type == ir::block::div ? signed_lhs / signed_rhs : signed_lhs % signed_rhs), size);
+    }
+
+    return std::nullopt;
+}
+
+bool backend::opt::fold_icmp(ir::block::icmp_type type, ir::value_size size, uint64_t lhs, uint64_t rhs) {
+    // The bits of the type say which orderings it holds for, see ir::block::icmp_type
+    const bool is_signed = type & 0b1000;
+
+    const bool less = is_signed ? sign_extend(lhs, size) < sign_extend(rhs, size) : truncate(lhs, size) < truncate(rhs, size);
+    const bool equal = truncate(lhs, size) == truncate(rhs, size);
+    const bool greater = !less && !equal;
+
+    return (less && (type & 0b0001)) || (equal && (type & 0b0010)) || (greater && (type & 0b0100));
+}
+
+uint64_t backend::opt::fold_sext(uint64_t value, ir::value_size from, ir::value_size to) {
+    return truncate((uint64_t) sign_extend(value, from), to);
+}
+
+uint64_t backend::opt::fold_zext(uint64_t value, ir::value_size from, ir::value_size to) {
+    return truncate(truncate(value, from), to);
+}
+
+bool backend::opt::propagate_constants(ir::global::function &fn, const control_flow &flow) {
+    propagator solver { fn, flow };
+    solver.solve();
+
+    return solver.rewrite();
+}
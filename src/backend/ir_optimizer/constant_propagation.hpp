@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "../../ir/nodes.hpp"
+
+namespace backend::opt {
+    struct control_flow;
+
+    /**
+     *  Constants are held as the low bits of a uint64_t, the bits above the
+     *  width of their size always zero, and wrap around like the registers
+     *  they would otherwise be computed in.
+     */
+    uint64_t truncate(uint64_t value, ir::value_size size);
+    int64_t sign_extend(uint64_t value, ir::value_size size);
+
+    // std::nullopt where the instruction would trap instead, dividing by zero or overflowing a division
+    std::optional<uint64_t> fold_arithmetic(ir::block::arithmetic_type type, ir::value_size size, uint64_t lhs, uint64_t rhs);
+
+    bool fold_icmp(ir::block::icmp_type type, ir::value_size size, uint64_t lhs, uint64_t rhs);
+
+    uint64_t fold_sext(uint64_t value, ir::value_size from, ir::value_size to);
+    uint64_t fold_zext(uint64_t value, ir::value_size from, ir::value_size to);
+
+    /**
+     *  Sparse conditional constant propagation. Values are only assumed to be
+     *  constant, and blocks to be reachable, once something shows they are, so
+     *  constants flow through phis whose other incoming values come from blocks
+     *  that never run, and loops whose values never change are folded too.
+     *
+     *  Constant values are replaced by literals and branches on constant
+     *  conditions become jmps, leaving the blocks no longer branched to for
+     *  the unreachable pass and the instructions computing the constants for dce.
+     */
+    bool propagate_constants(ir::global::function &fn, const control_flow &flow);
+}
@@ -1,37 +1,197 @@
 #include "dead_code_elim.hpp"
+#include "analyses.hpp"
 #include "../../ir/nodes.hpp"
+#include "../instrumentation.hpp"
 
-#include <unordered_set>
+#include <vector>
+
+namespace {
+    // Whether removing the instruction can only change what its result would have been
+    bool has_effect(const ir::block::block_instruction &instruction) {
+        switch (instruction.type()) {
+            case ir::block::node_type::store:
+            case ir::block::node_type::call:
+            case ir::block::node_type::branch:
+            case ir::block::node_type::jmp:
+            case ir::block::node_type::ret:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Drops the incoming values of @phi from blocks that are no longer there
+    void drop_removed_incoming(ir::block::block_instruction &phi, const std::vector<bool> &removed) {
+        auto &labels = std::get<ir::block::phi>(phi.inst).labels;
+
+        ir::block::label_list kept_labels;
+        ir::operand_list kept_operands;
+
+        for (size_t i = 0; i < labels.size(); i++) {
+            if (removed[labels[i].id])
+                continue;
+
+            kept_labels.push_back(labels[i]);
+            kept_operands.push_back(phi.operands[i]);
+        }
+
+        labels = kept_labels;
+        phi.labels_referenced = kept_labels;
+        phi.operands = std::move(kept_operands);
+    }
+}
 
 void backend::opt::dead_code_elim(ir::root &root) {
+    backend::instrument::phase_timer timer { backend::instrument::phase::optimize };
+
     for (auto &fn : root.functions) {
         fn_dead_code_elim(fn);
     }
 }
 
-void backend::opt::fn_dead_code_elim(ir::global::function &fn) {
-    if (fn.blocks.empty()) return;
+bool backend::opt::fn_dead_code_elim(ir::global::function &fn) {
+    const bool removed_blocks = remove_unreachable_blocks(fn, control_flow { fn });
 
-    std::unordered_set<std::string> unreachable;
+    return remove_dead_instructions(fn) || removed_blocks;
+}
 
-    for (auto &block : fn.blocks) {
-        unreachable.insert(block.name);
-    }
+bool backend::opt::remove_unreachable_blocks(ir::global::function &fn, const control_flow &flow) {
+    if (fn.blocks.empty()) return false;
+
+    std::vector<bool> reached(fn.blocks.size(), false);
+    std::vector<size_t> pending { 0 };
 
     // The first block is reachable by virtue of being the entry block
-    unreachable.erase(fn.blocks.front().name);
+    reached[0] = true;
+
+    while (!pending.empty()) {
+        const auto block = pending.back();
+        pending.pop_back();
+
+        for (const auto successor : flow.successors[block]) {
+            if (reached[successor]) continue;
+
+            reached[successor] = true;
+            pending.push_back(successor);
+        }
+    }
+
+    // Indexed by symbol id
+    std::vector<bool> removed(fn.symbols.size(), false);
+    bool any_removed = false;
+
+    for (size_t b = 0; b < fn.blocks.size(); b++) {
+        if (reached[b]) continue;
+
+        removed[fn.blocks[b].name.id] = true;
+        any_removed = true;
+    }
+
+    if (!any_removed)
+        return false;
+
+    erase_if(fn.blocks, [&](const ir::block::block &block) {
+        return removed[block.name.id];
+    });
 
     for (auto &block : fn.blocks) {
-        for (auto &inst : block.instructions) {
-            for (auto &reachable : inst.labels_referenced) {
-                unreachable.erase(reachable);
+        for (auto &instruction : block.instructions) {
+            if (instruction.type() == ir::block::node_type::phi)
+                drop_removed_incoming(instruction, removed);
+        }
+    }
+
+    return true;
+}
+
+bool backend::opt::remove_dead_instructions(ir::global::function &fn) {
+    constexpr size_t no_definition = SIZE_MAX;
+
+    // Indexed by symbol id, the number of operands reading each variable and where it is defined
+    std::vector<uint32_t> uses(fn.symbols.size(), 0);
+    std::vector<std::pair<size_t, size_t>> definition(fn.symbols.size(), { no_definition, 0 });
+
+    for (size_t b = 0; b < fn.blocks.size(); b++) {
+        const auto &instructions = fn.blocks[b].instructions;
+
+        for (size_t i = 0; i < instructions.size(); i++) {
+            const auto &instruction = instructions[i];
+            const auto defined = instruction.assigned_to ? instruction.assigned_to->name.id : ir::no_symbol;
+
+            if (defined != ir::no_symbol)
+                definition[defined] = { b, i };
+
+            for (const auto &operand : instruction.operands) {
+                // A phi reading itself around a loop doesn't keep itself alive
+                if (operand.is_variable() && operand.get_id() != defined)
+                    uses[operand.get_id()]++;
             }
         }
     }
 
-    const auto is_unreachable = [&unreachable](const ir::block::block &block) {
-        return unreachable.contains(block.name);
-    };
+    std::vector<std::vector<bool>> dead(fn.blocks.size());
+    std::vector<std::pair<size_t, size_t>> pending;
+
+    for (size_t b = 0; b < fn.blocks.size(); b++) {
+        const auto &instructions = fn.blocks[b].instructions;
+        dead[b].assign(instructions.size(), false);
+
+        for (size_t i = 0; i < instructions.size(); i++) {
+            const auto &instruction = instructions[i];
+
+            if (!has_effect(instruction) && (!instruction.assigned_to || uses[instruction.assigned_to->name.id] == 0))
+                pending.emplace_back(b, i);
+        }
+    }
+
+    bool any_dead = false;
+
+    while (!pending.empty()) {
+        const auto [b, i] = pending.back();
+        pending.pop_back();
+
+        if (dead[b][i]) continue;
+
+        dead[b][i] = true;
+        any_dead = true;
+
+        const auto &instruction = fn.blocks[b].instructions[i];
+        const auto defined = instruction.assigned_to ? instruction.assigned_to->name.id : ir::no_symbol;
+
+        for (const auto &operand : instruction.operands) {
+            if (!operand.is_variable() || operand.get_id() == defined)
+                continue;
 
-    erase_if(fn.blocks, is_unreachable);
-}
\ No newline at end of file
+            const auto id = operand.get_id();
+
+            if (--uses[id] != 0 || definition[id].first == no_definition)
+                continue;
+
+            const auto [def_block, def_index] = definition[id];
+
+            if (!has_effect(fn.blocks[def_block].instructions[def_index]))
+                pending.emplace_back(def_block, def_index);
+        }
+    }
+
+    if (!any_dead)
+        return false;
+
+    for (size_t b = 0; b < fn.blocks.size(); b++) {
+        auto &instructions = fn.blocks[b].instructions;
+        size_t kept = 0;
+
+        for (size_t i = 0; i < instructions.size(); i++) {
+            if (dead[b][i]) continue;
+
+            if (kept != i)
+                instructions[kept] = std::move(instructions[i]);
+
+            kept++;
+        }
+
+        instructions.erase(instructions.begin() + (ptrdiff_t) kept, instructions.end());
+    }
+
+    return true;
+}
@@ -1,12 +1,26 @@
-#include "../../ir/node_prototypes.hpp"
+#pragma once
 
-#include <unordered_set>
-#include <functional>
+#include "../../ir/node_prototypes.hpp"
 
 namespace backend::opt {
-    using foreach_block = std::function<void(ir::block::block &)>;
+    struct control_flow;
 
     void dead_code_elim(ir::root &root);
 
-    static void fn_dead_code_elim(ir::global::function &fn);
-}
\ No newline at end of file
+    // Removes both the unreachable blocks and the dead instructions of @fn, returning whether there were any
+    bool fn_dead_code_elim(ir::global::function &fn);
+
+    /**
+     *  Removes the blocks control can't reach from the entry block, found by marking
+     *  from it along @flow, so dead blocks referring to each other are removed too.
+     *  Phis lose their incoming values from the blocks removed.
+     */
+    bool remove_unreachable_blocks(ir::global::function &fn, const control_flow &flow);
+
+    /**
+     *  Removes the instructions whose result is never used and which have no other
+     *  effect, until none are left, so a value only used by dead instructions goes
+     *  with them. Stores, calls and terminators always stay.
+     */
+    bool remove_dead_instructions(ir::global::function &fn);
+}
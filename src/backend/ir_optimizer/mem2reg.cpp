@@ -0,0 +1,307 @@
+#include "mem2reg.hpp"
+#include "analyses.hpp"
+#include "../../ir/nodes.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr size_t no_slot = SIZE_MAX;
+
+    // An allocation, promoted if its address never escapes
+    struct slot {
+        ir::symbol name;
+        size_t bytes;
+
+        // The size it is loaded and stored at, none until the first access
+        ir::value_size size = ir::value_size::none;
+        bool promotable = true;
+    };
+
+    // A phi placed for @slot, the instruction built up as its incoming values are found
+    struct placed_phi {
+        size_t slot;
+        ir::block::block_instruction instruction;
+    };
+
+    // The allocation @instruction loads from or stores to, if it is one being promoted
+    size_t accessed_slot(const ir::block::block_instruction &instruction, const std::vector<size_t> &slot_of,
+                         const std::vector<slot> &slots) {
+        const auto type = instruction.type();
+
+        if (type != ir::block::node_type::load && type != ir::block::node_type::store)
+            return no_slot;
+
+        const auto &pointer = instruction.operands[0];
+
+        if (!pointer.is_variable() || pointer.get_id() >= slot_of.size())
+            return no_slot;
+
+        const auto found = slot_of[pointer.get_id()];
+        return found != no_slot && slots[found].promotable ? found : no_slot;
+    }
+
+    // A name for the phi of the allocation @slot in the block @block not yet used in @symbols
+    ir::symbol fresh_name(ir::symbol_table &symbols, std::string_view slot, std::string_view block) {
+        const auto base = std::string { slot }.append("_").append(block);
+        auto name = base;
+
+        for (size_t suffix = 1; symbols.find(name); suffix++)
+            name = std::string { base }.append("_").append(std::to_string(suffix));
+
+        return symbols.intern(name);
+    }
+}
+
+bool backend::opt::promote_allocations(ir::global::function &fn, const control_flow &flow, const dominators &tree) {
+    const auto block_count = fn.blocks.size();
+    const auto symbol_count = fn.symbols.size();
+
+    // Indexed by symbol id, the slot of each allocation's result
+    std::vector<size_t> slot_of(symbol_count, no_slot);
+    std::vector<slot> slots;
+
+    for (const auto &block : fn.blocks) {
+        for (const auto &instruction : block.instructions) {
+            if (instruction.type() != ir::block::node_type::allocate || !instruction.assigned_to)
+                continue;
+
+            slot_of[instruction.assigned_to->name.id] = slots.size();
+            slots.push_back({ instruction.assigned_to->name, std::get<ir::block::allocate>(instruction.inst).size });
+        }
+    }
+
+    if (slots.empty())
+        return false;
+
+    // Any use but as the address of a load or store lets the address escape, as does any access the dominator tree can't see
+    for (size_t b = 0; b < block_count; b++) {
+        for (const auto &instruction : fn.blocks[b].instructions) {
+            const auto type = instruction.type();
+
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                const auto &operand = instruction.operands[i];
+
+                if (!operand.is_variable() || slot_of[operand.get_id()] == no_slot)
+                    continue;
+
+                auto &accessed = slots[slot_of[operand.get_id()]];
+
+                if (i != 0 || (type != ir::block::node_type::load && type != ir::block::node_type::store) || !tree.reachable(b)) {
+                    accessed.promotable = false;
+                    continue;
+                }
+
+                const auto size = type == ir::block::node_type::load
+                    ? std::get<ir::block::load>(instruction.inst).size
+                    : std::get<ir::block::store>(instruction.inst).size;
+
+                if ((accessed.size != ir::value_size::none && accessed.size != size) || (size_t) ir::size_in_bytes(size) > accessed.bytes)
+                    accessed.promotable = false;
+
+                accessed.size = size;
+            }
+        }
+    }
+
+    // Allocations never accessed are left for dce
+    for (auto &candidate : slots)
+        candidate.promotable &= candidate.size != ir::value_size::none;
+
+    std::vector<std::vector<placed_phi>> phis(block_count);
+    bool any_promoted = false;
+
+    for (size_t s = 0; s < slots.size(); s++) {
+        if (!slots[s].promotable)
+            continue;
+
+        any_promoted = true;
+
+        // Which blocks store to the slot, and which read it before storing to it
+        std::vector<bool> stores(block_count, false), live_in(block_count, false);
+        std::vector<size_t> pending;
+
+        for (size_t b = 0; b < block_count; b++) {
+            bool stored = false;
+
+            for (const auto &instruction : fn.blocks[b].instructions) {
+                if (accessed_slot(instruction, slot_of, slots) != s)
+                    continue;
+
+                if (instruction.type() == ir::block::node_type::store) {
+                    stored = true;
+                } else if (!stored && !live_in[b]) {
+                    live_in[b] = true;
+                    pending.push_back(b);
+                }
+            }
+
+            stores[b] = stored;
+        }
+
+        // Live back from the reads until a store, a phi is only placed where its value can still be read
+        while (!pending.empty()) {
+            const auto b = pending.back();
+            pending.pop_back();
+
+            for (const auto predecessor : flow.predecessors[b]) {
+                if (live_in[predecessor] || stores[predecessor])
+                    continue;
+
+                live_in[predecessor] = true;
+                pending.push_back(predecessor);
+            }
+        }
+
+        // The iterated dominance frontier of the stores, a phi being another store to the slot
+        std::vector<bool> in_frontier(block_count, false);
+
+        for (size_t b = 0; b < block_count; b++) {
+            if (stores[b])
+                pending.push_back(b);
+        }
+
+        while (!pending.empty()) {
+            const auto b = pending.back();
+            pending.pop_back();
+
+            for (const auto join : tree.frontier[b]) {
+                if (in_frontier[join])
+                    continue;
+
+                in_frontier[join] = true;
+
+                if (!stores[join])
+                    pending.push_back(join);
+
+                if (!live_in[join])
+                    continue;
+
+                ir::block::block_instruction phi { ir::block::phi { ir::block::label_list {} } };
+                phi.assigned_to = ir::variable {
+                    slots[s].size,
+                    fresh_name(fn.symbols, fn.symbols.name(slots[s].name), fn.symbols.name(fn.blocks[join].name))
+                };
+
+                phis[join].push_back({ s, std::move(phi) });
+            }
+        }
+    }
+
+    if (!any_promoted)
+        return false;
+
+    // Indexed by symbol id, the value each promoted load is replaced by
+    std::vector<std::optional<ir::value>> replacement(symbol_count);
+
+    const auto resolve = [&](const ir::value &value) {
+        if (value.is_variable() && value.get_id() < symbol_count && replacement[value.get_id()])
+            return *replacement[value.get_id()];
+
+        return value;
+    };
+
+    std::vector<std::vector<bool>> removed(block_count);
+
+    // The value each slot holds, walking down the dominator tree from the entry block
+    std::vector<ir::value> current;
+
+    for (const auto &candidate : slots) {
+        const auto size = candidate.size == ir::value_size::none ? ir::value_size::i32 : candidate.size;
+        current.emplace_back(ir::int_literal { size, 0 });
+    }
+
+    struct frame {
+        size_t block;
+        size_t next_child = 0;
+        std::vector<ir::value> saved;
+    };
+
+    std::vector<frame> walk;
+
+    const auto visit = [&](size_t b) {
+        walk.push_back({ b, 0, current });
+
+        for (const auto &placed : phis[b])
+            current[placed.slot] = ir::value { *placed.instruction.assigned_to };
+
+        auto &instructions = fn.blocks[b].instructions;
+        removed[b].assign(instructions.size(), false);
+
+        for (size_t i = 0; i < instructions.size(); i++) {
+            const auto &instruction = instructions[i];
+            const auto type = instruction.type();
+
+            if (type == ir::block::node_type::allocate && instruction.assigned_to) {
+                const auto s = slot_of[instruction.assigned_to->name.id];
+                removed[b][i] = s != no_slot && slots[s].promotable;
+                continue;
+            }
+
+            const auto s = accessed_slot(instruction, slot_of, slots);
+
+            if (s == no_slot)
+                continue;
+
+            removed[b][i] = true;
+
+            if (type == ir::block::node_type::store)
+                current[s] = resolve(instruction.operands[1]);
+            else if (instruction.assigned_to)
+                replacement[instruction.assigned_to->name.id] = current[s];
+        }
+
+        for (const auto successor : flow.successors[b]) {
+            for (auto &placed : phis[successor]) {
+                auto &labels = std::get<ir::block::phi>(placed.instruction.inst).labels;
+
+                labels.push_back(fn.blocks[b].name);
+                placed.instruction.labels_referenced.push_back(fn.blocks[b].name);
+                placed.instruction.operands.push_back(current[placed.slot]);
+            }
+        }
+    };
+
+    visit(0);
+
+    while (!walk.empty()) {
+        auto &top = walk.back();
+        const auto &children = tree.children[top.block];
+
+        if (top.next_child < children.size()) {
+            visit(children[top.next_child++]);
+            continue;
+        }
+
+        current = std::move(top.saved);
+        walk.pop_back();
+    }
+
+    for (size_t b = 0; b < block_count; b++) {
+        auto &instructions = fn.blocks[b].instructions;
+
+        // Blocks the walk never reached have no accesses to remove
+        if (removed[b].empty())
+            removed[b].assign(instructions.size(), false);
+
+        std::vector<ir::block::block_instruction> kept;
+        kept.reserve(phis[b].size() + instructions.size());
+
+        for (auto &placed : phis[b])
+            kept.push_back(std::move(placed.instruction));
+
+        for (size_t i = 0; i < instructions.size(); i++) {
+            if (!removed[b][i])
+                kept.push_back(std::move(instructions[i]));
+        }
+
+        for (auto &instruction : kept) {
+            for (auto &operand : instruction.operands)
+                operand = resolve(operand);
+        }
+
+        instructions = std::move(kept);
+    }
+
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../../ir/node_prototypes.hpp"
+
+namespace backend::opt {
+    struct control_flow;
+    struct dominators;
+
+    /**
+     *  Promotes the allocations whose address never escapes, those only ever loaded from
+     *  and stored to directly and at one size, to variables. Phis are placed at the iterated
+     *  dominance frontier of the blocks storing to an allocation, wherever it is still read,
+     *  and each load is replaced by the value last stored on the way down the dominator
+     *  tree, or 0 where nothing was stored yet. The allocation, its loads and its stores
+     *  are then removed.
+     */
+    bool promote_allocations(ir::global::function &fn, const control_flow &flow, const dominators &tree);
+}
@@ -0,0 +1,221 @@
+#include "pass_manager.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+#include "constant_propagation.hpp"
+#include "dead_code_elim.hpp"
+#include "mem2reg.hpp"
+#include "../instrumentation.hpp"
+#include "../parallel.hpp"
+
+namespace {
+    using namespace backend::opt;
+
+    bool compute_control_flow(ir::global::function &, function_analyses &analyses) {
+        analyses.cfg();
+        return false;
+    }
+
+    bool promote_function_allocations(ir::global::function &function, function_analyses &analyses) {
+        const auto &flow = analyses.cfg();
+        return promote_allocations(function, flow, analyses.dominator_tree());
+    }
+
+    bool propagate_function_constants(ir::global::function &function, function_analyses &analyses) {
+        return propagate_constants(function, analyses.cfg());
+    }
+
+    bool eliminate_unreachable_blocks(ir::global::function &function, function_analyses &analyses) {
+        return remove_unreachable_blocks(function, analyses.cfg());
+    }
+
+    bool eliminate_dead_instructions(ir::global::function &function, function_analyses &) {
+        return remove_dead_instructions(function);
+    }
+
+    // Terminators are never removed as dead, so neither are edges, nor the dominance they imply
+    constexpr analysis_set keeps_control_flow { (1 << (size_t) analysis::control_flow) | (1 << (size_t) analysis::dominators) };
+
+    constexpr pass registry[] = {
+        { "cfg", pass_kind::analysis, {}, compute_control_flow },
+        { "mem2reg", pass_kind::transform, keeps_control_flow, promote_function_allocations },
+        { "sccp", pass_kind::transform, {}, propagate_function_constants },
+        { "unreachable", pass_kind::transform, {}, eliminate_unreachable_blocks },
+        { "dce", pass_kind::transform, keeps_control_flow, eliminate_dead_instructions },
+    };
+
+    // Constant branches folded by sccp leave unreachable blocks and unused conditions behind, and
+    // values promoted out of memory by mem2reg are only then seen to be constant
+    constexpr std::string_view o1_pipeline[] = { "sccp", "unreachable", "dce" };
+    constexpr std::string_view o2_pipeline[] = { "mem2reg", "sccp", "unreachable", "dce" };
+
+    size_t instruction_count(const ir::global::function &function) {
+        size_t count = 0;
+
+        for (const auto &block : function.blocks)
+            count += block.instructions.size();
+
+        return count;
+    }
+}
+
+std::span<const pass> backend::opt::registered_passes() {
+    return registry;
+}
+
+const pass *backend::opt::find_pass(std::string_view name) {
+    const auto found = std::find_if(std::begin(registry), std::end(registry), [&](const pass &candidate) {
+        return candidate.name == name;
+    });
+
+    return found == std::end(registry) ? nullptr : found;
+}
+
+std::vector<const pass*> backend::opt::pipeline(const compile_options &options) {
+    std::vector<const pass*> resolved;
+
+    const auto add = [&](std::string_view name) {
+        const auto *found = find_pass(name);
+
+        if (!found)
+            throw std::runtime_error(std::string("no pass named ").append(name));
+
+        resolved.push_back(found);
+    };
+
+    if (!options.passes.empty()) {
+        for (const auto &name : options.passes)
+            add(name);
+
+        return resolved;
+    }
+
+    switch (options.optimization) {
+        case opt_level::O0:
+            break;
+        case opt_level::O1:
+            for (const auto name : o1_pipeline) add(name);
+            break;
+        case opt_level::O2:
+            for (const auto name : o2_pipeline) add(name);
+            break;
+    }
+
+    return resolved;
+}
+
+void backend::opt::pass_statistics::add(std::string_view pass, const pass_totals &run) {
+    std::lock_guard lock { mutex };
+
+    auto found = std::find_if(recorded.begin(), recorded.end(), [&](const auto &entry) {
+        return entry.first == pass;
+    });
+
+    if (found == recorded.end())
+        found = recorded.insert(recorded.end(), { pass, {} });
+
+    auto &totals = found->second;
+    totals.runs += run.runs;
+    totals.changes += run.changes;
+    totals.nanoseconds += run.nanoseconds;
+    totals.instructions += run.instructions;
+    totals.blocks += run.blocks;
+}
+
+backend::opt::pass_totals backend::opt::pass_statistics::totals(std::string_view pass) const {
+    std::lock_guard lock { mutex };
+
+    for (const auto &[name, totals] : recorded) {
+        if (name == pass)
+            return totals;
+    }
+
+    return {};
+}
+
+void backend::opt::pass_statistics::write_table(std::ostream &ostream) const {
+    std::lock_guard lock { mutex };
+
+    const auto flags = ostream.flags();
+    const auto precision = ostream.precision();
+
+    ostream << std::left << std::setw(20) << "pass"
+            << std::right << std::setw(10) << "runs"
+            << std::setw(10) << "changed"
+            << std::setw(14) << "time (ms)"
+            << std::setw(14) << "instructions"
+            << std::setw(10) << "blocks" << '\n';
+
+    for (const auto &[name, totals] : recorded) {
+        ostream << std::left << std::setw(20) << name
+                << std::right << std::setw(10) << totals.runs
+                << std::setw(10) << totals.changes
+                << std::setw(14) << std::fixed << std::setprecision(3) << (double) totals.nanoseconds / 1e6
+                << std::setw(14) << std::showpos << totals.instructions
+                << std::setw(10) << totals.blocks << std::noshowpos << '\n';
+    }
+
+    ostream.flags(flags);
+    ostream.precision(precision);
+}
+
+void backend::opt::run_passes(ir::global::function &function, function_analyses &analyses,
+                              std::span<const pass* const> passes, pass_statistics *statistics) {
+    using clock = std::chrono::steady_clock;
+
+    auto *tracing = backend::instrument::active_trace.load(std::memory_order_relaxed);
+
+    // The function is only measured when someone is looking
+    const bool measured = statistics || tracing;
+
+    for (const auto *current : passes) {
+        const auto instructions = measured ? instruction_count(function) : 0;
+        const auto blocks = function.blocks.size();
+        const auto start = measured ? clock::now() : clock::time_point {};
+
+        const bool changed = current->run(function, analyses);
+
+        if (changed && current->kind == pass_kind::transform)
+            analyses.invalidate(current->preserves);
+
+        if (!measured)
+            continue;
+
+        const auto end = clock::now();
+
+        if (tracing)
+            tracing->add({ std::string { current->name }, "pass", start, end, backend::instrument::trace_thread(), std::nullopt });
+
+        if (statistics) {
+            statistics->add(current->name, pass_totals {
+                .runs = 1,
+                .changes = changed,
+                .nanoseconds = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+                .instructions = (int64_t) instruction_count(function) - (int64_t) instructions,
+                .blocks = (int64_t) function.blocks.size() - (int64_t) blocks,
+            });
+        }
+    }
+}
+
+void backend::opt::optimize_function(ir::global::function &function, std::span<const pass* const> passes,
+                                     pass_statistics *statistics) {
+    function_analyses analyses { function };
+    run_passes(function, analyses, passes, statistics);
+}
+
+void backend::opt::optimize(ir::root &root, const compile_options &options) {
+    const auto passes = pipeline(options);
+
+    if (passes.empty())
+        return;
+
+    backend::parallel_for(root.functions.size(), options.threads, [&](size_t i) {
+        backend::instrument::phase_timer timer { backend::instrument::phase::optimize };
+        optimize_function(root.functions[i], passes, options.pass_statistics);
+    });
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "analyses.hpp"
+#include "../compile_options.hpp"
+
+namespace backend::opt {
+    enum class pass_kind : uint8_t {
+        analysis, transform
+    };
+
+    /**
+     *  A pass over one function. An analysis only computes into the function's
+     *  analyses, ahead of the transforms using it. A transform returns whether it
+     *  changed the function, in which case every analysis outside @preserves is
+     *  invalidated.
+     */
+    struct pass {
+        std::string_view name;
+        pass_kind kind;
+        analysis_set preserves;
+
+        bool (*run)(ir::global::function &function, function_analyses &analyses);
+    };
+
+    std::span<const pass> registered_passes();
+
+    // nullptr if no pass is registered under @name
+    const pass *find_pass(std::string_view name);
+
+    /**
+     *  The passes to run for @options: its list of passes if it has one, and its
+     *  optimization level's pipeline otherwise. Throws if a listed pass does not exist.
+     */
+    std::vector<const pass*> pipeline(const compile_options &options);
+
+    struct pass_totals {
+        uint64_t runs = 0;
+
+        // Runs which changed the function
+        uint64_t changes = 0;
+
+        uint64_t nanoseconds = 0;
+
+        // Change in the number of instructions and blocks over all runs
+        int64_t instructions = 0;
+        int64_t blocks = 0;
+    };
+
+    /**
+     *  Where optimization time goes and what it achieves, per pass, summed over every
+     *  function it ran on. Safe to add to from several threads at once.
+     */
+    class pass_statistics {
+        mutable std::mutex mutex;
+
+        // In the order the passes first ran
+        std::vector<std::pair<std::string_view, pass_totals>> recorded;
+
+    public:
+        void add(std::string_view pass, const pass_totals &run);
+
+        [[nodiscard]] pass_totals totals(std::string_view pass) const;
+
+        void write_table(std::ostream &ostream) const;
+    };
+
+    /**
+     *  Runs @passes over @function in order, recording each run into @statistics if set.
+     *  @analyses are those of @function, kept valid from one pass to the next.
+     */
+    void run_passes(ir::global::function &function, function_analyses &analyses,
+                    std::span<const pass* const> passes, pass_statistics *statistics = nullptr);
+
+    void optimize_function(ir::global::function &function, std::span<const pass* const> passes,
+                           pass_statistics *statistics = nullptr);
+
+    void optimize(ir::root &root, const compile_options &options);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace backend {
+    /**
+     *  Calls @fn for every index in [0, @count) on up to @threads threads, including the
+     *  calling one, which pull indices from a shared counter. Returns once every call has
+     *  finished. If any call throws, remaining indices are skipped and the first exception
+     *  is rethrown on the calling thread.
+     */
+    template <typename Fn>
+    void parallel_for(size_t count, size_t threads, Fn fn) {
+        threads = std::min(threads, count);
+
+        if (threads <= 1) {
+            for (size_t i = 0; i < count; i++)
+                fn(i);
+
+            return;
+        }
+
+        std::atomic<size_t> next { 0 };
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        const auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard lock { error_mutex };
+
+                    if (!error)
+                        error = std::current_exception();
+
+                    next = count;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+
+        for (size_t i = 1; i < threads; i++)
+            workers.emplace_back(worker);
+
+        worker();
+
+        for (auto &thread : workers)
+            thread.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
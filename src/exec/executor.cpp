@@ -3,11 +3,6 @@
 #include "executor.hpp"
 #include "../debug/assert.hpp"
 
-std::string get_nasm_command(std::string_view file) {
-    return std::string("nasm -g -f elf64 -o ")
-        .append(file).append(".o ").append(file).append(".asm");
-}
-
 std::string get_gcc_command(std::string_view file) {
     return std::string("gcc -no-pie -z noexecstack -o ")
         .append(file).append(".out ").append(file).append(".o");
@@ -20,7 +15,7 @@ std::string get_run_command(std::string_view file) {
 
 std::string get_clean_command(std::string_view file) {
     return std::string("rm ")
-        .append(file).append(".o ").append(file).append(".asm");
+        .append(file).append(".o");
 }
 
 std::string get_clean_exec_command(std::string_view file) {
@@ -37,9 +32,8 @@ std::string_view get_extensionless_filename(std::string_view file) {
 }
 
 int run_routine(std::string_view extensionless_path) {
-    if (WEXITSTATUS(sys(get_nasm_command(extensionless_path))))
+    if (WEXITSTATUS(sys(get_gcc_command(extensionless_path))))
         return -1;
-    sys(get_gcc_command(extensionless_path));
     sys(get_clean_command(extensionless_path));
 
     return WEXITSTATUS(sys(get_run_command(extensionless_path)));
@@ -1,6 +1,7 @@
 #pragma once
 
 namespace exec {
+    // @file is an object file as written by backend::compile_object, linked with gcc
     int execute(std::string_view file);
     int run_once(std::string_view file);
 }
@@ -0,0 +1,136 @@
+#include "jit.hpp"
+
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "../backend/interface.hpp"
+
+namespace {
+    constexpr size_t function_alignment = 16;
+
+    // jmp [rip + 0] followed by the absolute address it jumps to
+    constexpr uint8_t stub_jump[] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };
+    constexpr size_t stub_size = 16;
+
+    size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+exec::jit_module::jit_module(const backend::as::encoded_module &module) {
+    const auto page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    std::vector<size_t> function_offsets;
+    size_t code_size = 0;
+
+    for (const auto &function : module.functions) {
+        code_size = align_up(code_size, function_alignment);
+        function_offsets.push_back(code_size);
+        code_size += function.code.size();
+    }
+
+    const auto stubs_offset = align_up(code_size, stub_size);
+    const auto text_size = align_up(std::max<size_t>(stubs_offset + module.external_functions.size() * stub_size, 1), page_size);
+
+    size_t data_size = 0;
+    for (const auto &data : module.data)
+        data_size += data.bytes.size();
+
+    size = text_size + align_up(data_size, page_size);
+
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("failed to map memory for jit module");
+
+    memory = static_cast<std::byte*>(mapping);
+
+    // The destructor does not run if the constructor throws
+    try {
+        // Filled with int3 so that running off the end of a function traps
+        std::memset(memory, 0xCC, text_size);
+
+        for (size_t i = 0; i < module.functions.size(); i++) {
+            std::memcpy(memory + function_offsets[i], module.functions[i].code.data(), module.functions[i].code.size());
+            symbols.emplace(module.functions[i].name, memory + function_offsets[i]);
+        }
+
+        for (size_t i = 0; i < module.external_functions.size(); i++) {
+            const auto &name = module.external_functions[i];
+            void *address = dlsym(RTLD_DEFAULT, name.c_str());
+
+            if (!address)
+                throw std::runtime_error("unresolved extern function " + name);
+
+            auto *stub = memory + stubs_offset + i * stub_size;
+
+            std::memcpy(stub, stub_jump, sizeof(stub_jump));
+            std::memcpy(stub + sizeof(stub_jump), &address, sizeof(address));
+            symbols.emplace(name, stub);
+        }
+
+        auto *data_start = memory + text_size;
+
+        for (const auto &data : module.data) {
+            std::memcpy(data_start, data.bytes.data(), data.bytes.size());
+            symbols.emplace(data.name, data_start);
+            data_start += data.bytes.size();
+        }
+
+        for (size_t i = 0; i < module.functions.size(); i++) {
+            for (const auto &relocation : module.functions[i].relocations) {
+                const auto symbol = symbols.find(relocation.symbol);
+
+                if (symbol == symbols.end())
+                    throw std::runtime_error("reference to undefined symbol " + relocation.symbol);
+
+                auto *field = memory + function_offsets[i] + relocation.offset;
+                const auto value = (int64_t) (symbol->second - field) + relocation.addend;
+
+                // Both ends lie within the mapping, so this only fails for modules larger than 2GB
+                if (value < INT32_MIN || value > INT32_MAX)
+                    throw std::runtime_error("relocation to " + relocation.symbol + " out of range");
+
+                const auto displacement = (int32_t) value;
+                std::memcpy(field, &displacement, sizeof(displacement));
+            }
+        }
+    } catch (...) {
+        munmap(memory, size);
+        throw;
+    }
+
+    if (mprotect(memory, text_size, PROT_READ | PROT_EXEC) != 0
+        || (size > text_size && mprotect(memory + text_size, size - text_size, PROT_READ) != 0)) {
+        munmap(memory, size);
+        throw std::runtime_error("failed to make jit module executable");
+    }
+}
+
+exec::jit_module::~jit_module() {
+    munmap(memory, size);
+}
+
+void *exec::jit_module::find(std::string_view name) const {
+    const auto symbol = symbols.find(std::string { name });
+    return symbol == symbols.end() ? nullptr : symbol->second;
+}
+
+int exec::run_jit(std::string_view file, std::string_view entry) {
+    auto root = backend::gen_ast(file);
+    const exec::jit_module module { backend::assemble(root) };
+
+    auto *function = module.function<int()>(entry);
+
+    if (!function)
+        throw std::runtime_error(std::string("entry function ").append(entry).append(" not found"));
+
+    return function();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../backend/codegen/asmgen/encoder.hpp"
+
+namespace exec {
+    /**
+     *  An encoded module loaded into executable memory. Relocations are resolved on
+     *  load: calls between the module's functions directly, extern functions through
+     *  a stub jumping to the address dlsym finds for them, since a shared library can
+     *  be further away than a rel32 call reaches.
+     *
+     *  The code is only made executable once written, and the memory is unmapped
+     *  with the module.
+     */
+    class jit_module {
+        std::byte *memory = nullptr;
+        size_t size = 0;
+
+        std::unordered_map<std::string, std::byte*> symbols;
+
+    public:
+        explicit jit_module(const backend::as::encoded_module &module);
+        ~jit_module();
+
+        jit_module(const jit_module&) = delete;
+        jit_module &operator=(const jit_module&) = delete;
+
+        [[nodiscard]] void *find(std::string_view name) const;
+
+        template <typename T>
+        [[nodiscard]] T *function(std::string_view name) const {
+            return reinterpret_cast<T*>(find(name));
+        }
+    };
+
+    /**
+     *  Compiles @file and calls its @entry function in process, returning its result
+     *  like execute returns the exit code of the linked program.
+     */
+    int run_jit(std::string_view file, std::string_view entry = "main");
+}
@@ -3,33 +3,35 @@
 
 namespace ir::parser {
     template <typename Arg>
-    inline auto parse_argument(block::block_instruction &, parser::lex_iter_t &start, parser::lex_iter_t end) {
+    inline auto parse_argument(block::label_list &, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &) {
         throw std::runtime_error("Unknown argument type");
     }
 
     template <>
-    inline auto parse_argument<uint8_t>(block::block_instruction &, parser::lex_iter_t &start, parser::lex_iter_t end) {
-        return parse_uint8_t(start, end);
+    inline auto parse_argument<size_t>(block::label_list &, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &) {
+        return parse_size(start, end);
     }
 
     template <>
-    inline auto parse_argument<ir::value>(block::block_instruction &, parser::lex_iter_t &start, parser::lex_iter_t end) {
-        return parse_value(start, end);
+    inline auto parse_argument<ir::value>(block::label_list &, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &symbols) {
+        return parse_value(start, end, symbols);
     }
 
     template <>
-    inline auto parse_argument<ir::block::icmp_type>(block::block_instruction &, parser::lex_iter_t &start, parser::lex_iter_t end) {
+    inline auto parse_argument<ir::block::icmp_type>(block::label_list &, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &) {
         return parse_icmp_type(start, end);
     }
 
     template <>
-    inline auto parse_argument<std::string>(block::block_instruction &inst_wrapper, parser::lex_iter_t &start, parser::lex_iter_t end) {
-        inst_wrapper.labels_referenced.emplace_back(start->value);
-        return start++->value;
+    inline auto parse_argument<ir::symbol>(block::label_list &labels_referenced, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &symbols) {
+        const auto name = symbols.intern(start++->value);
+
+        labels_referenced.emplace_back(name);
+        return name;
     }
 
     template <>
-    inline auto parse_argument<ir::value_size>(block::block_instruction &, parser::lex_iter_t &start, parser::lex_iter_t end) {
+    inline auto parse_argument<ir::value_size>(block::label_list &, parser::lex_iter_t &start, parser::lex_iter_t end, symbol_table &) {
         return parse_value_size(start, end);
     }
 
@@ -1,3 +1,4 @@
+#include <charconv>
 #include <iostream>
 #include "element_parsers.hpp"
 
@@ -8,49 +9,55 @@ using namespace ir;
 using lex_iter_t = parser::lex_iter_t;
 
 template <typename InstructionType, typename... Misc>
-auto generate_instruction(parser::lex_iter_t &start, parser::lex_iter_t end) {
-    ir::block::block_instruction inst_wrapper {};
+auto generate_instruction(parser::lex_iter_t &start, parser::lex_iter_t end, ir::symbol_table &symbols) {
+    ir::block::label_list labels_referenced;
 
-    return  inst_wrapper.set_instruction(
-                std::make_unique<InstructionType>(parser::parse_argument<Misc>(inst_wrapper, start, end)...)
-            )
-            .set_operands(parser::parse_operands(start, end))
+    // Arguments are parsed in the order the compiler evaluates constructor arguments,
+    // which the argument order of each instruction's constructor has been written for.
+    InstructionType instruction(parser::parse_argument<Misc>(labels_referenced, start, end, symbols)...);
+
+    return  ir::block::block_instruction {
+                std::move(instruction),
+                parser::parse_operands(start, end, symbols),
+                std::move(labels_referenced)
+            }
             .finalize();
 }
 
 template <typename InstructionType, typename... Args>
-auto generate_instruction(parser::lex_iter_t &start, parser::lex_iter_t end, Args... args) {
+auto generate_instruction(parser::lex_iter_t &start, parser::lex_iter_t end, ir::symbol_table &symbols, Args... args) {
     return ir::block::block_instruction {
-        std::make_unique<InstructionType>(args...),
-        parser::parse_operands(start, end)
+        InstructionType(args...),
+        parser::parse_operands(start, end, symbols)
     };
 }
 
-ir::block::block_instruction parser::parse_instruction(parser::lex_iter_t &start, parser::lex_iter_t end) {
+ir::block::block_instruction parser::parse_instruction(parser::lex_iter_t &start, parser::lex_iter_t end,
+                                                       ir::symbol_table &symbols) {
     std::optional<ir::variable> assignment {};
 
     if (start->value == "%") {
-        assignment = parser::parse_variable(start, end, ir::value_size::none);
+        assignment = parser::parse_variable(start, end, symbols, ir::value_size::none);
         debug::assert(start++->value == "=", "Expected =");
     }
 
-    auto instruction = parser::parse_unassigned_instruction(start, end);
+    auto instruction = parser::parse_unassigned_instruction(start, end, symbols);
     instruction.assigned_to = assignment;
 
     return instruction;
 }
 
-ir::block::block_instruction parser::parse_unassigned_instruction(parser::lex_iter_t &start, parser::lex_iter_t end) {
+ir::block::block_instruction parser::parse_unassigned_instruction(parser::lex_iter_t &start, parser::lex_iter_t end,
+                                                                  ir::symbol_table &symbols) {
     if (auto size = maybe_value_size(start, end); size.has_value()) {
         if (start->type == lexer::token_type::number) {
             return block::block_instruction {
-                std::make_unique<block::literal>(
-                        ir::int_literal {
-                                *size,
-                                static_cast<uint64_t>(std::stoi(start++->value))
-                        }
-                ),
-                {}
+                block::literal {
+                    ir::int_literal {
+                        *size,
+                        parser::parse_integer(start++->value)
+                    }
+                }
             };
         }
 
@@ -62,51 +69,61 @@ ir::block::block_instruction parser::parse_unassigned_instruction(parser::lex_it
     const auto &instruction = start++->value;
 
     if (instruction == "allocate")
-        return generate_instruction<ir::block::allocate, uint8_t>(start, end);
+        return generate_instruction<ir::block::allocate, size_t>(start, end, symbols);
     else if (instruction == "store")
-        return generate_instruction<ir::block::store, value_size>(start, end);
+        return generate_instruction<ir::block::store, value_size>(start, end, symbols);
     else if (instruction == "load")
-        return generate_instruction<ir::block::load, value_size>(start, end);
+        return generate_instruction<ir::block::load, value_size>(start, end, symbols);
     else if (instruction == "icmp")
-        return generate_instruction<ir::block::icmp, ir::block::icmp_type>(start, end);
+        return generate_instruction<ir::block::icmp, ir::block::icmp_type>(start, end, symbols);
     else if (instruction == "branch")
-        return generate_instruction<ir::block::branch, std::string, std::string>(start, end);
+        return generate_instruction<ir::block::branch, ir::symbol, ir::symbol>(start, end, symbols);
     else if (instruction == "jmp")
-        return generate_instruction<ir::block::jmp, std::string>(start, end);
+        return generate_instruction<ir::block::jmp, ir::symbol>(start, end, symbols);
     else if (instruction == "add")
-        return generate_instruction<ir::block::arithmetic>(start, end, block::arithmetic_type::add);
+        return generate_instruction<ir::block::arithmetic>(start, end, symbols, block::arithmetic_type::add);
     else if (instruction == "sub")
-        return generate_instruction<ir::block::arithmetic>(start, end, block::arithmetic_type::sub);
+        return generate_instruction<ir::block::arithmetic>(start, end, symbols, block::arithmetic_type::sub);
     else if (instruction == "mul")
-        return generate_instruction<ir::block::arithmetic>(start, end, block::arithmetic_type::mul);
+        return generate_instruction<ir::block::arithmetic>(start, end, symbols, block::arithmetic_type::mul);
     // TODO: idiv and irem
     else if (instruction == "ret")
-        return generate_instruction<ir::block::ret>(start, end);
+        return generate_instruction<ir::block::ret>(start, end, symbols);
     else if (instruction == "call")
-        return generate_instruction<ir::block::call, std::string, value_size>(start, end);
+        return generate_instruction<ir::block::call, ir::symbol, value_size>(start, end, symbols);
     else if (instruction == "phi")
-        return generate_instruction<ir::block::phi, std::string, std::string>(start, end);
+        return generate_instruction<ir::block::phi, ir::symbol, ir::symbol>(start, end, symbols);
     else if (instruction == "select")
-        return generate_instruction<ir::block::select>(start, end);
+        return generate_instruction<ir::block::select>(start, end, symbols);
     else if (instruction == "zext")
-        return generate_instruction<ir::block::zext, value_size>(start, end);
+        return generate_instruction<ir::block::zext, value_size>(start, end, symbols);
     else if (instruction == "sext")
-        return generate_instruction<ir::block::sext, value_size>(start, end);
+        return generate_instruction<ir::block::sext, value_size>(start, end, symbols);
     else if (instruction == "getarrayptr")
-        return generate_instruction<ir::block::get_array_ptr, value_size>(start, end);
-    else debug::assert(false, (std::string("Unknown instruction: ") + instruction).c_str());
+        return generate_instruction<ir::block::get_array_ptr, value_size>(start, end, symbols);
+    else debug::assert(false, std::string("Unknown instruction: ").append(instruction).c_str());
 
     throw std::runtime_error("Unreachable");
 }
 
-uint8_t parser::parse_uint8_t(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
+uint64_t parser::parse_integer(std::string_view text) {
+    uint64_t value = 0;
+    auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+    debug::assert(error == std::errc {} && ptr == text.data() + text.size(), "Malformed integer");
+
+    return value;
+}
+
+size_t parser::parse_size(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
     debug::assert(start->type == lexer::token_type::number, "Expected integer");
 
-    return std::stoi(start++->value);
+    return (size_t) parse_integer(start++->value);
 }
 
-std::vector<value> parser::parse_operands(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
-    std::vector<value> operands {};
+ir::operand_list parser::parse_operands(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end,
+                                          ir::symbol_table &symbols) {
+    ir::operand_list operands {};
 
     if (start->type == lexer::token_type::break_line)
         return operands;
@@ -115,7 +132,7 @@ std::vector<value> parser::parse_operands(ir::parser::lex_iter_t &start, ir::par
 
     do {
         start++;
-        operands.push_back(parse_value(start, end));
+        operands.push_back(parse_value(start, end, symbols));
     } while (start->value == ",");
 
     return operands;
@@ -155,25 +172,26 @@ value_size parser::parse_value_size(ir::parser::lex_iter_t &start, ir::parser::l
     return value_size::i32;
 }
 
-variable parser::parse_variable(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end, ir::value_size size) {
+variable parser::parse_variable(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end,
+                                ir::symbol_table &symbols, ir::value_size size) {
     debug::assert(start++->value == "%", "Expected %");
 
-    return variable { size, start++->value };
+    return variable { size, symbols.intern(start++->value) };
 }
 
-value parser::parse_value(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
+value parser::parse_value(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end, ir::symbol_table &symbols) {
     auto size = parse_value_size(start, end);
 
     if (start->value == "%") {
         start++;
         return ir::value {
-            ir::variable { size, start++->value }
+            ir::variable { size, symbols.intern(start++->value) }
         };
     } else if (start->type == lexer::token_type::number) {
         return ir::value{
             ir::int_literal {
                 size,
-                static_cast<uint64_t>(std::stoi(start++->value))
+                parser::parse_integer(start++->value)
             }
         };
     }
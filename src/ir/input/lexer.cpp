@@ -1,111 +1,176 @@
 #include "lexer.hpp"
+#include "../../backend/instrumentation.hpp"
 
-#include <optional>
 #include <algorithm>
-#include <unordered_set>
+#include <bit>
+#include <cstring>
 
 using namespace ir;
 
-using lex_iter_t = std::string_view::const_iterator;
+const lexer::simd::block_masks &lexer::block_cursor::at(size_t pos) {
+    const size_t block_base = pos - pos % simd::block_size;
 
-struct preident_token {
-    lexer::token token;
-    lex_iter_t end;
-};
+    if (block_base == base)
+        return masks;
 
-using preident_function = std::optional<preident_token>(*)(lex_iter_t, lex_iter_t);
+    base = block_base;
 
-std::optional<preident_token> get_symbol(lex_iter_t start, lex_iter_t) {
-    const static std::unordered_set<char> symbols {
-        '%', '=', ',', ':', '-', '(', ')', '.'
-    };
+    if (base + simd::block_size <= input.size()) {
+        masks = classify(input.data() + base);
+    } else {
+        // The final partial block is padded with line breaks, which end every run,
+        // so the classifier never reads past the end of the input.
+        char padded[simd::block_size];
+        std::memset(padded, '\n', sizeof(padded));
+        std::memcpy(padded, input.data() + base, input.size() - base);
 
-    if (!symbols.contains(*start)) return std::nullopt;
+        masks = classify(padded);
+    }
 
-    return preident_token {
-        lexer::token {
-            lexer::token_type::symbol,
-            std::string(start, start + 1)
-        },
-        start + 1
-    };
+    return masks;
 }
 
-std::optional<preident_token> get_string(lex_iter_t start, lex_iter_t end) {
-    if (*start != '"') return std::nullopt;
+size_t lexer::block_cursor::run_end(size_t pos, uint64_t simd::block_masks::*mask) {
+    while (pos < input.size()) {
+        const auto &block = at(pos);
+        const uint64_t stops = ~(block.*mask) >> (pos - base);
 
-    auto end_quote = std::string_view(start, end).find('"', 1);
+        if (stops != 0)
+            return std::min(pos + std::countr_zero(stops), input.size());
 
-    if (end_quote == std::string_view::npos) return std::nullopt;
+        pos = base + simd::block_size;
+    }
 
-    return preident_token {
-        lexer::token {
-            lexer::token_type::string,
-            std::string(start + 1, start + end_quote)
-        },
-        start + end_quote + 1
-    };
+    return input.size();
 }
 
-const static preident_function preident_functions[] = {
-    get_symbol,
-    get_string
-};
+uint32_t lexer::identifier_table::intern(std::string_view name) {
+    auto [iter, inserted] = ids.try_emplace(name, (uint32_t) names.size());
 
-std::vector<lexer::token> lexer::lex(std::string_view input) {
-    auto iter = input.begin();
-    auto unconsumed_begin = input.begin();
-    const auto end = input.end();
+    if (inserted)
+        names.push_back(name);
 
-    std::vector<lexer::token> tokens;
+    return iter->second;
+}
 
-    const auto dump_unconsumed = [&]() {
-        if (unconsumed_begin != iter) {
-            auto type = std::isdigit(*unconsumed_begin) ? lexer::token_type::number : lexer::token_type::identifier;
-            tokens.emplace_back(type, std::string(unconsumed_begin, iter));
-        }
+void lexer::incremental_lexer::step(std::vector<token> &tokens) {
+    const auto input = cursor.input;
+    const auto &masks = cursor.at(pos);
+    const uint64_t bit = (uint64_t) 1 << (pos - cursor.base);
 
-        unconsumed_begin = ++iter;
-    };
+    if (masks.word & bit) {
+        const auto end = cursor.run_end(pos, &simd::block_masks::word);
+        const auto text = input.substr(pos, end - pos);
 
-    while (iter < input.end()) {
-        if (*iter == '\n' || *iter == '\r') {
-            dump_unconsumed();
-            tokens.emplace_back(lexer::token_type::break_line, "\n");
-            unconsumed_begin = iter;
-        }
+        if (text.front() >= '0' && text.front() <= '9')
+            tokens.emplace_back(token_type::number, text);
+        else
+            tokens.emplace_back(token_type::identifier, text, identifiers.intern(text));
 
-        while (std::isspace(*iter))
-            dump_unconsumed();
+        pos = end;
+        return;
+    }
 
-        if (*iter == ';') {
-            dump_unconsumed();
+    if (masks.space & bit) {
+        pos = cursor.run_end(pos, &simd::block_masks::space);
+        return;
+    }
 
-            iter = std::find(iter, end, '\n');
-        }
+    switch (input[pos]) {
+        case '\n':
+        case '\r':
+            // Blank lines collapse into a single line break
+            if (tokens.empty() || tokens.back().type != token_type::break_line)
+                tokens.emplace_back(token_type::break_line, "\n");
 
-        if (iter == input.end()) break;
+            pos++;
+            break;
 
-        for (auto &func : preident_functions) {
-            auto token = func(iter, end);
+        case ';':
+            pos = std::min(input.find('\n', pos), input.size());
+            break;
 
-            if (token.has_value()) {
-                dump_unconsumed();
-                tokens.push_back(token->token);
+        case '"': {
+            const auto end_quote = input.find('"', pos + 1);
 
-                iter = token->end;
-                unconsumed_begin = iter;
-                goto preident_found;
+            // An unterminated quote is left as a symbol for the parser to reject
+            if (end_quote == std::string_view::npos) {
+                tokens.emplace_back(token_type::symbol, input.substr(pos, 1));
+                pos++;
+                break;
             }
+
+            tokens.emplace_back(token_type::string, input.substr(pos + 1, end_quote - pos - 1));
+            pos = end_quote + 1;
+            break;
         }
 
-        iter++;
+        default:
+            tokens.emplace_back(token_type::symbol, input.substr(pos, 1));
+            pos++;
+            break;
+    }
+}
+
+bool lexer::incremental_lexer::next_global(std::vector<token> &tokens) {
+    backend::instrument::phase_timer timer { backend::instrument::phase::lex };
+
+    const auto first = tokens.size();
 
-        preident_found:
-        ;
+    // A definition spans until a line consisting only of 'end', anything else is a single line
+    const auto is_complete = [&]() {
+        const auto count = tokens.size() - first;
+
+        if (count == 0 || tokens.back().type != token_type::break_line)
+            return false;
+
+        const auto &head = tokens[first].type == token_type::break_line && count > 1
+            ? tokens[first + 1]
+            : tokens[first];
+
+        if (head.type == token_type::break_line)
+            return false;
+        if (head.value != "define")
+            return true;
+
+        return count >= 3
+            && tokens[tokens.size() - 2].value == "end"
+            && tokens[tokens.size() - 3].type == token_type::break_line;
+    };
+
+    while (!done()) {
+        step(tokens);
+
+        if (is_complete())
+            return true;
     }
 
-    dump_unconsumed();
+    if (tokens.size() == first)
+        return false;
+
+    if (tokens.back().type != token_type::break_line)
+        tokens.emplace_back(token_type::break_line, "\n");
+
+    return true;
+}
+
+std::vector<lexer::token> lexer::lex(std::string_view input) {
+    identifier_table identifiers;
+    return lex(input, identifiers);
+}
+
+std::vector<lexer::token> lexer::lex(std::string_view input, identifier_table &identifiers, simd::isa instruction_set) {
+    backend::instrument::phase_timer timer { backend::instrument::phase::lex };
+
+    incremental_lexer lexer { input, identifiers, instruction_set };
+    std::vector<lexer::token> tokens;
+
+    // Roughly one token per three characters of IR, reserving up front avoids
+    // most of the reallocation on large inputs.
+    tokens.reserve(input.size() / 3);
+
+    while (!lexer.done())
+        lexer.step(tokens);
 
     return tokens;
-}
\ No newline at end of file
+}
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "lexer_simd.hpp"
+
 namespace ir::lexer {
-    enum class token_type {
+    enum class token_type : uint8_t {
         identifier,
         number,
         string,
@@ -12,10 +17,75 @@ namespace ir::lexer {
         break_line
     };
 
+    /**
+     *  A token does not own its text, @value is a view into the lexed input,
+     *  so the input must outlive any tokens produced from it. Identifiers
+     *  additionally carry an @id which is equal for equal identifier text,
+     *  allowing comparisons without touching the underlying characters.
+     */
     struct token {
         token_type type;
-        std::string value;
+        std::string_view value;
+        uint32_t id = 0;
+    };
+
+    /**
+     *  Maps identifier text to a dense id. Like tokens, the stored names
+     *  are views into the lexed input.
+     */
+    struct identifier_table {
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::vector<std::string_view> names;
+
+        uint32_t intern(std::string_view name);
+    };
+
+    /**
+     *  Caches the classification masks of the block the lexer is currently in,
+     *  so that finding the end of a run (an identifier, indentation, etc.) is a
+     *  bit scan rather than a per-character loop.
+     */
+    struct block_cursor {
+        std::string_view input;
+        simd::classify_fn classify;
+
+        size_t base = std::string_view::npos;
+        simd::block_masks masks {};
+
+        const simd::block_masks &at(size_t pos);
+        size_t run_end(size_t pos, uint64_t simd::block_masks::*mask);
+    };
+
+    /**
+     *  Resumable form of lex, for callers which only want part of the input's
+     *  tokens in memory at a time.
+     */
+    struct incremental_lexer {
+        block_cursor cursor;
+        identifier_table &identifiers;
+        size_t pos = 0;
+
+        incremental_lexer(std::string_view input, identifier_table &identifiers,
+                          simd::isa instruction_set = simd::best_isa())
+            : cursor { input, simd::classifier(instruction_set) }, identifiers(identifiers) {}
+
+        [[nodiscard]] bool done() const { return pos >= cursor.input.size(); }
+
+        /**
+         *  Lexes at most one token into @tokens, skipped whitespace and comments
+         *  produce no token.
+         */
+        void step(std::vector<token> &tokens);
+
+        /**
+         *  Appends the tokens of the next top-level node (a global string, an extern
+         *  declaration or a function definition up to its 'end'), always followed by
+         *  a line break. Returns false once the input is exhausted.
+         */
+        bool next_global(std::vector<token> &tokens);
     };
 
     std::vector<token> lex(std::string_view input);
-}
\ No newline at end of file
+    std::vector<token> lex(std::string_view input, identifier_table &identifiers,
+                           simd::isa instruction_set = simd::best_isa());
+}
@@ -0,0 +1,167 @@
+#include "lexer_simd.hpp"
+
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEXER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace ir::lexer;
+
+namespace {
+    constexpr bool is_delimiter(unsigned char c) {
+        switch (c) {
+            case '\t': case '\n': case '\v': case '\f': case '\r': case ' ':
+            case '%': case '=': case ',': case ':': case '-': case '(': case ')': case '.':
+            case '"': case ';':
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    constexpr bool is_inline_space(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    simd::block_masks classify_scalar(const char *block) {
+        simd::block_masks masks { 0, 0 };
+
+        for (int i = 0; i < simd::block_size; i++) {
+            const auto c = (unsigned char) block[i];
+
+            masks.word |= (uint64_t) !is_delimiter(c) << i;
+            masks.space |= (uint64_t) is_inline_space(c) << i;
+        }
+
+        return masks;
+    }
+
+#ifdef LEXER_SIMD_X86
+    // SSE2 has no byte shuffle, so delimiters are found by comparing against each
+    // delimiter in turn, with \t through \r folded into a single range check.
+    __attribute__((target("sse2")))
+    inline __m128i eq(__m128i chunk, char c) {
+        return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c));
+    }
+
+    __attribute__((target("sse2")))
+    simd::block_masks classify_sse2(const char *block) {
+        simd::block_masks masks { 0, 0 };
+
+        for (int offset = 0; offset < simd::block_size; offset += 16) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset));
+
+            const auto from_tab = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+            const auto control_space = _mm_cmpeq_epi8(_mm_min_epu8(from_tab, _mm_set1_epi8(4)), from_tab);
+
+            auto space = _mm_or_si128(eq(chunk, ' '), eq(chunk, '\t'));
+            space = _mm_or_si128(space, _mm_or_si128(eq(chunk, '\v'), eq(chunk, '\f')));
+
+            auto delim = _mm_or_si128(control_space, eq(chunk, ' '));
+            delim = _mm_or_si128(delim, _mm_or_si128(eq(chunk, '%'), eq(chunk, '=')));
+            delim = _mm_or_si128(delim, _mm_or_si128(eq(chunk, ','), eq(chunk, ':')));
+            delim = _mm_or_si128(delim, _mm_or_si128(eq(chunk, '-'), eq(chunk, '(')));
+            delim = _mm_or_si128(delim, _mm_or_si128(eq(chunk, ')'), eq(chunk, '.')));
+            delim = _mm_or_si128(delim, _mm_or_si128(eq(chunk, '"'), eq(chunk, ';')));
+
+            const auto delim_bits = (uint64_t) (uint16_t) _mm_movemask_epi8(delim);
+            const auto space_bits = (uint64_t) (uint16_t) _mm_movemask_epi8(space);
+
+            masks.word |= (~delim_bits & 0xFFFF) << offset;
+            masks.space |= space_bits << offset;
+        }
+
+        return masks;
+    }
+
+    // AVX2 classifies with two nibble lookups: a byte is a delimiter iff the
+    // classes of its low and high nibble share a bit.
+    //   bit 0: high nibble 0x0, low nibble in { 9, A, B, C, D }        -> \t \n \v \f \r
+    //   bit 1: high nibble 0x2, low nibble in { 0, 2, 5, 8, 9, C, D, E } -> ' ' " % ( ) , - .
+    //   bit 2: high nibble 0x3, low nibble in { A, B, D }              -> : ; =
+    __attribute__((target("avx2")))
+    inline __m256i eq(__m256i chunk, char c) {
+        return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c));
+    }
+
+    __attribute__((target("avx2")))
+    simd::block_masks classify_avx2(const char *block) {
+        simd::block_masks masks { 0, 0 };
+
+        const auto low_table = _mm256_setr_epi8(
+            2, 0, 2, 0, 0, 2, 0, 0, 2, 3, 5, 5, 3, 7, 2, 0,
+            2, 0, 2, 0, 0, 2, 0, 0, 2, 3, 5, 5, 3, 7, 2, 0
+        );
+        const auto high_table = _mm256_setr_epi8(
+            1, 0, 2, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            1, 0, 2, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+        );
+        const auto nibble = _mm256_set1_epi8(0x0F);
+
+        for (int offset = 0; offset < simd::block_size; offset += 32) {
+            const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + offset));
+
+            const auto low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(chunk, nibble));
+            const auto high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+            const auto word = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+
+            auto space = _mm256_or_si256(eq(chunk, ' '), eq(chunk, '\t'));
+            space = _mm256_or_si256(space, _mm256_or_si256(eq(chunk, '\v'), eq(chunk, '\f')));
+
+            masks.word |= (uint64_t) (uint32_t) _mm256_movemask_epi8(word) << offset;
+            masks.space |= (uint64_t) (uint32_t) _mm256_movemask_epi8(space) << offset;
+        }
+
+        return masks;
+    }
+#endif
+}
+
+const char *simd::isa_name(isa instruction_set) {
+    switch (instruction_set) {
+        case isa::scalar: return "scalar";
+        case isa::sse2: return "sse2";
+        case isa::avx2: return "avx2";
+    }
+
+    throw std::runtime_error("no such instruction set");
+}
+
+bool simd::isa_supported(isa instruction_set) {
+    switch (instruction_set) {
+        case isa::scalar:
+            return true;
+#ifdef LEXER_SIMD_X86
+        case isa::sse2:
+            return __builtin_cpu_supports("sse2");
+        case isa::avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+simd::isa simd::best_isa() {
+    const static isa best = [] {
+        if (isa_supported(isa::avx2)) return isa::avx2;
+        if (isa_supported(isa::sse2)) return isa::sse2;
+
+        return isa::scalar;
+    }();
+
+    return best;
+}
+
+simd::classify_fn simd::classifier(isa instruction_set) {
+    switch (instruction_set) {
+#ifdef LEXER_SIMD_X86
+        case isa::avx2: return classify_avx2;
+        case isa::sse2: return classify_sse2;
+#endif
+        default: return classify_scalar;
+    }
+}
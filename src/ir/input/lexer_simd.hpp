@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ir::lexer::simd {
+    /**
+     *  The lexer classifies its input in blocks of @block_size bytes. Each
+     *  bit of a mask corresponds to one byte of the block, the lowest bit
+     *  being the first byte.
+     *
+     *  @word:  bytes which belong to an identifier or number, i.e. every byte
+     *          which is not whitespace, a line break, a symbol, a quote or
+     *          the start of a comment.
+     *  @space: whitespace bytes which are not line breaks.
+     */
+    struct block_masks {
+        uint64_t word;
+        uint64_t space;
+    };
+
+    constexpr int block_size = 64;
+
+    enum class isa : uint8_t {
+        scalar, sse2, avx2
+    };
+
+    using classify_fn = block_masks(*)(const char *block);
+
+    const char* isa_name(isa instruction_set);
+
+    /**
+     *  The widest instruction set supported by the running CPU, detected once
+     *  on first use.
+     */
+    isa best_isa();
+    bool isa_supported(isa instruction_set);
+
+    /**
+     *  Returns a classifier for the given instruction set. The classifier always
+     *  reads exactly @block_size bytes from the pointer it is given.
+     */
+    classify_fn classifier(isa instruction_set);
+}
@@ -1,5 +1,6 @@
 #include "parser.hpp"
 #include "instruction_parsing.hpp"
+#include "../../backend/instrumentation.hpp"
 
 using namespace ir;
 
@@ -8,38 +9,56 @@ ir::root parser::parse(const std::vector<ir::lexer::token> &tokens) {
 }
 
 ir::root parser::parse_root(ir::parser::lex_iter_t start, ir::parser::lex_iter_t end) {
-    ir::root root {};
+    backend::instrument::phase_timer timer { backend::instrument::phase::parse };
 
-    while (start < end) {
-        while (start->type == lexer::token_type::break_line)
-            ++start;
-
-        debug::assert(start->type == lexer::token_type::identifier, "Expected identifier");
+    ir::root root {};
 
-        if (start->value == "global_string") {
-            root.global_strings.emplace_back(parse_global_string(++start, end));
-        } else if (start->value == "extern") {
-            root.extern_functions.emplace_back(parse_extern_function(++start, end));
-        } else if (start->value == "define") {
-            root.functions.emplace_back(parse_function(++start, end));
-        } else {
-            debug::assert(false, "Unknown global node type");
-        }
+    while (auto global = parse_global(start, end)) {
+        std::visit([&](auto &&node) {
+            using T = std::decay_t<decltype(node)>;
+
+            if constexpr (std::is_same_v<T, ir::global::global_string>)
+                root.global_strings.emplace_back(std::move(node));
+            else if constexpr (std::is_same_v<T, ir::global::extern_function>)
+                root.extern_functions.emplace_back(std::move(node));
+            else
+                root.functions.emplace_back(std::move(node));
+        }, *global);
     }
 
     return root;
 }
 
+std::optional<parser::global_node> parser::parse_global(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
+    while (start < end && start->type == lexer::token_type::break_line)
+        ++start;
+
+    if (start >= end)
+        return std::nullopt;
+
+    debug::assert(start->type == lexer::token_type::identifier, "Expected identifier");
+
+    if (start->value == "global_string")
+        return parse_global_string(++start, end);
+    else if (start->value == "extern")
+        return parse_extern_function(++start, end);
+    else if (start->value == "define")
+        return parse_function(++start, end);
+
+    debug::assert(false, "Unknown global node type");
+    throw std::runtime_error("Unreachable");
+}
+
 ir::global::global_string parser::parse_global_string(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
     debug::assert(start->value == "%", "Expected %");
     debug::assert((++start)->type == lexer::token_type::identifier, "Expected identifier");
 
-    std::string name = start->value;
+    std::string name { start->value };
 
     debug::assert((++start)->value == "=", "Expected =");
     debug::assert((++start)->type == lexer::token_type::string, "Expected c\"");
 
-    return ir::global::global_string { name, start++->value };
+    return ir::global::global_string { std::move(name), std::string { start++->value } };
 }
 
 ir::global::extern_function parser::parse_extern_function(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
@@ -49,13 +68,16 @@ ir::global::extern_function parser::parse_extern_function(ir::parser::lex_iter_t
 
     debug::assert(start->type == lexer::token_type::identifier, "Expected identifier");
 
-    auto name = start++->value;
-    auto parameters = parse_parameters(start, end);
+    std::string name { start++->value };
+
+    ir::symbol_table symbols;
+    auto parameters = parse_parameters(start, end, symbols);
 
     debug::assert(start++->type == lexer::token_type::break_line, "Expected Break Line");
 
     return ir::global::extern_function {
         std::move(name),
+        std::move(symbols),
         std::move(parameters),
         return_type
     };
@@ -63,18 +85,32 @@ ir::global::extern_function parser::parse_extern_function(ir::parser::lex_iter_t
 
 ir::global::function parser::parse_function(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
     auto function_prototype = parse_extern_function(start, end);
+    auto &symbols = function_prototype.symbols;
 
     std::vector<ir::block::block> blocks;
 
+    // Instructions are collected here and copied into their block once it ends,
+    // so each block's instructions are a single allocation of exactly their size.
+    std::vector<ir::block::block_instruction> pending;
+
+    const auto end_block = [&]() {
+        if (blocks.empty())
+            return;
+
+        blocks.back().instructions.assign(std::make_move_iterator(pending.begin()), std::make_move_iterator(pending.end()));
+        pending.clear();
+    };
+
     if (start->value != ".")
-        blocks.emplace_back("entry");
+        blocks.emplace_back(symbols.intern("entry"));
 
     while (start->type == lexer::token_type::break_line)
         ++start;
 
     while (start->value != "end") {
         if (start->value == ".") {
-            blocks.emplace_back((++start)->value);
+            end_block();
+            blocks.emplace_back(symbols.intern((++start)->value));
 
             debug::assert((++start)->value == ":", "Expected Colon after Label");
             debug::assert((++start)->type == ir::lexer::token_type::break_line, "Expected Break Line");
@@ -84,23 +120,26 @@ ir::global::function parser::parse_function(ir::parser::lex_iter_t &start, ir::p
             continue;
         }
 
-        blocks.back().instructions.push_back(parse_instruction(start, end));
+        pending.push_back(parse_instruction(start, end, symbols));
 
         while (start->type == lexer::token_type::break_line)
             ++start;
     }
 
+    end_block();
     start++;
 
     return ir::global::function {
         std::move(function_prototype.name),
+        std::move(symbols),
         std::move(function_prototype.parameters),
         std::move(blocks),
         function_prototype.return_type
     };
 }
 
-std::vector<ir::variable> parser::parse_parameters(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end) {
+std::vector<ir::variable> parser::parse_parameters(ir::parser::lex_iter_t &start, ir::parser::lex_iter_t end,
+                                                   ir::symbol_table &symbols) {
     std::vector<ir::variable> parameters;
 
     debug::assert(start++->value == "(", "Expected (");
@@ -114,13 +153,12 @@ std::vector<ir::variable> parser::parse_parameters(ir::parser::lex_iter_t &start
 
     do {
         start++;
-        auto param = parse_value(start, end);
+        auto param = parse_value(start, end, symbols);
 
         if (param.is_literal())
             throw std::runtime_error("Integers are not allowed as parameters");
 
-        // std::move used here as ownership is transferred to the vector
-        parameters.emplace_back(std::move(std::get<ir::variable>(param.val)));
+        parameters.emplace_back(param.var());
     } while (start->value == ",");
 
     debug::assert(start++->value == ")", "Expected )");
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <optional>
+#include <variant>
 #include <vector>
 #include "../nodes.hpp"
 
@@ -14,9 +16,17 @@ namespace ir::parser {
 
     ir::root parse_root(lex_iter_t start, lex_iter_t end);
 
+    using global_node = std::variant<ir::global::global_string, ir::global::extern_function, ir::global::function>;
+
+    /**
+     *  Parses the next top-level node, skipping any leading line breaks. Returns
+     *  std::nullopt once there are no tokens left.
+     */
+    std::optional<global_node> parse_global(lex_iter_t &start, lex_iter_t end);
+
     ir::global::global_string parse_global_string(lex_iter_t &start, lex_iter_t end);
     ir::global::extern_function parse_extern_function(lex_iter_t &start, lex_iter_t end);
     ir::global::function parse_function(lex_iter_t &start, lex_iter_t end);
 
-    std::vector<ir::variable> parse_parameters(lex_iter_t &start, lex_iter_t end);
+    std::vector<ir::variable> parse_parameters(lex_iter_t &start, lex_iter_t end, ir::symbol_table &symbols);
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "source_file.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ir::input::source_file::source_file(std::string_view path) {
+    const std::string owned_path { path };
+    const int fd = open(owned_path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return;
+
+    struct stat info {};
+
+    if (fstat(fd, &info) == 0) {
+        opened = true;
+
+        // mmap rejects zero-length mappings, an empty file is simply an empty view
+        if (info.st_size > 0) {
+            void *mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char*>(mapped);
+                size = (size_t) info.st_size;
+
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            } else {
+                opened = false;
+            }
+        }
+    }
+
+    close(fd);
+}
+
+void ir::input::source_file::release_before(size_t offset) const {
+    const auto page_size = (size_t) sysconf(_SC_PAGESIZE);
+    const auto length = std::min(offset, size) / page_size * page_size;
+
+    if (data && length > 0)
+        madvise(const_cast<char*>(data), length, MADV_DONTNEED);
+}
+
+ir::input::source_file::~source_file() {
+    if (data)
+        munmap(const_cast<char*>(data), size);
+}
+
+ir::input::source_file::source_file(source_file &&other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      opened(std::exchange(other.opened, false)) {}
+
+ir::input::source_file &ir::input::source_file::operator=(source_file &&other) noexcept {
+    if (this != &other) {
+        if (data)
+            munmap(const_cast<char*>(data), size);
+
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+        opened = std::exchange(other.opened, false);
+    }
+
+    return *this;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace ir::input {
+    /**
+     *  Read-only view of a file on disk. The file is memory mapped rather than
+     *  copied into a buffer, so lexing directly over @view does not require
+     *  reading the file up front. The mapping is released on destruction,
+     *  invalidating any views into it.
+     */
+    struct source_file {
+        const char *data = nullptr;
+        size_t size = 0;
+
+        explicit source_file(std::string_view path);
+        ~source_file();
+
+        source_file(const source_file&) = delete;
+        source_file& operator=(const source_file&) = delete;
+
+        source_file(source_file &&other) noexcept;
+        source_file& operator=(source_file &&other) noexcept;
+
+        [[nodiscard]] std::string_view view() const {
+            return { data, size };
+        }
+
+        [[nodiscard]] bool is_open() const {
+            return opened;
+        }
+
+        /**
+         *  Hints that the first @offset bytes will not be read again soon, allowing their
+         *  pages to be dropped from memory. Views into the range stay valid, as the pages
+         *  are read back in from the file if they are accessed.
+         */
+        void release_before(size_t offset) const;
+
+    private:
+        bool opened = false;
+    };
+}
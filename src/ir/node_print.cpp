@@ -1,18 +1,18 @@
 #include "nodes.hpp"
 
-void ir::block::block_instruction::print(std::ostream &ostream) const {
+void ir::block::block_instruction::print(std::ostream &ostream, const ir::symbol_table &symbols) const {
     ostream << "    ";
 
     if (assigned_to) {
-        assigned_to->print(ostream);
+        assigned_to->print(ostream, symbols);
         ostream << " = ";
     }
 
-    inst->print(ostream);
+    std::visit([&](const auto &arg) { arg.print(ostream, symbols); }, inst);
 
     for (size_t i = 0; i < operands.size(); i++) {
         ostream << " ";
-        ostream << operands[i];
+        operands[i].print(ostream, symbols);
 
         if (i != operands.size() - 1) ostream << ",";
     }
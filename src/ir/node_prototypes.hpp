@@ -11,7 +11,6 @@ namespace ir {
     struct value;
 
     namespace block {
-        struct instruction;
         struct block_instruction;
         struct block;
         struct allocate;
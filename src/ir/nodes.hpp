@@ -1,6 +1,8 @@
 #pragma once
 
 #include "nodes.hpp"
+#include "small_vector.hpp"
+#include "symbol_table.hpp"
 #include "../backend/ir_analyzer/node_metadata.hpp"
 #include "../debug/assert.hpp"
 
@@ -12,7 +14,7 @@
 #include <optional>
 #include <exception>
 
-#define PRINT_DEF(node_name, ...) void print(std::ostream &ostream) const override { __inst_print(ostream, node_name, ##__VA_ARGS__); }
+#define PRINT_DEF(node_name, ...) void print(std::ostream &ostream, const ir::symbol_table &symbols) const { __inst_print(ostream, symbols, node_name, ##__VA_ARGS__); }
 #define VISITOR_DEF(node_name) void accept(auto fn) { fn(*this); }
 
 namespace backend::context {
@@ -84,20 +86,21 @@ namespace ir {
      *  Seen in IR as either [size] %[name] or [size] %[name]. Represents data
      *  stored somewhere in storage. There is no guarantee it will be
      *  stored in a register/stack memory, or even that it is directly stored
-     *  at all if not required.
+     *  at all if not required. The name is a symbol of the enclosing function,
+     *  so printing it requires that function's symbol table.
      */
     struct variable {
         value_size size;
-        std::string name;
+        symbol name;
 
-        explicit variable(value_size size, std::string name)
-            :   size(size), name(std::move(name)) {}
+        explicit variable(value_size size, symbol name)
+            :   size(size), name(name) {}
 
-        void print(std::ostream &ostream) const {
+        void print(std::ostream &ostream, const symbol_table &symbols) const {
             if (size != value_size::param_dependent && size != value_size::none)
                 ostream << value_size_str(size) << " ";
 
-            ostream << "%" << name;
+            ostream << "%" << symbols.name(name);
         }
     };
 
@@ -110,21 +113,23 @@ namespace ir {
         std::variant<int_literal, variable> val;
 
         explicit value(int_literal val) : val(val) {}
-        explicit value(variable val) : val(std::move(val)) {}
+        explicit value(variable val) : val(val) {}
 
-        friend std::ostream& operator <<(std::ostream &ostream, const value& value) {
-            std::visit([&](auto&& arg) { arg.print(ostream); }, value.val);
-            return ostream;
+        void print(std::ostream &ostream, const symbol_table &symbols) const {
+            if (is_literal())
+                lit().print(ostream);
+            else
+                var().print(ostream, symbols);
         }
 
         [[nodiscard]] value_size get_size() const {
             return std::visit([](auto&& arg) -> value_size { return arg.size; }, val);
         }
-        [[nodiscard]] std::string_view get_name() const {
+        [[nodiscard]] symbol_id get_id() const {
             if (is_literal())
-                throw std::runtime_error("Cannot get name of literal");
+                throw std::runtime_error("Cannot get id of literal");
 
-            return var().name;
+            return var().name.id;
         }
         [[nodiscard]] bool is_variable() const {
             return std::holds_alternative<variable>(val);
@@ -140,23 +145,32 @@ namespace ir {
         }
     };
 
+    using operand_list = small_vector<value, 3>;
+
     namespace block {
         template <typename T>
-        inline void _val_print(std::ostream& ostream, const T& arg) {
+        inline void _val_print(std::ostream& ostream, const symbol_table &, const T& arg) {
             ostream << " " << arg;
         }
 
         template <>
-        inline void _val_print<value_size>(std::ostream& ostream, const value_size& arg) {
+        inline void _val_print<value_size>(std::ostream& ostream, const symbol_table &, const value_size& arg) {
             ostream << " " << value_size_str(arg);
         }
 
+        template <>
+        inline void _val_print<symbol>(std::ostream& ostream, const symbol_table &symbols, const symbol& arg) {
+            ostream << " " << symbols.name(arg);
+        }
+
         template <typename... args>
-        inline void __inst_print(std::ostream& ostream, const char* node_name, args... arg) {
+        inline void __inst_print(std::ostream& ostream, const symbol_table &symbols, const char* node_name, args... arg) {
             ostream << node_name;
-            (_val_print(ostream, arg), ...);
+            (_val_print(ostream, symbols, arg), ...);
         }
 
+        using label_list = small_vector<symbol, 2>;
+
         enum class node_type {
             literal, allocate, store, load,
             branch, jmp, icmp,
@@ -175,83 +189,14 @@ namespace ir {
          *  For instance, useless code whose side effects are non-existent,
          *  like an 'add' instruction with no assignment, will be ignored,
          *  as there is no intended functionality with the instruction.
+         *
+         *  Instructions are plain structs held by value in the @instruction
+         *  variant, each carrying its node_type as @tag. The members here are
+         *  defaults an instruction may shadow with its own.
          */
-        struct instruction : node {
-            const node_type type;
-
-            explicit instruction(node_type type) : type(type) {}
-            virtual ~instruction() = default;
-
-            virtual void print(std::ostream&) const = 0;
-
-            [[nodiscard]] virtual bool auto_drop_reassignable() const { return true; }
-            [[nodiscard]] virtual ir::value_size get_return_size() const { return ir::value_size::param_dependent; }
-        };
-
-        /**
-         *  Container struct for an instruction. To encapsulate the virtual
-         *  nature of an instruction, data handling of instructions is done
-         *  internally by the struct.
-         */
-        struct block_instruction : node {
-            std::unique_ptr<instruction> inst;
-            std::vector<value> operands;
-            std::optional<variable> assigned_to;
-            std::vector<std::string> labels_referenced;
-
-            std::unique_ptr<backend::md::instruction_metadata> metadata { nullptr };
-
-            explicit block_instruction(std::unique_ptr<instruction> instruction,
-                                       std::vector<value> operands)
-                :   inst(std::move(instruction)), operands(std::move(operands)) {
-
-            }
-
-            block_instruction() noexcept = default;
-
-            block_instruction&& set_instruction(std::unique_ptr<instruction> instruction) {
-                inst = std::move(instruction);
-                return std::move(*this);
-            }
-
-            block_instruction&& add_operand(value operand) {
-                operands.push_back(std::move(operand));
-                return std::move(*this);
-            }
-
-            block_instruction&& set_operands(std::vector<value> new_operands) {
-                this->operands = std::move(new_operands);
-                return std::move(*this);
-            }
-
-            block_instruction&& finalize() {
-                if (assigned_to == std::nullopt)
-                    return std::move(*this);
-
-                const auto size = inst->get_return_size();
-                debug::assert(size != ir::value_size::none, "instruction with no return size assigned to variable");
-
-                if (size == ir::value_size::param_dependent) {
-                    debug::assert(!operands.empty(), "param dependent size with multiple operands");
-
-                    assigned_to->size = operands.back().get_size();
-                }
-
-                return std::move(*this);
-            }
-
-            void print(std::ostream &ostream) const;
-        };
-
-        /**
-         *  The organizational unit of a function body. Essentially represents
-         *  a local label within a subroutine in assembly.
-         */
-        struct block : node {
-            std::string name;
-            std::vector<block_instruction> instructions {};
-
-            explicit block(std::string name) : name(std::move(name)), instructions() {};
+        struct instruction_base : node {
+            [[nodiscard]] bool auto_drop_reassignable() const { return true; }
+            [[nodiscard]] ir::value_size get_return_size() const { return ir::value_size::param_dependent; }
         };
 
         /**
@@ -259,19 +204,20 @@ namespace ir {
          *  automatically be folded as a constant and will never be allocated
          *  in actual memory.
          */
-        struct literal : instruction {
+        struct literal : instruction_base {
+            static constexpr node_type tag = node_type::literal;
+
             ir::int_literal value;
 
             explicit literal(ir::int_literal value)
-                : instruction(node_type::literal), value(value) {}
-            ~literal() override = default;
+                : value(value) {}
 
-            void print(std::ostream &ostream) const override {
+            void print(std::ostream &ostream, const symbol_table &) const {
                 ostream << value.value;
             }
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return value.size; }
+            [[nodiscard]] ir::value_size get_return_size() const { return value.size; }
         };
 
         /**
@@ -283,29 +229,31 @@ namespace ir {
          *  guarantee that unreferenced parts of this stack memory will actually
          *  exist, only that there is some referencable stack memory of @size bytes.
          */
-        struct allocate : instruction {
+        struct allocate : instruction_base {
+            static constexpr node_type tag = node_type::allocate;
+
             size_t size;
 
             explicit allocate(size_t allocation_size)
-                :   instruction(node_type::allocate), size(allocation_size) {}
-            ~allocate() override = default;
+                :   size(allocation_size) {}
 
             PRINT_DEF("allocate", size);
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return ir::value_size::ptr; }
+            [[nodiscard]] ir::value_size get_return_size() const { return ir::value_size::ptr; }
         };
 
         /**
          *  Given a logical pointer and an operand of @size bytes, stores
          *  that value in the stack memory referenced by the pointer.
          */
-        struct store : instruction {
+        struct store : instruction_base {
+            static constexpr node_type tag = node_type::store;
+
             value_size size;
 
             explicit store(value_size size)
-                :   instruction(node_type::store), size(size) {}
-            ~store() override = default;
+                :   size(size) {}
 
             PRINT_DEF("store", size);
             VISITOR_DEF();
@@ -315,32 +263,33 @@ namespace ir {
          *  Given a logical pointer, returns @size bytes of data from the
          *  referenced stack memory.
          */
-        struct load : instruction {
+        struct load : instruction_base {
+            static constexpr node_type tag = node_type::load;
+
             value_size size;
 
             explicit load(value_size size)
-                :   instruction(node_type::load), size(size) {}
-            ~load() override = default;
+                :   size(size) {}
 
             PRINT_DEF("load", ir::value_size_str(size));
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return size; }
+            [[nodiscard]] ir::value_size get_return_size() const { return size; }
         };
 
         /**
          *  Branches depending on the provided condition, @true_branch if non-zero
          *  and @false_branch if zero.
          */
-        struct branch : instruction {
-            std::string true_branch;
-            std::string false_branch;
+        struct branch : instruction_base {
+            static constexpr node_type tag = node_type::branch;
 
-            explicit branch(std::string false_branch, std::string true_branch)
-                :   instruction(node_type::branch),
-                    true_branch(std::move(true_branch)),
-                    false_branch(std::move(false_branch)) {}
-            ~branch() override = default;
+            symbol true_branch;
+            symbol false_branch;
+
+            explicit branch(symbol false_branch, symbol true_branch)
+                :   true_branch(true_branch),
+                    false_branch(false_branch) {}
 
             PRINT_DEF("branch", true_branch, false_branch);
             VISITOR_DEF();
@@ -349,13 +298,13 @@ namespace ir {
         /**
          *  Unconditional jump to @label.
          */
-        struct jmp : instruction {
-            std::string label;
+        struct jmp : instruction_base {
+            static constexpr node_type tag = node_type::jmp;
+
+            symbol label;
 
-            explicit jmp(std::string branch)
-                : instruction(node_type::jmp),
-                  label(std::move(branch)) {}
-            ~jmp() override = default;
+            explicit jmp(symbol branch)
+                : label(branch) {}
 
             PRINT_DEF("jmp", label);
             VISITOR_DEF();
@@ -402,59 +351,62 @@ namespace ir {
          *  and then informs the branch of the icmp_type so that it can generate the appropriate
          *  conditional jump instruction.
          */
-        struct icmp : instruction {
+        struct icmp : instruction_base {
+            static constexpr node_type tag = node_type::icmp;
+
             icmp_type type;
 
             explicit icmp(icmp_type type)
-                :   instruction(node_type::icmp), type(type) {}
-            ~icmp() override = default;
+                :   type(type) {}
 
             PRINT_DEF("icmp", icmp_str(type));
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return ir::value_size::i1; }
+            [[nodiscard]] ir::value_size get_return_size() const { return ir::value_size::i1; }
         };
 
         /**
          *  Invokes a subroutine. Will ensure that all parameters specified are stored in the appropriate
          *  stack memory location so that the subroutine can unconditionally reference the parameters it requires.
          */
-        struct call : instruction {
+        struct call : instruction_base {
+            static constexpr node_type tag = node_type::call;
+
             value_size return_size;
-            std::string name;
+            symbol name;
 
-            explicit call(std::string name, value_size return_size)
-                :   instruction(node_type::call), return_size(return_size), name(std::move(name)) {}
-            ~call() override = default;
+            explicit call(symbol name, value_size return_size)
+                :   return_size(return_size), name(name) {}
 
 
             PRINT_DEF("call", return_size, name);
             VISITOR_DEF();
 
-            [[nodiscard]] bool auto_drop_reassignable() const override { return false; }
-            [[nodiscard]] ir::value_size get_return_size() const override { return return_size; }
+            [[nodiscard]] bool auto_drop_reassignable() const { return false; }
+            [[nodiscard]] ir::value_size get_return_size() const { return return_size; }
         };
 
-        struct get_array_ptr : instruction {
+        struct get_array_ptr : instruction_base {
+            static constexpr node_type tag = node_type::get_array_ptr;
+
             value_size element_size;
 
             explicit get_array_ptr(value_size element_size)
-                :   instruction(node_type::get_array_ptr),
-                    element_size(element_size) {}
-            ~get_array_ptr() override = default;
+                :   element_size(element_size) {}
 
             PRINT_DEF("get_array_ptr", element_size);
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return ir::value_size::ptr; }
+            [[nodiscard]] ir::value_size get_return_size() const { return ir::value_size::ptr; }
         };
 
         /**
          *  Returns from a subroutine back to the callee.
          */
-        struct ret : instruction {
-            ret() : instruction(node_type::ret) {}
-            ~ret() override = default;
+        struct ret : instruction_base {
+            static constexpr node_type tag = node_type::ret;
+
+            ret() = default;
 
             PRINT_DEF("ret");
             VISITOR_DEF();
@@ -482,17 +434,18 @@ namespace ir {
          *  Represents a arithmetic command, which for now is limited
          *  to addition, subtraction, and multiplication.
          */
-        struct arithmetic : instruction {
+        struct arithmetic : instruction_base {
+            static constexpr node_type tag = node_type::arithmetic;
+
             arithmetic_type type;
 
             explicit arithmetic(arithmetic_type type)
-                :   instruction(node_type::arithmetic), type(type) {}
-            ~arithmetic() override = default;
+                :   type(type) {}
 
             PRINT_DEF(arithmetic_name(type));
             VISITOR_DEF();
 
-            [[nodiscard]] bool auto_drop_reassignable() const override { return false; }
+            [[nodiscard]] bool auto_drop_reassignable() const { return false; }
         };
 
         /**
@@ -503,22 +456,22 @@ namespace ir {
          *
          *  Requires that the amount of provided operands equals the amount of labels.
          */
-        struct phi : instruction {
-            std::vector<std::string> labels;
+        struct phi : instruction_base {
+            static constexpr node_type tag = node_type::phi;
+
+            label_list labels;
 
-            explicit phi(std::vector<std::string> labels)
-                : instruction(node_type::phi),
-                  labels(std::move(labels)) {}
-            explicit phi(std::string branch1, std::string branch2)
-                : instruction(node_type::phi),
-                  labels {std::move(branch1), std::move(branch2) } {}
-            ~phi() override = default;
+            explicit phi(label_list labels)
+                : labels(std::move(labels)) {}
+            // Reversed like branch's, for the order the parser's arguments are evaluated in
+            explicit phi(symbol second, symbol first)
+                : labels { first, second } {}
 
-            void print(std::ostream &ostream) const override {
-                __inst_print(ostream, "phi");
+            void print(std::ostream &ostream, const symbol_table &symbols) const {
+                __inst_print(ostream, symbols, "phi");
 
                 for (const auto &branch : labels) {
-                    ostream << " " << branch;
+                    ostream << " " << symbols.name(branch);
                 }
             };
 
@@ -530,72 +483,171 @@ namespace ir {
          *  is the condition, if true the second operand is stored in the value, else
          *  the third operand is.
          */
-        struct select : instruction {
-            select() : instruction(node_type::select) {};
-            ~select() override = default;
+        struct select : instruction_base {
+            static constexpr node_type tag = node_type::select;
+
+            select() = default;
 
             PRINT_DEF("select");
             VISITOR_DEF();
 
-            [[nodiscard]] bool auto_drop_reassignable() const override { return false; }
+            [[nodiscard]] bool auto_drop_reassignable() const { return false; }
         };
 
-        struct sext : instruction {
+        struct sext : instruction_base {
+            static constexpr node_type tag = node_type::sext;
+
             value_size new_size;
 
-            explicit sext(value_size new_size) : instruction(node_type::sext), new_size(new_size) {}
-            ~sext() override = default;
+            explicit sext(value_size new_size) : new_size(new_size) {}
 
             PRINT_DEF("sext", ir::value_size_str(new_size));
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return new_size; }
+            [[nodiscard]] ir::value_size get_return_size() const { return new_size; }
         };
 
-        struct zext : instruction {
+        struct zext : instruction_base {
+            static constexpr node_type tag = node_type::zext;
+
             value_size new_size;
 
-            explicit zext(value_size new_size) : instruction(node_type::zext), new_size(new_size) {}
-            ~zext() override = default;
+            explicit zext(value_size new_size) : new_size(new_size) {}
 
             PRINT_DEF("zext", ir::value_size_str(new_size));
             VISITOR_DEF();
 
-            [[nodiscard]] ir::value_size get_return_size() const override { return new_size; }
+            [[nodiscard]] ir::value_size get_return_size() const { return new_size; }
+        };
+
+        /**
+         *  Any one instruction. The alternatives are listed in node_type order,
+         *  so the index of the variant is the tag of the instruction it holds.
+         */
+        using instruction = std::variant<
+            literal, allocate, store, load,
+            branch, jmp, icmp,
+            call, ret,
+            arithmetic, phi, select,
+            sext, zext,
+            get_array_ptr
+        >;
+
+        template <size_t... tags>
+        consteval bool instruction_tags_match(std::index_sequence<tags...>) {
+            return ((std::variant_alternative_t<tags, instruction>::tag == static_cast<node_type>(tags)) && ...);
+        }
+
+        static_assert(instruction_tags_match(std::make_index_sequence<std::variant_size_v<instruction>>()),
+                      "instruction alternatives must be in node_type order");
+
+        /**
+         *  Container struct for an instruction. The instruction, its operands
+         *  and the labels it references are all held inline, so a block's
+         *  instructions live in one contiguous allocation, and an instruction
+         *  only allocates when it has more operands or labels than fit inline.
+         */
+        struct block_instruction : node {
+            instruction inst;
+            operand_list operands;
+            std::optional<variable> assigned_to;
+            label_list labels_referenced;
+
+            backend::md::instruction_metadata metadata {};
+
+            explicit block_instruction(instruction instruction,
+                                       operand_list operands = {},
+                                       label_list labels_referenced = {})
+                :   inst(std::move(instruction)),
+                    operands(std::move(operands)),
+                    labels_referenced(std::move(labels_referenced)) {
+
+            }
+
+            [[nodiscard]] node_type type() const {
+                return static_cast<node_type>(inst.index());
+            }
+
+            [[nodiscard]] bool auto_drop_reassignable() const {
+                return std::visit([](const auto &arg) { return arg.auto_drop_reassignable(); }, inst);
+            }
+
+            [[nodiscard]] ir::value_size get_return_size() const {
+                return std::visit([](const auto &arg) { return arg.get_return_size(); }, inst);
+            }
+
+            block_instruction&& add_operand(value operand) {
+                operands.push_back(operand);
+                return std::move(*this);
+            }
+
+            block_instruction&& set_operands(operand_list new_operands) {
+                this->operands = std::move(new_operands);
+                return std::move(*this);
+            }
+
+            block_instruction&& finalize() {
+                if (assigned_to == std::nullopt)
+                    return std::move(*this);
+
+                const auto size = get_return_size();
+                debug::assert(size != ir::value_size::none, "instruction with no return size assigned to variable");
+
+                if (size == ir::value_size::param_dependent) {
+                    debug::assert(!operands.empty(), "param dependent size with multiple operands");
+
+                    assigned_to->size = operands.back().get_size();
+                }
+
+                return std::move(*this);
+            }
+
+            void print(std::ostream &ostream, const symbol_table &symbols) const;
+        };
+
+        /**
+         *  The organizational unit of a function body. Essentially represents
+         *  a local label within a subroutine in assembly.
+         */
+        struct block : node {
+            symbol name;
+            std::vector<block_instruction> instructions {};
+
+            explicit block(symbol name) : name(name), instructions() {};
         };
 
         auto node_visit(const block_instruction &inst, auto fn) {
-            switch (inst.inst->type) {
+            switch (inst.type()) {
                 case node_type::literal:
-                    return fn(dynamic_cast<literal&>(*inst.inst));
+                    return fn(*std::get_if<literal>(&inst.inst));
                 case node_type::allocate:
-                    return fn(dynamic_cast<allocate&>(*inst.inst));
+                    return fn(*std::get_if<allocate>(&inst.inst));
                 case node_type::store:
-                    return fn(dynamic_cast<store&>(*inst.inst));
+                    return fn(*std::get_if<store>(&inst.inst));
                 case node_type::load:
-                    return fn(dynamic_cast<load&>(*inst.inst));
+                    return fn(*std::get_if<load>(&inst.inst));
                 case node_type::branch:
-                    return fn(dynamic_cast<branch&>(*inst.inst));
+                    return fn(*std::get_if<branch>(&inst.inst));
                 case node_type::jmp:
-                    return fn(dynamic_cast<jmp&>(*inst.inst));
+                    return fn(*std::get_if<jmp>(&inst.inst));
                 case node_type::icmp:
-                    return fn(dynamic_cast<icmp&>(*inst.inst));
+                    return fn(*std::get_if<icmp>(&inst.inst));
                 case node_type::call:
-                    return fn(dynamic_cast<call&>(*inst.inst));
+                    return fn(*std::get_if<call>(&inst.inst));
                 case node_type::ret:
-                    return fn(dynamic_cast<ret&>(*inst.inst));
+                    return fn(*std::get_if<ret>(&inst.inst));
                 case node_type::arithmetic:
-                    return fn(dynamic_cast<arithmetic&>(*inst.inst));
+                    return fn(*std::get_if<arithmetic>(&inst.inst));
                 case node_type::phi:
-                    return fn(dynamic_cast<phi&>(*inst.inst));
+                    return fn(*std::get_if<phi>(&inst.inst));
                 case node_type::select:
-                    return fn(dynamic_cast<select&>(*inst.inst));
+                    return fn(*std::get_if<select>(&inst.inst));
                 case node_type::sext:
-                    return fn(dynamic_cast<sext&>(*inst.inst));
+                    return fn(*std::get_if<sext>(&inst.inst));
                 case node_type::zext:
-                    return fn(dynamic_cast<zext&>(*inst.inst));
+                    return fn(*std::get_if<zext>(&inst.inst));
                 case node_type::get_array_ptr:
-                    return fn(dynamic_cast<get_array_ptr&>(*inst.inst));
+                    return fn(*std::get_if<get_array_ptr>(&inst.inst));
             }
 
             throw std::runtime_error("no such instruction type");
@@ -616,19 +668,27 @@ namespace ir {
 
         struct extern_function : global_node {
             std::string name;
+            symbol_table symbols;
             std::vector<variable> parameters;
             value_size return_type;
 
             explicit extern_function(std::string name,
+                                     symbol_table symbols,
                                      std::vector<variable> parameters,
                                      value_size return_type)
                 : name(std::move(name)),
+                  symbols(std::move(symbols)),
                   parameters(std::move(parameters)),
                   return_type(return_type) {}
         };
 
+        /**
+         *  Owns the symbol table its variables, labels and callees are interned in,
+         *  so every symbol within a function is dense and unique to it.
+         */
         struct function : global_node {
             std::string name;
+            symbol_table symbols;
             std::vector<variable> parameters;
             std::vector<block::block> blocks;
             value_size return_type;
@@ -636,10 +696,12 @@ namespace ir {
             std::unique_ptr<backend::md::function_metadata> metadata = nullptr;
 
             explicit function(std::string name,
+                              symbol_table symbols,
                               std::vector<variable> parameters,
                               std::vector<block::block> blocks,
                               value_size return_type)
                 :   name(std::move(name)),
+                    symbols(std::move(symbols)),
                     parameters(std::move(parameters)),
                     blocks(std::move(blocks)),
                     return_type(return_type) {}
@@ -27,7 +27,7 @@ void ir::output::emit_external_function(std::ostream &ostream, const ir::global:
         << "extern fn void "
         << extern_function.name;
 
-    emit_parameters(ostream, extern_function.parameters);
+    emit_parameters(ostream, extern_function.symbols, extern_function.parameters);
 }
 
 void ir::output::emit_function(std::ostream &ostream, const ir::global::function &function) {
@@ -35,7 +35,7 @@ void ir::output::emit_function(std::ostream &ostream, const ir::global::function
         << "define fn " << value_size_str(function.return_type) << " "
         << function.name;
 
-    emit_parameters(ostream, function.parameters);
+    emit_parameters(ostream, function.symbols, function.parameters);
 
     ostream << "\n";
 
@@ -43,20 +43,20 @@ void ir::output::emit_function(std::ostream &ostream, const ir::global::function
         if (block.instructions.empty())
             continue;
 
-        ostream << "." << block.name << ":\n";
+        ostream << "." << function.symbols.name(block.name) << ":\n";
 
         for (const auto &inst : block.instructions) {
             if (ir::output::instruction_emitter_attachment) {
                 std::stringstream ss;
-                inst.print(ss);
+                inst.print(ss, function.symbols);
 
                 ostream << std::left << std::setw(40) << ss.str();
 
-                ir::output::instruction_emitter_attachment(ostream, inst);
+                ir::output::instruction_emitter_attachment(ostream, function.symbols, inst);
 
                 ostream << std::endl;
             } else {
-                inst.print(ostream);
+                inst.print(ostream, function.symbols);
                 ostream << '\n';
             }
         }
@@ -65,11 +65,12 @@ void ir::output::emit_function(std::ostream &ostream, const ir::global::function
     ostream << "end";
 }
 
-void ir::output::emit_parameters(std::ostream &ostream, const std::vector<ir::variable> &params) {
+void ir::output::emit_parameters(std::ostream &ostream, const ir::symbol_table &symbols,
+                                 const std::vector<ir::variable> &params) {
     ostream << "(";
 
     for (size_t i = 0; i < params.size(); i++) {
-        params[i].print(ostream);
+        params[i].print(ostream, symbols);
 
         if (i + 1 < params.size())
             ostream << ", ";
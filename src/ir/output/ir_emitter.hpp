@@ -9,7 +9,7 @@
 
 namespace ir::output {
     template <typename T>
-    using emitter_attachment = void(*)(std::ostream&, const T&);
+    using emitter_attachment = void(*)(std::ostream&, const ir::symbol_table&, const T&);
 
     inline emitter_attachment<ir::block::block_instruction> instruction_emitter_attachment = nullptr;
 
@@ -19,5 +19,5 @@ namespace ir::output {
     void emit_external_function(std::ostream &ostream, const ir::global::extern_function &extern_function);
     void emit_global_string(std::ostream &ostream, const ir::global::global_string &global_string);
 
-    void emit_parameters(std::ostream &ostream, const std::vector<ir::variable> &params);
+    void emit_parameters(std::ostream &ostream, const ir::symbol_table &symbols, const std::vector<ir::variable> &params);
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ir {
+    /**
+     *  A vector which keeps up to @N elements inside itself, only allocating once it
+     *  grows past them. Used for the small lists every IR instruction carries (operands,
+     *  referenced labels), so that storing an instruction by value in its block does not
+     *  require any further allocations in the common case.
+     *
+     *  Elements are relocated bytewise, so @T has to be trivially copyable.
+     */
+    template <typename T, uint32_t N>
+    class small_vector {
+        static_assert(std::is_trivially_copyable_v<T>, "small_vector relocates elements bytewise");
+
+        alignas(T) std::byte buffer[N * sizeof(T)];
+        T *heap = nullptr;
+        uint32_t count = 0;
+        uint32_t capacity = N;
+
+        void grow(uint32_t min_capacity) {
+            const auto new_capacity = std::max(min_capacity, capacity * 2);
+            auto *new_heap = std::allocator<T>().allocate(new_capacity);
+
+            std::memcpy(static_cast<void*>(new_heap), data(), count * sizeof(T));
+            release();
+
+            heap = new_heap;
+            capacity = new_capacity;
+        }
+
+        void release() {
+            if (heap)
+                std::allocator<T>().deallocate(heap, capacity);
+
+            heap = nullptr;
+            capacity = N;
+        }
+
+        void copy_from(const small_vector &other) {
+            if (other.count > capacity)
+                grow(other.count);
+
+            std::memcpy(static_cast<void*>(data()), other.data(), other.count * sizeof(T));
+            count = other.count;
+        }
+
+        void move_from(small_vector &other) {
+            if (other.heap) {
+                heap = std::exchange(other.heap, nullptr);
+                capacity = std::exchange(other.capacity, N);
+            } else {
+                std::memcpy(static_cast<void*>(buffer), other.buffer, other.count * sizeof(T));
+            }
+
+            count = std::exchange(other.count, 0);
+        }
+
+    public:
+        using value_type = T;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        small_vector() = default;
+
+        small_vector(std::initializer_list<T> elements) {
+            for (const auto &element : elements)
+                push_back(element);
+        }
+
+        small_vector(const small_vector &other) { copy_from(other); }
+        small_vector(small_vector &&other) noexcept { move_from(other); }
+
+        small_vector &operator =(const small_vector &other) {
+            if (this != &other) {
+                count = 0;
+                copy_from(other);
+            }
+
+            return *this;
+        }
+
+        small_vector &operator =(small_vector &&other) noexcept {
+            if (this != &other) {
+                release();
+                move_from(other);
+            }
+
+            return *this;
+        }
+
+        ~small_vector() { release(); }
+
+        [[nodiscard]] T *data() { return heap ? heap : reinterpret_cast<T*>(buffer); }
+        [[nodiscard]] const T *data() const { return heap ? heap : reinterpret_cast<const T*>(buffer); }
+
+        [[nodiscard]] size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+
+        [[nodiscard]] iterator begin() { return data(); }
+        [[nodiscard]] iterator end() { return data() + count; }
+        [[nodiscard]] const_iterator begin() const { return data(); }
+        [[nodiscard]] const_iterator end() const { return data() + count; }
+
+        [[nodiscard]] T &operator [](size_t i) { return data()[i]; }
+        [[nodiscard]] const T &operator [](size_t i) const { return data()[i]; }
+
+        [[nodiscard]] T &front() { return data()[0]; }
+        [[nodiscard]] const T &front() const { return data()[0]; }
+        [[nodiscard]] T &back() { return data()[count - 1]; }
+        [[nodiscard]] const T &back() const { return data()[count - 1]; }
+
+        void reserve(size_t new_capacity) {
+            if (new_capacity > capacity)
+                grow(static_cast<uint32_t>(new_capacity));
+        }
+
+        template <typename... Args>
+        T &emplace_back(Args&&... args) {
+            // Constructed before growing, as the arguments may refer to an element
+            T element(std::forward<Args>(args)...);
+
+            if (count == capacity)
+                grow(count + 1);
+
+            return *new (data() + count++) T(element);
+        }
+
+        void push_back(const T &element) { emplace_back(element); }
+        void pop_back() { count--; }
+        void clear() { count = 0; }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            auto *position = data() + (first - data());
+            const auto removed = last - first;
+
+            std::memmove(static_cast<void*>(position), last, (end() - last) * sizeof(T));
+            count -= static_cast<uint32_t>(removed);
+
+            return position;
+        }
+
+        iterator erase(const_iterator position) { return erase(position, position + 1); }
+    };
+}
@@ -0,0 +1,97 @@
+#include "symbol_table.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace {
+    // Most functions only have a handful of short names, so blocks start small and double
+    constexpr size_t min_text_block = 64;
+    constexpr size_t max_text_block_doublings = 6;
+    constexpr size_t min_slots = 8;
+}
+
+ir::symbol_table &ir::symbol_table::operator =(ir::symbol_table &&other) noexcept {
+    names = std::move(other.names);
+    slots = std::move(other.slots);
+    text_blocks = std::move(other.text_blocks);
+
+    // The block the cursor points into now belongs to this table
+    text_cursor = std::exchange(other.text_cursor, nullptr);
+    text_remaining = std::exchange(other.text_remaining, 0);
+
+    return *this;
+}
+
+ir::symbol ir::symbol_table::intern(std::string_view name) {
+    // Keep the load factor at or below a half
+    if ((names.size() + 1) * 2 > slots.size())
+        rehash(std::max(min_slots, slots.size() * 2));
+
+    const auto slot = find_slot(name);
+
+    if (slots[slot] != no_symbol)
+        return symbol { slots[slot] };
+
+    const auto id = static_cast<symbol_id>(names.size());
+
+    names.emplace_back(store_text(name));
+    slots[slot] = id;
+
+    return symbol { id };
+}
+
+std::optional<ir::symbol> ir::symbol_table::find(std::string_view name) const {
+    if (slots.empty())
+        return std::nullopt;
+
+    const auto id = slots[find_slot(name)];
+
+    if (id == no_symbol)
+        return std::nullopt;
+
+    return symbol { id };
+}
+
+size_t ir::symbol_table::find_slot(std::string_view name) const {
+    const size_t mask = slots.size() - 1;
+    size_t slot = std::hash<std::string_view> {}(name) & mask;
+
+    while (slots[slot] != no_symbol && names[slots[slot]] != name)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+std::string_view ir::symbol_table::store_text(std::string_view name) {
+    if (name.empty())
+        return {};
+
+    if (name.size() > text_remaining) {
+        const auto block_size = std::max(min_text_block << std::min(text_blocks.size(), max_text_block_doublings), name.size());
+
+        text_blocks.emplace_back(std::make_unique_for_overwrite<char[]>(block_size));
+        text_cursor = text_blocks.back().get();
+        text_remaining = block_size;
+    }
+
+    std::memcpy(text_cursor, name.data(), name.size());
+
+    const std::string_view stored { text_cursor, name.size() };
+
+    text_cursor += name.size();
+    text_remaining -= name.size();
+
+    return stored;
+}
+
+void ir::symbol_table::rehash(size_t slot_count) {
+    slots.assign(slot_count, no_symbol);
+
+    // The slots bound the number of names, so grow both together
+    names.reserve(slot_count / 2);
+
+    for (symbol_id id = 0; id < names.size(); id++)
+        slots[find_slot(names[id])] = id;
+}
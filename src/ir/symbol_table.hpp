@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ir {
+    using symbol_id = uint32_t;
+
+    inline constexpr symbol_id no_symbol = std::numeric_limits<symbol_id>::max();
+
+    /**
+     *  An interned name, dense from zero within the table it was interned in so
+     *  it can index flat vectors. The text is only kept by the table.
+     */
+    struct symbol {
+        symbol_id id = no_symbol;
+
+        bool operator ==(const symbol &other) const = default;
+    };
+
+    /**
+     *  Owns the text of every name interned into it. Variables and labels are scoped
+     *  to a function, so each function has its own table and ids stay small enough to
+     *  size per function vectors by.
+     *
+     *  Text is copied into blocks which never move, so moving the table (and with it
+     *  the function owning it) is as cheap as moving its vectors.
+     */
+    struct symbol_table {
+        std::vector<std::string_view> names;
+
+        // Open addressed by the hash of the name, empty slots hold no_symbol
+        std::vector<symbol_id> slots;
+
+        std::vector<std::unique_ptr<char[]>> text_blocks;
+        char *text_cursor = nullptr;
+        size_t text_remaining = 0;
+
+        symbol_table() = default;
+        symbol_table(symbol_table &&other) noexcept { *this = std::move(other); }
+        symbol_table& operator =(symbol_table &&other) noexcept;
+
+        symbol_table(const symbol_table&) = delete;
+        symbol_table& operator =(const symbol_table&) = delete;
+
+        symbol intern(std::string_view name);
+        [[nodiscard]] std::optional<symbol> find(std::string_view name) const;
+
+        [[nodiscard]] std::string_view name(symbol symbol) const { return names[symbol.id]; }
+        [[nodiscard]] std::string_view name(symbol_id id) const { return names[id]; }
+        [[nodiscard]] size_t size() const { return names.size(); }
+
+    private:
+        [[nodiscard]] size_t find_slot(std::string_view name) const;
+        std::string_view store_text(std::string_view name);
+        void rehash(size_t slot_count);
+    };
+}
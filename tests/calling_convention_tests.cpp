@@ -0,0 +1,148 @@
+/// Idea: Generated functions follow the System V ABI, they only save the callee saved registers
+/// they modify, keep values needed after a call out of the caller saved registers, and pass
+/// arguments after the sixth on the stack with rsp 16 byte aligned at the call
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+#include "../src/backend/interface.hpp"
+
+std::string compile_source(const std::string &input, backend::regalloc_mode mode) {
+    auto tokens = ir::lexer::lex(input);
+    auto root = ir::parser::parse(tokens);
+
+    std::stringstream output;
+    backend::compile(root, output, backend::compile_options { .regalloc = mode });
+
+    return std::move(output).str();
+}
+
+bool names_callee_saved(std::string_view operand) {
+    for (auto reg : backend::context::callee_saved) {
+        for (auto size : { ir::value_size::i32, ir::value_size::i64 }) {
+            if (operand == backend::context::register_as_string(reg, size))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void test_only_callee_saved_pushed(const std::string &assembly) {
+    std::istringstream lines { assembly };
+    std::string line;
+
+    while (std::getline(lines, line)) {
+        if (!line.starts_with("\tpush") && !line.starts_with("\tpop"))
+            continue;
+
+        const auto reg = line.substr(line.find_last_of(' ') + 1);
+
+        debug::assert(reg == "rbp" || names_callee_saved(reg),
+                      std::string("calling_convention_test: caller saved register saved, ").append(line).c_str());
+    }
+}
+
+// %x is computed into the argument register it came in and still needed after calling g
+void test_value_survives_call(backend::regalloc_mode mode) {
+    const auto assembly = compile_source(
+        "extern fn i32 g(i32 %x)\n\n"
+        "define fn i32 main(i32 %a)\n"
+        "    %x = add i32 %a, i32 1\n"
+        "    %c = call i32 g i32 2\n"
+        "    %r = add i32 %c, i32 %x\n"
+        "    ret i32 %r\n"
+        "end\n", mode);
+
+    test_only_callee_saved_pushed(assembly);
+
+    const auto last_add = assembly.rfind("\tadd");
+    const auto line = assembly.substr(last_add, assembly.find('\n', last_add) - last_add);
+    const auto operand = line.substr(line.find_last_of(' ') + 1);
+
+    debug::assert(names_callee_saved(operand) || line.ends_with(']'),
+                  "calling_convention_test: value live across a call left in a caller saved register");
+}
+
+// Instructions from the label of @function up to its first ret
+std::vector<std::string> function_lines(const std::string &assembly, std::string_view function) {
+    std::istringstream lines { assembly.substr(assembly.find(std::string(function).append(":\n"))) };
+    std::vector<std::string> result;
+    std::string line;
+
+    while (std::getline(lines, line)) {
+        if (!line.starts_with('\t'))
+            continue;
+
+        result.push_back(line.substr(1));
+
+        if (line.starts_with("\tret"))
+            break;
+    }
+
+    return result;
+}
+
+// Tracks rsp through the caller and checks it is 16 byte aligned at each call
+void test_stack_arguments(backend::regalloc_mode mode) {
+    std::stringstream output;
+    backend::compile("../examples/stack_args_test.ir", output, backend::compile_options { .regalloc = mode });
+
+    const auto assembly = output.str();
+
+    // The return address leaves rsp 8 bytes off alignment on entry
+    int64_t offset = 8;
+    size_t calls = 0;
+
+    for (const auto &line : function_lines(assembly, "main")) {
+        const auto amount = [&]() { return std::stoll(line.substr(line.find_last_of(' ') + 1)); };
+
+        if (line.starts_with("push"))
+            offset += 8;
+        else if (line.starts_with("pop"))
+            offset -= 8;
+        else if (line.starts_with("sub") && line.find("rsp,") != std::string::npos)
+            offset += amount();
+        else if (line.starts_with("add") && line.find("rsp,") != std::string::npos)
+            offset -= amount();
+        else if (line.starts_with("call")) {
+            debug::assert(offset % 16 == 0, "calling_convention_test: rsp misaligned at a call");
+            calls++;
+        }
+    }
+
+    debug::assert(calls == 2, "calling_convention_test: expected both calls in main");
+
+    const auto reads = [&](std::string_view function, std::string_view operand) {
+        const auto lines = function_lines(assembly, function);
+
+        return std::any_of(lines.begin(), lines.end(), [&](const std::string &line) {
+            return line.find(operand) != std::string::npos;
+        });
+    };
+
+    for (const auto *callee : { "sum8", "sum7" }) {
+        debug::assert(reads(callee, "r9d"), "calling_convention_test: sixth argument not read from r9");
+        debug::assert(reads(callee, "[rbp + 16]"), "calling_convention_test: seventh argument not read from the stack");
+    }
+
+    debug::assert(reads("sum8", "[rbp + 24]"), "calling_convention_test: eighth argument not read from the stack");
+}
+
+void run_calling_convention_tests() {
+    for (auto mode : { backend::regalloc_mode::greedy, backend::regalloc_mode::linear, backend::regalloc_mode::coloring }) {
+        std::stringstream output;
+        backend::compile("../examples/fibonacci.ir", output, backend::compile_options { .regalloc = mode });
+
+        test_only_callee_saved_pushed(output.str());
+        test_value_survives_call(mode);
+        test_stack_arguments(mode);
+    }
+
+    std::cout << "Calling Convention Tests Passed" << '\n';
+}
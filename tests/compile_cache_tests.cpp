@@ -0,0 +1,84 @@
+/// Idea: Functions found in the compile cache produce the same assembly as compiling them,
+/// the cache persists between instances, and it evicts the least recently used entries
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/compile_cache.hpp"
+#include "../src/backend/interface.hpp"
+
+std::filesystem::path fresh_cache_directory(std::string_view name) {
+    auto directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+
+    return directory;
+}
+
+std::string compile_with_cache(const char *file_path, backend::compile_cache *cache) {
+    auto root = backend::gen_ast(file_path);
+
+    std::stringstream output;
+    backend::compile(root, output, backend::compile_options { .cache = cache });
+
+    return std::move(output).str();
+}
+
+void test_cached_output_matches() {
+    const auto directory = fresh_cache_directory("compile_cache_test");
+    const auto expected = compile_with_cache("../examples/fibonacci.ir", nullptr);
+
+    {
+        backend::compile_cache cache { directory, 1024 * 1024 };
+
+        debug::assert(compile_with_cache("../examples/fibonacci.ir", &cache) == expected,
+                      "compile_cache_test: output changed by an empty cache");
+        debug::assert(cache.statistics().misses == 2 && cache.statistics().stores == 2,
+                      "compile_cache_test: functions not added to the cache");
+
+        debug::assert(compile_with_cache("../examples/fibonacci.ir", &cache) == expected,
+                      "compile_cache_test: cached output differs");
+        debug::assert(cache.statistics().hits == 2, "compile_cache_test: functions not served from the cache");
+    }
+
+    backend::compile_cache reopened { directory, 1024 * 1024 };
+
+    debug::assert(compile_with_cache("../examples/fibonacci.ir", &reopened) == expected,
+                  "compile_cache_test: output differs after reopening the cache");
+    debug::assert(reopened.statistics().hits == 2 && reopened.statistics().misses == 0,
+                  "compile_cache_test: cache not persisted");
+
+    auto root = backend::gen_ast("../examples/fibonacci.ir");
+    debug::assert(backend::compile_cache::key(root.functions[0], {})
+                  != backend::compile_cache::key(root.functions[0], { .regalloc = backend::regalloc_mode::linear }),
+                  "compile_cache_test: options not part of the key");
+
+    std::filesystem::remove_all(directory);
+}
+
+void test_least_recently_used_evicted() {
+    const auto directory = fresh_cache_directory("compile_cache_lru_test");
+    backend::compile_cache cache { directory, 25 };
+
+    cache.store("a", "0123456789");
+    cache.store("b", "0123456789");
+
+    // Makes b the least recently used entry
+    debug::assert(cache.find("a").has_value(), "compile_cache_test: stored entry missing");
+
+    cache.store("c", "0123456789");
+
+    debug::assert(cache.statistics().evictions == 1, "compile_cache_test: expected a single eviction");
+    debug::assert(!cache.find("b") && cache.find("a") && cache.find("c"), "compile_cache_test: wrong entry evicted");
+    debug::assert(cache.size_in_bytes() == 20, "compile_cache_test: evicted entry still counted");
+
+    std::filesystem::remove_all(directory);
+}
+
+void run_compile_cache_tests() {
+    test_cached_output_matches();
+    test_least_recently_used_evicted();
+
+    std::cout << "Compile Cache Tests Passed" << '\n';
+}
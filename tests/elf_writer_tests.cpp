@@ -0,0 +1,81 @@
+/// Idea: Compiled objects are valid ELF64 relocatables which export the module's functions,
+/// leave extern functions undefined and relocate calls and global string references
+
+#include <elf.h>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/interface.hpp"
+
+template <typename T>
+T read_elf(const std::string &object, size_t offset) {
+    debug::assert(offset + sizeof(T) <= object.size(), "elf_writer_test: read past the end of the object");
+
+    T value;
+    std::memcpy(&value, object.data() + offset, sizeof(T));
+    return value;
+}
+
+void test_hello_world_object() {
+    auto root = backend::gen_ast("../examples/hello_world.ir");
+
+    std::stringstream output;
+    backend::compile_object(root, output);
+
+    const auto object = std::move(output).str();
+    const auto header = read_elf<Elf64_Ehdr>(object, 0);
+
+    debug::assert(std::memcmp(header.e_ident, ELFMAG, SELFMAG) == 0, "elf_writer_test: missing ELF magic");
+    debug::assert(header.e_ident[EI_CLASS] == ELFCLASS64 && header.e_type == ET_REL && header.e_machine == EM_X86_64,
+                  "elf_writer_test: not an x86-64 relocatable object");
+
+    const auto section = [&](size_t index) {
+        return read_elf<Elf64_Shdr>(object, header.e_shoff + index * sizeof(Elf64_Shdr));
+    };
+
+    const auto section_names = section(header.e_shstrndx);
+
+    bool found_main = false, found_puts = false;
+    size_t relocations = 0;
+
+    for (size_t i = 0; i < header.e_shnum; i++) {
+        const auto current = section(i);
+        const std::string_view name { object.data() + section_names.sh_offset + current.sh_name };
+
+        if (current.sh_type == SHT_RELA) {
+            debug::assert(name == ".rela.text", "elf_writer_test: relocations for an unexpected section");
+            relocations = current.sh_size / sizeof(Elf64_Rela);
+        }
+
+        if (current.sh_type != SHT_SYMTAB)
+            continue;
+
+        const auto strings = section(current.sh_link);
+
+        for (size_t s = 0; s < current.sh_size / sizeof(Elf64_Sym); s++) {
+            const auto symbol = read_elf<Elf64_Sym>(object, current.sh_offset + s * sizeof(Elf64_Sym));
+            const std::string_view symbol_name { object.data() + strings.sh_offset + symbol.st_name };
+
+            if (symbol_name == "main") {
+                found_main = ELF64_ST_BIND(symbol.st_info) == STB_GLOBAL && ELF64_ST_TYPE(symbol.st_info) == STT_FUNC;
+                debug::assert(s >= current.sh_info, "elf_writer_test: global symbol among the local ones");
+            }
+
+            if (symbol_name == "puts")
+                found_puts = symbol.st_shndx == SHN_UNDEF;
+        }
+    }
+
+    debug::assert(found_main, "elf_writer_test: main not exported as a function");
+    debug::assert(found_puts, "elf_writer_test: puts not left undefined");
+    debug::assert(relocations == 2, "elf_writer_test: expected relocations for msg and puts");
+}
+
+void run_elf_writer_tests() {
+    test_hello_world_object();
+
+    std::cout << "ELF Writer Tests Passed" << '\n';
+}
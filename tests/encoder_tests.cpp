@@ -0,0 +1,128 @@
+/// Idea: The binary encoder produces the same instructions the assembler would for the printed
+/// assembly, keeps branches in their short form unless the target is out of reach, and leaves
+/// calls and global references as relocations
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+#include "../src/backend/interface.hpp"
+
+const backend::as::encoded_function &find_encoded(const backend::as::encoded_module &module, std::string_view name) {
+    const auto function = std::find_if(module.functions.begin(), module.functions.end(), [&](const auto &function) {
+        return function.name == name;
+    });
+
+    debug::assert(function != module.functions.end(), "encoder_test: function not found");
+    return *function;
+}
+
+// Checked against objdump's disassembly of the bytes and the printed assembly of fib
+void test_encodes_fib() {
+    auto root = backend::gen_ast("../examples/fibonacci.ir");
+    const auto module = backend::assemble(root);
+    const auto &fib = find_encoded(module, "fib");
+
+    const std::vector<uint8_t> expected {
+        0x83, 0xFF, 0x01,                   // cmp edi, 1
+        0x76, 0x02,                         // jbe .base_case
+        0xEB, 0x03,                         // jmp .recursive_case
+        0x89, 0xF8,                         // mov eax, edi
+        0xC3,                               // ret
+        0x53,                               // push rbx
+        0x41, 0x54,                         // push r12
+        0x48, 0x83, 0xEC, 0x08,             // sub rsp, 8
+        0x83, 0xEF, 0x01,                   // sub edi, 1
+        0x89, 0xFB,                         // mov ebx, edi
+        0x89, 0xDF,                         // mov edi, ebx
+        0x48, 0x31, 0xC0,                   // xor rax, rax
+        0xE8, 0x00, 0x00, 0x00, 0x00,       // call fib
+        0x83, 0xEB, 0x01,                   // sub ebx, 1
+        0x41, 0x89, 0xC4,                   // mov r12d, eax
+        0x89, 0xDF,                         // mov edi, ebx
+        0x48, 0x31, 0xC0,                   // xor rax, rax
+        0xE8, 0x00, 0x00, 0x00, 0x00,       // call fib
+        0x44, 0x01, 0xE0,                   // add eax, r12d
+        0x48, 0x83, 0xC4, 0x08,             // add rsp, 8
+        0x41, 0x5C,                         // pop r12
+        0x5B,                               // pop rbx
+        0xC3,                               // ret
+    };
+
+    debug::assert(fib.code == expected, "encoder_test: fib encoded differently");
+}
+
+void test_relocations() {
+    auto root = backend::gen_ast("../examples/hello_world.ir");
+    const auto module = backend::assemble(root);
+    const auto &main = find_encoded(module, "main");
+
+    debug::assert(module.data.size() == 1 && module.data[0].name == "msg", "encoder_test: global string missing");
+    debug::assert(module.data[0].bytes.size() == 14 && module.data[0].bytes.back() == 0, "encoder_test: global string not null terminated");
+    debug::assert(module.external_functions == std::vector<std::string> { "puts" }, "encoder_test: extern function missing");
+
+    debug::assert(main.relocations.size() == 2, "encoder_test: expected a relocation for msg and puts");
+
+    for (const auto &relocation : main.relocations) {
+        for (size_t i = 0; i < 4; i++)
+            debug::assert(main.code[relocation.offset + i] == 0, "encoder_test: relocated field not left empty");
+
+        debug::assert(relocation.addend == -4, "encoder_test: relocation not relative to the end of the instruction");
+
+        if (relocation.symbol == "msg") {
+            debug::assert(relocation.kind == backend::as::relocation_kind::pc_relative_32, "encoder_test: msg not rip relative");
+            debug::assert(main.code[relocation.offset - 3] == 0x48 && main.code[relocation.offset - 2] == 0x8D
+                          && main.code[relocation.offset - 1] == 0x3D, "encoder_test: msg not loaded into rdi with lea");
+        } else {
+            debug::assert(relocation.symbol == "puts", "encoder_test: unexpected relocation");
+            debug::assert(relocation.kind == backend::as::relocation_kind::call_32, "encoder_test: call relocation of the wrong kind");
+            debug::assert(main.code[relocation.offset - 1] == 0xE8, "encoder_test: relocation not on a call");
+        }
+    }
+}
+
+// The jump to .done crosses 30 six byte adds, too far for a rel8
+void test_branch_relaxation() {
+    std::string source = "define fn i32 far(i32 %a)\n"
+                         "    %c = icmp eq i32 %a, i32 0\n"
+                         "    branch long done i1 %c\n"
+                         ".long:\n"
+                         "    %v0 = add i32 %a, i32 1000\n";
+
+    for (int i = 1; i < 30; i++) {
+        source.append("    %v").append(std::to_string(i))
+              .append(" = add i32 %v").append(std::to_string(i - 1)).append(", i32 1000\n");
+    }
+
+    source.append("    ret i32 %v29\n"
+                  ".done:\n"
+                  "    ret i32 %a\n"
+                  "end\n");
+
+    auto tokens = ir::lexer::lex(source);
+    auto root = ir::parser::parse(tokens);
+    const auto module = backend::assemble(root);
+    const auto &code = find_encoded(module, "far").code;
+
+    // cmp edi, 0, then je .long which stays short as .long follows the jmp directly
+    debug::assert(code[3] == 0x74 && code[4] == 0x05, "encoder_test: branch to the next block not kept short");
+    debug::assert(code[5] == 0xE9, "encoder_test: far jump not widened");
+
+    const auto displacement = (int32_t) (code[6] | code[7] << 8 | code[8] << 16 | (uint32_t) code[9] << 24);
+    const auto target = 10 + (size_t) displacement;
+
+    debug::assert(displacement > INT8_MAX, "encoder_test: far jump is within reach of a short one");
+    debug::assert(target < code.size() && code[target - 1] == 0xC3, "encoder_test: far jump does not land after the long block");
+}
+
+void run_encoder_tests() {
+    test_encodes_fib();
+    test_relocations();
+    test_branch_relaxation();
+
+    std::cout << "Encoder Tests Passed" << '\n';
+}
@@ -4,20 +4,40 @@
 
 #include "../src/backend/interface.hpp"
 #include "../src/exec/executor.hpp"
+#include "../src/exec/jit.hpp"
 
 void assert_file_exitcode(const char* file_path, int exit_code) {
+    const auto result = exec::run_jit(file_path);
+
+    if (result != exit_code) {
+        std::stringstream ss;
+        auto ast = backend::gen_ast(file_path);
+        backend::compile(ast, ss);
+
+        std::cerr << "Error in file " << file_path << '\n';
+        std::cerr << "Expected result " << exit_code << " but got " << result << '\n';
+        std::cout << "Received output:\n";
+        std::cout << ss.str();
+        std::exit(1);
+    }
+}
+
+// Goes through an object file and gcc rather than the jit
+void assert_linked_exitcode(const char* file_path, int exit_code) {
     auto ast = backend::gen_ast(file_path);
 
-    std::stringstream ss;
-    std::ofstream output { "../examples/output.asm" };
+    std::ofstream output { "../examples/output.o", std::ios::binary };
 
-    backend::compile(ast, ss);
-    output << ss.str();
+    backend::compile_object(ast, output);
     output.close();
 
-    auto exit = exec::run_once("../examples/output.asm");
+    auto exit = exec::run_once("../examples/output.o");
 
     if (exit != exit_code) {
+        std::stringstream ss;
+        auto printed = backend::gen_ast(file_path);
+        backend::compile(printed, ss);
+
         std::cerr << "Error in file " << file_path << '\n';
         std::cerr << "Expected exit code " << exit_code << " but got " << exit << '\n';
         std::cout << "Received output:\n";
@@ -26,11 +46,37 @@ void assert_file_exitcode(const char* file_path, int exit_code) {
     }
 }
 
+// Functions of a jit module can be called with arguments, and extern functions are resolved
+void test_jit_functions() {
+    auto root = backend::gen_ast("../examples/fibonacci.ir");
+    const exec::jit_module fib_module { backend::assemble(root) };
+
+    auto *fib = fib_module.function<int(int)>("fib");
+    debug::assert(fib && fib(10) == 55 && fib(20) == 6765, "exec_test: jit fib returned the wrong result");
+
+    auto extern_root = backend::gen_ast("../examples/hello_world.ir");
+    const exec::jit_module hello_module { backend::assemble(extern_root) };
+
+    debug::assert(hello_module.find("puts") != nullptr, "exec_test: extern function not resolved");
+    debug::assert(hello_module.find("missing") == nullptr, "exec_test: found a symbol not in the module");
+}
+
 void run_exec_tests() {
     assert_file_exitcode("../examples/arith_select_test.ir", 5);
     assert_file_exitcode("../examples/select_test.ir", 1);
     assert_file_exitcode("../examples/fibonacci.ir", 55);
     assert_file_exitcode("../examples/pointer_test.ir", 2);
+    assert_file_exitcode("../examples/stack_args_test.ir", 64);
+    assert_file_exitcode("../examples/phi_edges.ir", 21);
+
+    // The kernels the generated code benchmark times
+    assert_file_exitcode("../examples/kernels/fib.ir", 46368);
+    assert_file_exitcode("../examples/kernels/array_sum.ir", 1571328);
+    assert_file_exitcode("../examples/kernels/select_clamp.ir", 58372391);
+    assert_file_exitcode("../examples/kernels/call_chain.ir", 1000000);
+
+    assert_linked_exitcode("../examples/fibonacci.ir", 55);
+    test_jit_functions();
 
     std::cout << "All execution tests passed\n";
 }
\ No newline at end of file
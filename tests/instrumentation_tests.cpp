@@ -0,0 +1,112 @@
+/// Idea: Compiling under a profile records every phase of the pipeline and counts what was
+/// generated, and nothing is recorded outside of a profile's scope. Tracing records a span for
+/// every phase and every generated function
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/instrumentation.hpp"
+#include "../src/backend/interface.hpp"
+
+void test_phases_recorded() {
+    using namespace backend::instrument;
+
+    profile recorded;
+    std::stringstream output;
+
+    {
+        profile_scope scope { recorded };
+
+        auto root = backend::gen_ast("../examples/fibonacci.ir");
+        backend::compile(root, output);
+    }
+
+    for (auto which : { phase::lex, phase::parse, phase::codegen, phase::print })
+        debug::assert(recorded.totals(which).calls > 0, "instrumentation_test: phase not recorded");
+
+    // fibonacci.ir defines main and fib
+    debug::assert(recorded.totals(phase::metadata).calls == 2, "instrumentation_test: expected metadata for both functions");
+    debug::assert(recorded.totals(phase::variable_lifetimes).calls == 2, "instrumentation_test: expected lifetimes for both functions");
+    debug::assert(recorded.totals(phase::codegen).calls == 2, "instrumentation_test: expected codegen for both functions");
+
+    if (counts_allocations())
+        debug::assert(recorded.totals(phase::parse).allocations > 0, "instrumentation_test: parsing allocated nothing");
+
+    debug::assert(recorded.value(counter::instructions_in) > 0, "instrumentation_test: no instructions counted");
+    debug::assert(recorded.value(counter::asm_nodes_out) > recorded.value(counter::instructions_in) / 2,
+                  "instrumentation_test: too few asm nodes counted");
+
+    // fib keeps two values in rbx and r12 across its calls
+    debug::assert(recorded.value(counter::registers_pushed) == 2, "instrumentation_test: expected rbx and r12 pushed");
+
+    std::stringstream json;
+    recorded.write_json(json);
+
+    debug::assert(json.str().starts_with("{\"phases\":{\"lex\":{\"calls\":"), "instrumentation_test: unexpected json");
+    debug::assert(json.str().find("\"registers_pushed\":2") != std::string::npos, "instrumentation_test: counter missing from json");
+
+    profile unused;
+    auto root = backend::gen_ast("../examples/fibonacci.ir");
+    backend::compile(root, output);
+
+    debug::assert(unused.totals(phase::codegen).calls == 0 && recorded.totals(phase::codegen).calls == 2,
+                  "instrumentation_test: recorded outside of a profile scope");
+}
+
+void test_trace_recorded() {
+    using namespace backend::instrument;
+
+    trace recorded;
+    std::stringstream output;
+
+    {
+        trace_scope scope { recorded };
+
+        auto root = backend::gen_ast("../examples/fibonacci.ir");
+        backend::compile(root, output, { .threads = 2 });
+    }
+
+    const auto events = recorded.events();
+
+    size_t function_spans = 0;
+    size_t codegen_spans = 0;
+
+    for (const auto &event : events) {
+        debug::assert(event.end >= event.start, "trace_test: span ends before it starts");
+
+        if (std::string_view { event.category } == "phase" && event.name == "codegen")
+            codegen_spans++;
+
+        if (!event.details)
+            continue;
+
+        function_spans++;
+
+        // fib has its entry, the base case and the recursive case
+        if (event.name == "fib")
+            debug::assert(event.details->blocks == 3 && event.details->instructions > 0, "trace_test: wrong details for fib");
+    }
+
+    debug::assert(function_spans == 2, "trace_test: expected a span for both functions");
+    debug::assert(codegen_spans == 2, "trace_test: expected a codegen span for both functions");
+
+    std::stringstream json;
+    recorded.write_json(json);
+
+    debug::assert(json.str().starts_with("{\"traceEvents\":["), "trace_test: unexpected json");
+    debug::assert(json.str().find("\"args\":{\"function\":\"fib\",\"blocks\":3,") != std::string::npos,
+                  "trace_test: function details missing from json");
+
+    auto root = backend::gen_ast("../examples/fibonacci.ir");
+    backend::compile(root, output);
+
+    debug::assert(recorded.events().size() == events.size(), "trace_test: recorded outside of a trace scope");
+}
+
+void run_instrumentation_tests() {
+    test_phases_recorded();
+    test_trace_recorded();
+
+    std::cout << "Instrumentation Tests Passed" << '\n';
+}
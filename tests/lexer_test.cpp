@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include "../src/ir/input/lexer.hpp"
 #include "../src/debug/assert.hpp"
 
@@ -44,10 +45,54 @@ void lexer_test0() {
     });
 }
 
+void lexer_test1() {
+    using enum ir::lexer::token_type;
+
+    expect_lex("ret %x ; trailing comment\njmp x", std::vector<ir::lexer::token> {
+        { identifier, "ret" },
+        { symbol, "%" },
+        { identifier, "x" },
+        { break_line, "\n" },
+        { identifier, "jmp" },
+        { identifier, "x" }
+    });
+
+    ir::lexer::identifier_table identifiers;
+    const auto output = ir::lexer::lex("jmp x\njmp x", identifiers);
+
+    debug::assert(identifiers.names.size() == 2, "lexer_test1: identifiers not interned");
+    debug::assert(output[0].id == output[3].id && output[1].id == output[4].id,
+                  "lexer_test1: equal identifiers have different ids");
+}
+
+void lexer_test2() {
+    // Runs long enough to cross the classifier's block boundaries
+    std::string input;
+
+    for (int i = 0; i < 16; i++) {
+        input.append("%a_rather_long_identifier_name").append(std::to_string(i))
+             .append(" = add i64 %x, i64 1234567890\t; comment\n\n")
+             .append("    global_string %msg = \"Hello, World!\"\r\n");
+    }
+
+    ir::lexer::identifier_table scalar_identifiers;
+    const auto expected = ir::lexer::lex(input, scalar_identifiers, ir::lexer::simd::isa::scalar);
+
+    for (auto isa : { ir::lexer::simd::isa::sse2, ir::lexer::simd::isa::avx2 }) {
+        if (!ir::lexer::simd::isa_supported(isa))
+            continue;
+
+        ir::lexer::identifier_table identifiers;
+        compare_lex(ir::lexer::lex(input, identifiers, isa), expected);
+    }
+}
+
 // TODO: More Lexer Tests
 
 void run_lexer_tests() {
     lexer_test0();
+    lexer_test1();
+    lexer_test2();
 
     std::cout << "Lexer tests complete.\n";
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+/// Idea: A variable live around a loop back-edge must not be dropped at its textually last use
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+#include "../src/backend/ir_analyzer/ir_analyzer.hpp"
+
+void test_loop_liveness() {
+    const std::string input =
+        "define fn i32 count(i32 %n)\n"
+        "    %i = allocate 4\n"
+        "    store i32 ptr %i, i32 0\n"
+        "    jmp loop\n"
+        ".loop:\n"
+        "    %1 = load i32 ptr %i\n"
+        "    %2 = icmp slt i32 %1, i32 %n\n"
+        "    branch body exit i1 %2\n"
+        ".body:\n"
+        "    %3 = add i32 %1, i32 1\n"
+        "    store i32 ptr %i, i32 %3\n"
+        "    jmp loop\n"
+        ".exit:\n"
+        "    ret i32 %1\n"
+        "end\n";
+
+    auto tokens = ir::lexer::lex(input);
+    auto root = ir::parser::parse(tokens);
+    auto &function = root.functions.front();
+
+    backend::md::analyze_function(function);
+
+    const auto n = *function.symbols.find("n");
+    const auto i = *function.symbols.find("i");
+
+    const auto &compare = function.blocks[1].instructions[1];
+    debug::assert(compare.operands[1].get_id() == n.id, "liveness_test: unexpected operand");
+    debug::assert(!compare.metadata.dropped_data[1], "liveness_test: %n dropped inside the loop");
+
+    const auto &store = function.blocks[2].instructions[1];
+    debug::assert(!store.metadata.dropped_data[0], "liveness_test: %i dropped inside the loop");
+
+    const auto &back_edge = function.blocks[2].instructions.back().metadata.dropped_after;
+    const auto dropped_at_back_edge = [&](ir::symbol symbol) {
+        return std::find(back_edge.begin(), back_edge.end(), symbol.id) != back_edge.end();
+    };
+
+    debug::assert(dropped_at_back_edge(n), "liveness_test: %n not dropped after the back-edge");
+    debug::assert(dropped_at_back_edge(i), "liveness_test: %i not dropped after the back-edge");
+
+    const auto &exit = function.blocks[3].instructions.back();
+    debug::assert(exit.metadata.dropped_data[0], "liveness_test: %1 not dropped at its last use");
+}
+
+void run_liveness_tests() {
+    test_loop_liveness();
+
+    std::cout << "Liveness Tests Passed" << '\n';
+}
@@ -1,4 +1,15 @@
+/// Idea: Passes run in the order their pipeline lists them, analyses are kept until a transform
+/// changes the function, and every run is measured when statistics are asked for
+
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "../src/backend/interface.hpp"
+#include "../src/exec/jit.hpp"
 
 #include "test_utils.cpp"
 
@@ -38,8 +49,275 @@ void assert_dead_code_eliminated(std::string_view file_name, int branch_delta =
     }
 }
 
+// Whether @name is assigned to anywhere in @function
+bool defines(const ir::global::function &function, std::string_view name) {
+    for (const auto &block : function.blocks) {
+        for (const auto &instruction : block.instructions) {
+            if (instruction.assigned_to && function.symbols.name(instruction.assigned_to->name) == name)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+void test_dead_instructions_removed() {
+    constexpr const char *file_path = "../examples/optimizer/dead_instructions.ir";
+
+    auto ast = backend::gen_ast(file_path);
+    auto &main = ast.functions.front();
+
+    debug::assert(backend::opt::fn_dead_code_elim(main), "dce_test: nothing removed");
+    debug::assert(!backend::opt::fn_dead_code_elim(main), "dce_test: fixed point not reached in one run");
+
+    for (const auto *name : { "unused_slot", "unused_literal", "unused_load", "chain", "chain_end", "stop" })
+        debug::assert(!defines(main, name), std::string("dce_test: dead value kept: ").append(name).c_str());
+
+    // The call's result is unused but the call itself has to happen, and the store is read
+    for (const auto *name : { "slot", "five", "loaded", "ignored", "sum", "result" })
+        debug::assert(defines(main, name), std::string("dce_test: live value removed: ").append(name).c_str());
+
+    // The two orphans jump to each other, so both are named by a label but neither is reachable
+    debug::assert(main.blocks.size() == 2, "dce_test: unreachable cycle kept");
+
+    const auto &phi = main.blocks.back().instructions.front();
+    debug::assert(phi.type() == ir::block::node_type::phi && phi.operands.size() == 1,
+                  "dce_test: phi kept the edge from a removed block");
+
+    debug::assert(exec::run_jit(file_path) == 10, "dce_test: wrong result after optimizing");
+}
+
+void test_constant_folding() {
+    using namespace backend::opt;
+    using ir::value_size;
+
+    // Results wrap around at the width of the operands
+    debug::assert(fold_arithmetic(ir::block::add, value_size::i8, 200, 100) == 44, "fold_test: i8 add didn't wrap");
+    debug::assert(fold_arithmetic(ir::block::sub, value_size::i8, 44, 60) == 240, "fold_test: i8 sub didn't wrap");
+    debug::assert(fold_arithmetic(ir::block::mul, value_size::i16, 300, 300) == 24464, "fold_test: i16 mul didn't wrap");
+    debug::assert(fold_arithmetic(ir::block::add, value_size::i64, UINT64_MAX, 1) == 0, "fold_test: i64 add didn't wrap");
+    debug::assert(fold_arithmetic(ir::block::add, value_size::i1, 1, 1) == 0, "fold_test: i1 add didn't wrap");
+
+    // Division is signed and rounds towards zero, and is left alone where it would trap
+    debug::assert(fold_arithmetic(ir::block::div, value_size::i32, truncate(-7, value_size::i32), 2) == truncate(-3, value_size::i32),
+                  "fold_test: wrong signed division");
+    debug::assert(fold_arithmetic(ir::block::mod, value_size::i32, truncate(-7, value_size::i32), 2) == truncate(-1, value_size::i32),
+                  "fold_test: wrong signed remainder");
+    debug::assert(!fold_arithmetic(ir::block::div, value_size::i32, 1, 0), "fold_test: division by zero folded");
+    debug::assert(!fold_arithmetic(ir::block::div, value_size::i8, 128, 255), "fold_test: overflowing division folded");
+
+    debug::assert(fold_icmp(ir::block::slt, value_size::i8, 240, 0), "fold_test: i8 compared unsigned");
+    debug::assert(!fold_icmp(ir::block::ult, value_size::i8, 240, 0), "fold_test: i8 compared signed");
+    debug::assert(!fold_icmp(ir::block::sge, value_size::i32, UINT32_MAX, 0), "fold_test: i32 compared unsigned");
+    debug::assert(fold_icmp(ir::block::ule, value_size::i64, 5, 5) && !fold_icmp(ir::block::neq, value_size::i64, 5, 5),
+                  "fold_test: wrong comparison of equal values");
+
+    debug::assert(fold_sext(0xF0, value_size::i8, value_size::i32) == 0xFFFFFFF0, "fold_test: sext didn't extend the sign");
+    debug::assert(fold_sext(1, value_size::i1, value_size::i8) == 0xFF, "fold_test: i1 sext didn't extend the sign");
+    debug::assert(fold_zext(0xF0, value_size::i8, value_size::i64) == 0xF0, "fold_test: zext extended the sign");
+}
+
+void test_constant_propagation() {
+    constexpr const char *file_path = "../examples/optimizer/constants.ir";
+
+    auto ast = backend::gen_ast(file_path);
+    auto &main = ast.functions.front();
+
+    backend::opt::optimize_function(main, backend::opt::pipeline({ .optimization = backend::opt_level::O1 }));
+
+    // The branch only ever goes one way, so the other arm and the phi's edge from it are gone
+    debug::assert(main.blocks.size() == 3, "sccp_test: untaken branch arm kept");
+
+    for (const auto *name : { "wrapped", "is_negative", "picked", "never", "result", "total" })
+        debug::assert(!defines(main, name), std::string("sccp_test: constant not folded: ").append(name).c_str());
+
+    for (const auto &block : main.blocks) {
+        debug::assert(block.instructions.back().type() != ir::block::node_type::branch, "sccp_test: constant branch kept");
+    }
+
+    const auto &sum = main.blocks.back().instructions[1];
+    debug::assert(sum.operands[0].is_literal() && sum.operands[0].lit().value == 224, "sccp_test: folded value not used");
+
+    debug::assert(exec::run_jit(file_path) == 227, "sccp_test: wrong result after optimizing");
+
+    // Phis reading themselves around a loop are still the constant they start as
+    auto loop_ast = backend::gen_ast("../examples/optimizer/loop_constants.ir");
+    auto &count = loop_ast.functions.front();
+
+    debug::assert(backend::opt::propagate_constants(count, backend::opt::control_flow { count }), "sccp_test: loop not folded");
+    backend::opt::fn_dead_code_elim(count);
+
+    debug::assert(!defines(count, "step") && !defines(count, "limit"), "sccp_test: loop invariant phi kept");
+    debug::assert(defines(count, "i") && defines(count, "more"), "sccp_test: loop counter folded");
+
+    const auto &ret = count.blocks.back().instructions.back();
+    debug::assert(ret.operands[0].get_id() == count.symbols.intern("next").id, "sccp_test: select on a constant kept");
+}
+
+void test_pipelines() {
+    using backend::opt_level;
+
+    const auto names = [](const backend::compile_options &options) {
+        std::string joined;
+
+        for (const auto *pass : backend::opt::pipeline(options))
+            joined.append(pass->name).append(" ");
+
+        return joined;
+    };
+
+    debug::assert(names({ .optimization = opt_level::O0 }).empty(), "pass_test: -O0 runs passes");
+    debug::assert(names({ .optimization = opt_level::O1 }) == "sccp unreachable dce ", "pass_test: wrong -O1 pipeline");
+    debug::assert(names({ .optimization = opt_level::O2 }) == "mem2reg sccp unreachable dce ", "pass_test: wrong -O2 pipeline");
+    debug::assert(names({ .optimization = opt_level::O0, .passes = { "dce", "cfg" } }) == "dce cfg ",
+                  "pass_test: listed passes not run in order instead of the level's");
+
+    bool threw = false;
+
+    try {
+        (void) backend::opt::pipeline({ .passes = { "missing" } });
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+
+    debug::assert(threw, "pass_test: unknown pass accepted");
+}
+
+void test_control_flow() {
+    auto ast = backend::gen_ast("../examples/optimizer/dead_code_elim.ir");
+    const backend::opt::control_flow flow { ast.functions.front() };
+
+    // entry, true_branch, false_branch, dead_branch, end
+    debug::assert(flow.successors[0] == std::vector<size_t> { 1, 2 }, "pass_test: wrong branch successors");
+    debug::assert(flow.predecessors[4] == std::vector<size_t> { 1, 2, 3 }, "pass_test: wrong join predecessors");
+    debug::assert(flow.predecessors[3].empty() && flow.successors[4].empty(), "pass_test: edges into dead code or out of a ret");
+}
+
+void test_dominators() {
+    auto ast = backend::gen_ast("../examples/optimizer/stack_slots.ir");
+    const backend::opt::control_flow flow { ast.functions.front() };
+    const backend::opt::dominators tree { flow };
+
+    // entry, loop, body, low, high, next, done
+    debug::assert(tree.immediate == std::vector<size_t> { SIZE_MAX, 0, 1, 2, 2, 2, 1 }, "dom_test: wrong immediate dominators");
+
+    auto branch_children = tree.children[2];
+    std::ranges::sort(branch_children);
+    debug::assert(branch_children == std::vector<size_t> { 3, 4, 5 }, "dom_test: wrong dominator tree");
+
+    // Both arms join in next, and everything inside the loop joins back into its header
+    debug::assert(tree.frontier[3] == std::vector<size_t> { 5 } && tree.frontier[4] == std::vector<size_t> { 5 },
+                  "dom_test: wrong frontier of a branch arm");
+    debug::assert(tree.frontier[5] == std::vector<size_t> { 1 } && tree.frontier[1] == std::vector<size_t> { 1 },
+                  "dom_test: wrong frontier inside a loop");
+    debug::assert(tree.frontier[0].empty() && tree.frontier[6].empty(), "dom_test: frontier outside the loop");
+}
+
+void test_promote_allocations() {
+    constexpr const char *file_path = "../examples/optimizer/stack_slots.ir";
+
+    auto ast = backend::gen_ast(file_path);
+    auto &main = ast.functions.front();
+    backend::opt::function_analyses analyses { main };
+
+    backend::opt::run_passes(main, analyses, std::array { backend::opt::find_pass("mem2reg") });
+
+    for (const auto *name : { "counter", "total", "i", "before", "current", "sum" })
+        debug::assert(!defines(main, name), std::string("mem2reg_test: access not promoted: ").append(name).c_str());
+
+    // Its address is passed to a call, so it has to stay in memory
+    debug::assert(defines(main, "escaped") && defines(main, "extra"), "mem2reg_test: escaping allocation promoted");
+
+    size_t loads = 0, stores = 0;
+
+    for (const auto &block : main.blocks) {
+        for (const auto &instruction : block.instructions) {
+            loads += instruction.type() == ir::block::node_type::load;
+            stores += instruction.type() == ir::block::node_type::store;
+        }
+    }
+
+    debug::assert(loads == 1 && stores == 0, "mem2reg_test: promoted load or store kept");
+
+    // Phis go where the stored values join, the loop header for both and the end of the branch for the total
+    debug::assert(defines(main, "counter_loop") && defines(main, "total_loop") && defines(main, "total_next"),
+                  "mem2reg_test: phi missing at a join");
+    debug::assert(!defines(main, "counter_next"), "mem2reg_test: phi placed where only one value reaches");
+
+    const auto &header = main.blocks[1].instructions.front();
+    debug::assert(header.type() == ir::block::node_type::phi && header.operands[0].is_literal()
+                  && header.operands[0].lit().value == 0, "mem2reg_test: value stored before the loop not used");
+
+    debug::assert(!backend::opt::promote_allocations(main, analyses.cfg(), analyses.dominator_tree()),
+                  "mem2reg_test: fixed point not reached in one run");
+
+    for (auto mode : { backend::regalloc_mode::greedy, backend::regalloc_mode::linear, backend::regalloc_mode::coloring }) {
+        auto root = backend::gen_ast(file_path);
+        const exec::jit_module module { backend::assemble(root, { .regalloc = mode, .optimization = backend::opt_level::O2 }) };
+
+        debug::assert(module.function<int()>("main")() == 125, "mem2reg_test: wrong result after promoting");
+    }
+}
+
+void test_analysis_invalidation() {
+    const backend::opt::pass *cfg = backend::opt::find_pass("cfg");
+    const backend::opt::pass *unreachable = backend::opt::find_pass("unreachable");
+    const backend::opt::pass *dce = backend::opt::find_pass("dce");
+
+    auto ast = backend::gen_ast("../examples/optimizer/dead_code_elim.ir");
+    auto &function = ast.functions.front();
+    backend::opt::function_analyses analyses { function };
+
+    backend::opt::run_passes(function, analyses, std::array { cfg });
+    debug::assert(analyses.is_valid(backend::opt::analysis::control_flow), "pass_test: analysis pass computed nothing");
+
+    // Removing the dead block changes the graph, running again changes nothing
+    backend::opt::run_passes(function, analyses, std::array { unreachable });
+    debug::assert(!analyses.is_valid(backend::opt::analysis::control_flow), "pass_test: stale analysis kept");
+
+    backend::opt::run_passes(function, analyses, std::array { cfg, unreachable });
+    debug::assert(analyses.is_valid(backend::opt::analysis::control_flow), "pass_test: analysis dropped without a change");
+
+    // Removing an instruction which isn't a terminator leaves the graph as it was
+    auto dead_ast = backend::gen_ast("../examples/optimizer/dead_instructions.ir");
+    auto &dead_function = dead_ast.functions.front();
+    backend::opt::function_analyses dead_analyses { dead_function };
+
+    backend::opt::run_passes(dead_function, dead_analyses, std::array { cfg, dce });
+    debug::assert(dead_analyses.is_valid(backend::opt::analysis::control_flow), "pass_test: preserved analysis dropped");
+}
+
+void test_pass_statistics() {
+    backend::opt::pass_statistics statistics;
+    auto ast = backend::gen_ast("../examples/optimizer/dead_code_elim.ir");
+
+    std::stringstream output;
+    backend::compile(ast, output, { .pass_statistics = &statistics });
+
+    const auto unreachable = statistics.totals("unreachable");
+
+    debug::assert(unreachable.runs == 1 && unreachable.changes == 1, "pass_test: pass run not recorded");
+    debug::assert(unreachable.blocks == -1 && unreachable.instructions == -1, "pass_test: wrong change in IR size");
+    debug::assert(statistics.totals("dce").runs == 1 && statistics.totals("dce").changes == 0,
+                  "pass_test: pass without changes recorded as changing");
+    debug::assert(output.str().find("dead_branch") == std::string::npos, "pass_test: compile did not optimize");
+
+    std::stringstream table;
+    statistics.write_table(table);
+    debug::assert(table.str().find("unreachable") != std::string::npos, "pass_test: pass missing from the table");
+}
+
 void run_optimization_tests() {
     assert_dead_code_eliminated("../examples/optimizer/dead_code_elim.ir", 1);
+    test_dead_instructions_removed();
+    test_constant_folding();
+    test_constant_propagation();
+    test_pipelines();
+    test_control_flow();
+    test_dominators();
+    test_promote_allocations();
+    test_analysis_invalidation();
+    test_pass_statistics();
 
     std::cout << "Optimization Tests Passed" << '\n';
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+/// Idea: Compiling functions on several threads should produce the same code as compiling them in order
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "../src/backend/interface.hpp"
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+
+void test_parallel_consistency(std::string_view file_path) {
+    std::stringstream serial, parallel;
+
+    backend::compile(file_path, serial);
+    backend::compile(file_path, parallel, { .threads = 4 });
+
+    if (serial.str() != parallel.str()) {
+        std::cerr << "Parallel Inconsistency Found for " << file_path << '\n';
+        std::cout << serial.str() << '\n' << parallel.str() << '\n';
+        std::exit(1);
+    }
+}
+
+// Many small functions, so that every thread generates several of them
+void test_parallel_many_functions() {
+    std::string input;
+
+    for (int i = 0; i < 64; i++) {
+        const auto name = "fn" + std::to_string(i);
+
+        input += "define fn i32 " + name + "(i32 %n)\n"
+                 "    %1 = add i32 %n, i32 " + std::to_string(i) + "\n"
+                 "    %2 = mul i32 %1, i32 %n\n"
+                 "    ret i32 %2\n"
+                 "end\n\n";
+    }
+
+    auto serial_tokens = ir::lexer::lex(input);
+    auto parallel_tokens = ir::lexer::lex(input);
+    auto serial_ast = ir::parser::parse(serial_tokens);
+    auto parallel_ast = ir::parser::parse(parallel_tokens);
+
+    std::stringstream serial, parallel;
+
+    backend::compile(serial_ast, serial);
+    backend::compile(parallel_ast, parallel, { .threads = 8 });
+
+    if (serial.str() != parallel.str()) {
+        std::cerr << "Parallel Inconsistency Found for generated module" << '\n';
+        std::exit(1);
+    }
+}
+
+void run_parallel_tests() {
+    test_parallel_consistency("../examples/arith_select_test.ir");
+    test_parallel_consistency("../examples/cast_test.ir");
+    test_parallel_consistency("../examples/fibonacci.ir");
+    test_parallel_consistency("../examples/hello_world.ir");
+    test_parallel_consistency("../examples/pointer_test.ir");
+    test_parallel_consistency("../examples/select_test.ir");
+    test_parallel_many_functions();
+
+    std::cout << "Parallel Tests Passed" << '\n';
+}
@@ -0,0 +1,180 @@
+/// Idea: The ahead of time allocators must never give two variables the same register while both are live,
+/// and compiling with them should work wherever the greedy allocator does
+
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+#include "../src/backend/interface.hpp"
+#include "../src/backend/ir_analyzer/ir_analyzer.hpp"
+#include "../src/backend/codegen/regalloc/graph_coloring.hpp"
+#include "../src/backend/codegen/regalloc/linear_scan.hpp"
+
+void assert_no_register_conflicts(const ir::global::function &function,
+                                  const backend::regalloc::allocation &allocation) {
+    const auto &ranges = function.metadata->live_ranges;
+    std::map<std::pair<uint32_t, backend::context::register_t>, ir::symbol_id> holders;
+
+    for (ir::symbol_id id = 0; id < ranges.size(); id++) {
+        // A variable dying at an instruction may hand its register to the one defined there
+        for (auto position = ranges[id].start; position < ranges[id].end; position++) {
+            const auto *segment = allocation.segment_at(id, position);
+
+            if (!segment || !segment->reg)
+                continue;
+
+            const auto [holder, inserted] = holders.try_emplace({ position, *segment->reg }, id);
+
+            const auto debug_fail = [&]() {
+                return std::string("regalloc_test: %").append(function.symbols.name(id))
+                    .append(" and %").append(function.symbols.name(holder->second))
+                    .append(" share a register in ").append(function.name);
+            };
+
+            debug::assert(inserted, debug_fail().c_str());
+        }
+    }
+}
+
+void test_allocators(std::string_view file_path) {
+    auto root = backend::gen_ast(file_path);
+    backend::analyze_ir(root);
+
+    for (const auto &function : root.functions) {
+        assert_no_register_conflicts(function, backend::regalloc::linear_scan(function));
+        assert_no_register_conflicts(function, backend::regalloc::graph_coloring(function));
+    }
+
+    for (auto mode : { backend::regalloc_mode::linear, backend::regalloc_mode::coloring }) {
+        std::stringstream output;
+        backend::compile(file_path, output, backend::compile_options { .regalloc = mode });
+    }
+}
+
+ir::root parse_function(const std::string &input) {
+    auto tokens = ir::lexer::lex(input);
+    auto root = ir::parser::parse(tokens);
+
+    backend::md::analyze_function(root.functions.front());
+    return root;
+}
+
+std::optional<backend::context::register_t> register_at(const ir::global::function &function,
+                                                        const backend::regalloc::allocation &allocation,
+                                                        const char *name, uint32_t position) {
+    const auto *segment = allocation.segment_at(function.symbols.find(name)->id, position);
+
+    return segment ? segment->reg : std::nullopt;
+}
+
+// More values live across a call than there are callee saved registers
+void test_linear_scan_pressure() {
+    std::string input = "extern fn i32 g(i32 %x)\n\ndefine fn i32 main()\n    %p = allocate 64\n";
+
+    for (int i = 0; i < 8; i++)
+        input.append("    %v").append(std::to_string(i)).append(" = load i32 ptr %p\n");
+
+    input.append("    %c = call i32 g i32 %v0\n");
+
+    std::string sum = "%c";
+
+    for (int i = 0; i < 8; i++) {
+        input.append("    %s").append(std::to_string(i)).append(" = add i32 ").append(sum)
+            .append(", i32 %v").append(std::to_string(i)).append("\n");
+        sum = std::string("%s").append(std::to_string(i));
+    }
+
+    input.append("    ret i32 ").append(sum).append("\nend\n");
+
+    auto root = parse_function(input);
+    const auto &function = root.functions.front();
+    const auto allocation = backend::regalloc::linear_scan(function);
+
+    assert_no_register_conflicts(function, allocation);
+
+    const auto call_position = 10;
+    size_t kept_across_call = 0;
+
+    for (int i = 0; i < 8; i++) {
+        const auto reg = register_at(function, allocation, std::string("v").append(std::to_string(i)).c_str(), call_position);
+
+        if (!reg)
+            continue;
+
+        debug::assert(*reg == backend::context::rbx || *reg >= backend::context::r12,
+                      "regalloc_test: value live across a call kept in a caller saved register");
+        kept_across_call++;
+    }
+
+    debug::assert(kept_across_call == 5, "regalloc_test: callee saved registers left unused");
+}
+
+// An arithmetic result overwrites its dying lhs in place, so the two should be coalesced
+void test_coloring_coalesces() {
+    auto root = parse_function(
+        "define fn i32 main(ptr %p)\n"
+        "    %a = load i32 ptr %p\n"
+        "    %b = add i32 %a, i32 1\n"
+        "    %c = mul i32 %b, i32 3\n"
+        "    ret i32 %c\n"
+        "end\n");
+
+    const auto &function = root.functions.front();
+    const auto allocation = backend::regalloc::graph_coloring(function);
+
+    assert_no_register_conflicts(function, allocation);
+
+    const auto a = register_at(function, allocation, "a", 1);
+    const auto b = register_at(function, allocation, "b", 2);
+    const auto c = register_at(function, allocation, "c", 3);
+
+    debug::assert(a && a == b && b == c, "regalloc_test: arithmetic chain was not coalesced");
+}
+
+// As many values live at once as there are allocatable registers, without a call in between
+void test_coloring_pressure() {
+    constexpr int count = 14;
+    std::string input = "define fn i32 main(ptr %p)\n";
+
+    for (int i = 0; i < count; i++)
+        input.append("    %v").append(std::to_string(i)).append(" = load i32 ptr %p\n");
+
+    std::string sum = "%v0";
+
+    for (int i = 1; i < count; i++) {
+        input.append("    %s").append(std::to_string(i)).append(" = add i32 ").append(sum)
+            .append(", i32 %v").append(std::to_string(i)).append("\n");
+        sum = std::string("%s").append(std::to_string(i));
+    }
+
+    input.append("    ret i32 ").append(sum).append("\nend\n");
+
+    auto root = parse_function(input);
+    const auto &function = root.functions.front();
+    const auto allocation = backend::regalloc::graph_coloring(function);
+
+    assert_no_register_conflicts(function, allocation);
+
+    for (int i = 0; i < count; i++) {
+        debug::assert(register_at(function, allocation, std::string("v").append(std::to_string(i)).c_str(), count).has_value(),
+                      "regalloc_test: value spilled although a register was free");
+    }
+}
+
+void run_regalloc_tests() {
+    test_allocators("../examples/arith_select_test.ir");
+    test_allocators("../examples/cast_test.ir");
+    test_allocators("../examples/fibonacci.ir");
+    test_allocators("../examples/hello_world.ir");
+    test_allocators("../examples/pointer_test.ir");
+    test_allocators("../examples/select_test.ir");
+    test_allocators("../examples/stack_args_test.ir");
+    test_linear_scan_pressure();
+    test_coloring_coalesces();
+    test_coloring_pressure();
+
+    std::cout << "Register Allocation Tests Passed" << '\n';
+}
@@ -0,0 +1,51 @@
+/// Idea: Register saves should only be executed on the paths that clobber the saved registers,
+/// so the base case of fib returns without touching the stack
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../src/backend/interface.hpp"
+
+// The instructions of block @label in @function, up to the next label
+std::string block_text(const std::string &assembly, std::string_view function, std::string_view label) {
+    const auto function_start = assembly.find(std::string(function).append(":\n"));
+    debug::assert(function_start != std::string::npos, "shrink_wrap_test: function not found");
+
+    const auto label_start = assembly.find(std::string(".").append(label).append(":\n"), function_start);
+    debug::assert(label_start != std::string::npos, "shrink_wrap_test: label not found");
+
+    const auto body_start = assembly.find('\n', label_start) + 1;
+    auto body_end = assembly.find("\n.", body_start);
+
+    return assembly.substr(body_start, body_end == std::string::npos ? std::string::npos : body_end - body_start);
+}
+
+void test_fib_base_case_saves_nothing(backend::regalloc_mode mode) {
+    std::stringstream output;
+    backend::compile("../examples/fibonacci.ir", output, backend::compile_options { .regalloc = mode });
+
+    const auto assembly = output.str();
+
+    for (const auto *label : { "__stacksave", "entry", "base_case" }) {
+        const auto text = block_text(assembly, "fib", label);
+
+        debug::assert(text.find("push") == std::string::npos && text.find("pop") == std::string::npos,
+                      "shrink_wrap_test: registers saved on the base case path of fib");
+    }
+
+    const auto recursive_case = block_text(assembly, "fib", "recursive_case");
+
+    debug::assert(recursive_case.find("push") < recursive_case.find("call"),
+                  "shrink_wrap_test: registers not saved before the recursive calls of fib");
+    debug::assert(recursive_case.find("pop") != std::string::npos,
+                  "shrink_wrap_test: registers not restored in the recursive case of fib");
+}
+
+void run_shrink_wrap_tests() {
+    test_fib_base_case_saves_nothing(backend::regalloc_mode::greedy);
+    test_fib_base_case_saves_nothing(backend::regalloc_mode::linear);
+    test_fib_base_case_saves_nothing(backend::regalloc_mode::coloring);
+
+    std::cout << "Shrink Wrap Tests Passed" << '\n';
+}
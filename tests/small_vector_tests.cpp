@@ -0,0 +1,48 @@
+/// Idea: A small_vector should behave like a std::vector whether its elements are inline or spilled to the heap
+
+#include <iostream>
+
+#include "../src/ir/small_vector.hpp"
+#include "../src/debug/assert.hpp"
+
+void test_small_vector_spill() {
+    ir::small_vector<int, 2> numbers { 0, 1 };
+
+    for (int i = 2; i < 100; i++)
+        numbers.push_back(numbers[i - 1] + 1);
+
+    debug::assert(numbers.size() == 100, "small_vector_test: wrong size after spilling");
+
+    for (int i = 0; i < 100; i++)
+        debug::assert(numbers[i] == i, "small_vector_test: element lost while spilling");
+
+    numbers.erase(numbers.begin() + 10, numbers.begin() + 20);
+    debug::assert(numbers.size() == 90 && numbers[10] == 20, "small_vector_test: erase did not shift elements");
+}
+
+void test_small_vector_copy_and_move() {
+    ir::small_vector<int, 4> inline_numbers { 1, 2, 3 };
+    ir::small_vector<int, 4> spilled { 1, 2, 3, 4, 5, 6 };
+
+    auto inline_copy = inline_numbers;
+    auto spilled_copy = spilled;
+
+    auto inline_moved = std::move(inline_numbers);
+    auto spilled_moved = std::move(spilled);
+
+    debug::assert(inline_copy.size() == 3 && inline_moved.size() == 3 && inline_moved.back() == 3,
+                  "small_vector_test: inline copy or move failed");
+    debug::assert(spilled_copy.size() == 6 && spilled_moved.size() == 6 && spilled_moved.back() == 6,
+                  "small_vector_test: spilled copy or move failed");
+    debug::assert(spilled.empty(), "small_vector_test: moved from vector not empty");
+
+    spilled_copy = inline_copy;
+    debug::assert(spilled_copy.size() == 3 && spilled_copy[2] == 3, "small_vector_test: copy assignment failed");
+}
+
+void run_small_vector_tests() {
+    test_small_vector_spill();
+    test_small_vector_copy_and_move();
+
+    std::cout << "Small Vector Tests Passed" << '\n';
+}
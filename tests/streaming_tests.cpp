@@ -0,0 +1,46 @@
+/// Idea: Compiling a file in streaming mode should produce the same code as compiling it as a whole
+
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+#include "../src/backend/interface.hpp"
+
+// Streaming output only switches sections when needed, so empty sections are not emitted
+std::string strip_sections(const std::string &assembly) {
+    std::stringstream input { assembly };
+    std::string stripped, line;
+
+    while (std::getline(input, line)) {
+        if (line.starts_with("section "))
+            continue;
+
+        stripped.append(line).push_back('\n');
+    }
+
+    return stripped;
+}
+
+void test_streaming_consistency(std::string_view file_path) {
+    std::stringstream whole, streamed;
+
+    backend::compile(file_path, whole);
+    backend::compile_streaming(file_path, streamed);
+
+    if (strip_sections(whole.str()) != strip_sections(streamed.str())) {
+        std::cerr << "Streaming Inconsistency Found for " << file_path << '\n';
+        std::cout << whole.str() << '\n' << streamed.str() << '\n';
+        std::exit(1);
+    }
+}
+
+void run_streaming_tests() {
+    test_streaming_consistency("../examples/arith_select_test.ir");
+    test_streaming_consistency("../examples/cast_test.ir");
+    test_streaming_consistency("../examples/fibonacci.ir");
+    test_streaming_consistency("../examples/hello_world.ir");
+    test_streaming_consistency("../examples/pointer_test.ir");
+    test_streaming_consistency("../examples/select_test.ir");
+
+    std::cout << "Streaming Tests Passed" << '\n';
+}
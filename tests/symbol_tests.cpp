@@ -0,0 +1,57 @@
+/// Idea: Names within a function should be interned to dense ids which stay valid as the AST is moved around
+
+#include <iostream>
+#include <string>
+
+#include "../src/ir/input/lexer.hpp"
+#include "../src/ir/input/parser.hpp"
+
+void test_function_symbols() {
+    const std::string input =
+        "define fn i32 fib(i32 %n)\n"
+        "    %1 = icmp ule i32 %n, i32 1\n"
+        "    branch base_case recursive_case i1 %1\n"
+        ".base_case:\n"
+        "    ret i32 %n\n"
+        ".recursive_case:\n"
+        "    %2 = sub i32 %n, i32 1\n"
+        "    ret i32 %2\n"
+        "end\n";
+
+    auto tokens = ir::lexer::lex(input);
+    auto parsed = ir::parser::parse(tokens);
+
+    // Moving the root must not invalidate the views symbols hold into their table
+    auto root = std::move(parsed);
+    const auto &function = root.functions.front();
+
+    const auto n = function.parameters.front().name;
+    debug::assert(function.symbols.name(n) == "n", "symbol_test: parameter name lost");
+    debug::assert(function.symbols.find("n") == n, "symbol_test: parameter not interned");
+
+    for (const auto &block : function.blocks) {
+        debug::assert(block.name.id < function.symbols.size(), "symbol_test: block id out of range");
+
+        for (const auto &instruction : block.instructions) {
+            for (const auto &operand : instruction.operands) {
+                if (!operand.is_variable())
+                    continue;
+
+                debug::assert(operand.get_id() < function.symbols.size(), "symbol_test: variable id out of range");
+                debug::assert(function.symbols.find(function.symbols.name(operand.get_id()))->id == operand.get_id(),
+                              "symbol_test: id does not match name");
+            }
+        }
+    }
+
+    const auto &branch = function.blocks.front().instructions.back();
+    debug::assert(branch.labels_referenced.size() == 2, "symbol_test: branch labels not referenced");
+    debug::assert(branch.labels_referenced[0] == function.blocks[1].name || branch.labels_referenced[1] == function.blocks[1].name,
+                  "symbol_test: label reference does not match block");
+}
+
+void run_symbol_tests() {
+    test_function_symbols();
+
+    std::cout << "Symbol Tests Passed" << '\n';
+}
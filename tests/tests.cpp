@@ -1,12 +1,37 @@
 #include "lexer_test.cpp"
+#include "symbol_tests.cpp"
+#include "small_vector_tests.cpp"
+#include "liveness_tests.cpp"
+#include "regalloc_tests.cpp"
+#include "shrink_wrap_tests.cpp"
+#include "calling_convention_tests.cpp"
+#include "encoder_tests.cpp"
+#include "elf_writer_tests.cpp"
+#include "compile_cache_tests.cpp"
+#include "instrumentation_tests.cpp"
 #include "parser_consistency_tests.cpp"
 #include "execution_tests.cpp"
 #include "optimization_tests.cpp"
+#include "streaming_tests.cpp"
+#include "parallel_tests.cpp"
 
 void run_tests() {
     std::cout << "Running tests...\n";
 
     run_lexer_tests();
+    run_symbol_tests();
+    run_small_vector_tests();
+    run_liveness_tests();
+    run_regalloc_tests();
+    run_shrink_wrap_tests();
+    run_calling_convention_tests();
+    run_encoder_tests();
+    run_elf_writer_tests();
+    run_compile_cache_tests();
+    run_instrumentation_tests();
+    run_optimization_tests();
+    run_streaming_tests();
+    run_parallel_tests();
     run_exec_tests();
 
     std::cout << "Tests complete.\n";